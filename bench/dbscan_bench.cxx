@@ -0,0 +1,814 @@
+#include "DBSCAN/DBSCAN.h"
+#ifdef DBSCAN_WITH_DAEMON
+#include "DBSCAN/DBSCANDaemon.h"
+#endif
+#include "DBSCAN/DBSCANPipeline.h"
+#include "DBSCAN/DBSCANTracker.h"
+#include "DBSCAN/DBSCANWarmStart.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <thread>
+#include <vector>
+#ifdef DBSCAN_WITH_DAEMON
+#include <unistd.h>
+#endif
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+using namespace dbscan;
+
+namespace
+{
+
+struct Workload {
+  std::string name;
+  std::vector<float> points;
+  size_t n;
+  DBSCANParams params;
+};
+
+// Same eps in every dimension
+std::array<float, NDim> make_eps(float eps)
+{
+  std::array<float, NDim> out;
+  out.fill(eps);
+  return out;
+}
+
+// The workloads are drawn in the plane: 1-D builds keep x, higher
+// dimensions pad with zeros
+void push_point(std::vector<float>& points, float x, float y)
+{
+  for (size_t d = 0; d < NDim; ++d) {
+    points.push_back(d == 0 ? x : d == 1 ? y : 0.0f);
+  }
+}
+
+// Three gaussian blobs in space-time plus 50% uniform noise (same as dbscan_test)
+Workload make_blobs(size_t n, unsigned int seed)
+{
+  std::mt19937 gen(seed);
+  std::normal_distribution<float> space_dist(0.0f, 5.0f);
+  std::normal_distribution<float> time_dist(0.0f, 2.0f);
+  std::uniform_real_distribution<float> noise_space(-20.0f, 120.0f);
+  std::uniform_real_distribution<float> noise_time(-10.0f, 110.0f);
+  std::array<std::array<float, 2>, 3> centers = {{{0.0f, 10.0f}, {50.0f, 50.0f}, {100.0f, 90.0f}}};
+
+  Workload w{"blobs", {}, n, DBSCANParams{make_eps(0.6f), 100, 0}};
+  w.points.reserve(n * NDim);
+  size_t n_noise = n / 2;
+  for (size_t i = 0; i < n - n_noise; ++i) {
+    const float x = centers[i % 3][0] + space_dist(gen);
+    push_point(w.points, x, centers[i % 3][1] + time_dist(gen));
+  }
+  for (size_t i = 0; i < n_noise; ++i) {
+    const float x = noise_space(gen);
+    push_point(w.points, x, noise_time(gen));
+  }
+  return w;
+}
+
+// One dense cluster covering most of the points; stresses a single union-find root
+Workload make_giant(size_t n, unsigned int seed)
+{
+  std::mt19937 gen(seed);
+  std::normal_distribution<float> dist(0.0f, 10.0f);
+  std::uniform_real_distribution<float> noise(-100.0f, 100.0f);
+
+  Workload w{"giant", {}, n, DBSCANParams{make_eps(0.5f), 10, 0}};
+  w.points.reserve(n * NDim);
+  size_t n_noise = n / 20;
+  for (size_t i = 0; i < n - n_noise; ++i) {
+    const float x = dist(gen);
+    push_point(w.points, x, dist(gen));
+  }
+  for (size_t i = 0; i < n_noise; ++i) {
+    const float x = noise(gen);
+    push_point(w.points, x, noise(gen));
+  }
+  return w;
+}
+
+// Many small, well separated clusters on a lattice
+Workload make_small(size_t n, unsigned int seed)
+{
+  std::mt19937 gen(seed);
+  std::normal_distribution<float> dist(0.0f, 0.5f);
+  const size_t per_cluster = 50;
+  const auto side = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(n / per_cluster + 1))));
+
+  Workload w{"small", {}, n, DBSCANParams{make_eps(0.5f), 5, 0}};
+  w.points.reserve(n * NDim);
+  for (size_t i = 0; i < n; ++i) {
+    size_t c = (i / per_cluster);
+    const float x = static_cast<float>(c % side) * 10.0f + dist(gen);
+    push_point(w.points, x, static_cast<float>(c / side) * 10.0f + dist(gen));
+  }
+  return w;
+}
+
+// Uniform background, almost everything is noise
+Workload make_uniform(size_t n, unsigned int seed)
+{
+  std::mt19937 gen(seed);
+  std::uniform_real_distribution<float> dist(0.0f, 1000.0f);
+
+  Workload w{"uniform", {}, n, DBSCANParams{make_eps(0.5f), 10, 0}};
+  w.points.resize(n * NDim);
+  for (auto& v : w.points) {
+    v = dist(gen);
+  }
+  return w;
+}
+
+Workload make_workload(const std::string& name, size_t n, unsigned int seed = 42)
+{
+  if (name == "giant") {
+    return make_giant(n, seed);
+  }
+  if (name == "small") {
+    return make_small(n, seed);
+  }
+  if (name == "uniform") {
+    return make_uniform(n, seed);
+  }
+  return make_blobs(n, seed);
+}
+
+// Reorder the points along dim (the last one is time in the space-time
+// workloads) and pass that on as the sortedDim hint
+void sort_workload(Workload& w, size_t dim)
+{
+  std::vector<std::array<float, NDim>> rows(w.n);
+  for (size_t i = 0; i < w.n; ++i) {
+    std::copy_n(&w.points[i * NDim], NDim, rows[i].begin());
+  }
+  std::stable_sort(rows.begin(), rows.end(), [dim](const auto& a, const auto& b) { return a[dim] < b[dim]; });
+  for (size_t i = 0; i < w.n; ++i) {
+    std::copy_n(rows[i].begin(), NDim, &w.points[i * NDim]);
+  }
+  w.params.sortedDim = static_cast<int32_t>(dim);
+}
+
+// Coordinate type the workload is handed to cluster() in
+enum class Coords {
+  Float,
+  Double,
+  Float16,
+  BFloat16,
+  Int16,
+  Int32,
+};
+
+// Same coordinates in a wider or narrower floating-point type
+template <typename T>
+std::vector<T> convert(const Workload& w)
+{
+  std::vector<T> out(w.points.size());
+  for (size_t i = 0; i < out.size(); ++i) {
+    if constexpr (std::is_arithmetic_v<T>) {
+      out[i] = static_cast<T>(w.points[i]);
+    } else {
+      out[i] = T::fromFloat(w.points[i]);
+    }
+  }
+  return out;
+}
+
+// Digitize the workload the way detector data arrives: integer units of
+// eps/4 (a power of two, so the grid uses shifts), eps becomes 4 units
+template <typename T>
+std::vector<T> quantize(const Workload& w, DBSCANParams& params)
+{
+  const float unit = *std::min_element(w.params.eps.begin(), w.params.eps.end()) / 4.f;
+  std::vector<T> out(w.points.size());
+  for (size_t i = 0; i < out.size(); ++i) {
+    out[i] = static_cast<T>(std::lround(w.points[i] / unit));
+  }
+  for (auto& e : params.eps) {
+    e = std::round(e / unit);
+  }
+  return out;
+}
+
+template <typename T>
+void time_cluster(const Workload& w, const DBSCANParams& params, const T* points, int reps, std::vector<double>& times,
+                  DBSCANResult& result)
+{
+  DBSCAN dbscan(params);
+  for (int r = 0; r < reps; ++r) {
+    auto start = std::chrono::high_resolution_clock::now();
+    result = dbscan.cluster(points, w.n);
+    auto end = std::chrono::high_resolution_clock::now();
+    times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+  }
+}
+
+void run_workload(Workload& w, int reps, int32_t n_threads, Connectivity connectivity, Engine engine,
+                  NeighborStorage storage = NeighborStorage::Explicit, Coords coords = Coords::Float,
+                  bool compact = false, int32_t numa = 0)
+{
+  w.params.nThreads = n_threads;
+  w.params.connectivity = connectivity;
+  w.params.engine = engine;
+  w.params.neighborStorage = storage;
+  w.params.compactCoords = compact;
+  w.params.numaPartitions = numa;
+
+  std::vector<double> times;
+  DBSCANResult result;
+  auto params = w.params;
+  if (coords == Coords::Int16) {
+    const auto points = quantize<int16_t>(w, params);
+    time_cluster(w, params, points.data(), reps, times, result);
+  } else if (coords == Coords::Int32) {
+    const auto points = quantize<int32_t>(w, params);
+    time_cluster(w, params, points.data(), reps, times, result);
+  } else if (coords == Coords::Double) {
+    const auto points = convert<double>(w);
+    time_cluster(w, params, points.data(), reps, times, result);
+  } else if (coords == Coords::Float16) {
+    const auto points = convert<Float16>(w);
+    time_cluster(w, params, points.data(), reps, times, result);
+  } else if (coords == Coords::BFloat16) {
+    const auto points = convert<BFloat16>(w);
+    time_cluster(w, params, points.data(), reps, times, result);
+  } else {
+    time_cluster(w, params, w.points.data(), reps, times, result);
+  }
+  std::sort(times.begin(), times.end());
+
+  std::cout << std::left << std::setw(10) << w.name
+            << " n=" << std::setw(10) << w.n
+            << " min=" << std::fixed << std::setprecision(2) << std::setw(10) << times.front()
+            << " median=" << std::setw(10) << times[times.size() / 2]
+            << " clusters=" << result.nClusters
+            << " noise=" << result.nNoise << std::endl;
+}
+
+// Stream of frames: blocking cluster() per frame vs. the pipelined async API
+void run_pipeline(const Workload& w, size_t n_frames, size_t in_flight, int32_t n_threads)
+{
+  auto params = w.params;
+  params.nThreads = n_threads;
+
+  double blocking_ms = 0;
+  {
+    DBSCAN dbscan(params);
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t f = 0; f < n_frames; ++f) {
+      dbscan.cluster(w.points.data(), w.n);
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    blocking_ms = std::chrono::duration<double, std::milli>(end - start).count();
+  }
+
+  double pipelined_ms = 0;
+  {
+    DBSCANPipeline pipeline(params, in_flight);
+    std::vector<std::future<DBSCANResult>> results;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (size_t f = 0; f < n_frames; ++f) {
+      results.push_back(pipeline.submit(w.points));
+    }
+    for (auto& r : results) {
+      r.get();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    pipelined_ms = std::chrono::duration<double, std::milli>(end - start).count();
+  }
+
+  std::cout << std::left << std::setw(10) << w.name
+            << " n=" << std::setw(10) << w.n
+            << " frames=" << n_frames
+            << " blocking=" << std::fixed << std::setprecision(2) << blocking_ms / static_cast<double>(n_frames) << " ms/frame"
+            << " pipelined=" << pipelined_ms / static_cast<double>(n_frames) << " ms/frame" << std::endl;
+}
+
+// Several caller threads: one shared (thread-safe) instance vs. one instance per caller
+void run_concurrent(const Workload& w, size_t n_callers, int reps, int32_t n_threads)
+{
+  auto params = w.params;
+  params.nThreads = n_threads;
+
+  auto timed = [&](auto&& body) {
+    auto start = std::chrono::high_resolution_clock::now();
+    std::vector<std::thread> callers;
+    for (size_t c = 0; c < n_callers; ++c) {
+      callers.emplace_back([&, c] { body(c); });
+    }
+    for (auto& t : callers) {
+      t.join();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+  };
+
+  DBSCAN shared(params);
+  double shared_ms = timed([&](size_t) {
+    for (int r = 0; r < reps; ++r) {
+      shared.cluster(w.points.data(), w.n);
+    }
+  });
+
+  std::vector<std::unique_ptr<DBSCAN>> own;
+  for (size_t c = 0; c < n_callers; ++c) {
+    own.push_back(std::make_unique<DBSCAN>(params));
+  }
+  double own_ms = timed([&](size_t c) {
+    for (int r = 0; r < reps; ++r) {
+      own[c]->cluster(w.points.data(), w.n);
+    }
+  });
+
+  std::cout << std::left << std::setw(10) << w.name
+            << " n=" << std::setw(10) << w.n
+            << " callers=" << n_callers
+            << " shared=" << std::fixed << std::setprecision(2) << shared_ms << " ms"
+            << " per-caller instances=" << own_ms << " ms" << std::endl;
+}
+
+// Moving frames: the workload drifts a quarter eps along x per frame and the
+// tracker carries the cluster ids from frame to frame
+void run_tracking(const Workload& w, size_t n_frames, int32_t n_threads)
+{
+  auto params = w.params;
+  params.nThreads = n_threads;
+  DBSCAN dbscan(params);
+  DBSCANTracker tracker({params.eps, 1, n_threads});
+
+  std::vector<float> points = w.points;
+  double cluster_ms = 0, track_ms = 0;
+  size_t n_events = 0;
+  for (size_t f = 0; f < n_frames; ++f) {
+    for (size_t i = 0; i < w.n; ++i) {
+      points[i * NDim] += params.eps[0] * 0.25f;
+    }
+    auto start = std::chrono::high_resolution_clock::now();
+    const auto result = dbscan.cluster(points.data(), w.n);
+    auto mid = std::chrono::high_resolution_clock::now();
+    const auto tracked = tracker.update(points.data(), w.n, result);
+    auto end = std::chrono::high_resolution_clock::now();
+    cluster_ms += std::chrono::duration<double, std::milli>(mid - start).count();
+    track_ms += std::chrono::duration<double, std::milli>(end - mid).count();
+    n_events += f > 0 ? tracked.events.size() : 0;
+  }
+
+  std::cout << std::left << std::setw(10) << w.name
+            << " n=" << std::setw(10) << w.n
+            << " frames=" << n_frames
+            << " cluster=" << std::fixed << std::setprecision(2) << cluster_ms / static_cast<double>(n_frames) << " ms/frame"
+            << " track=" << track_ms / static_cast<double>(n_frames) << " ms/frame"
+            << " events=" << n_events << std::endl;
+}
+
+// Simulation steps: 1% of the points jitter by up to a quarter eps per step;
+// the warm-started instance repairs its clustering, the cold one reclusters
+void run_warm(const Workload& w, size_t n_steps, int32_t n_threads)
+{
+  auto params = w.params;
+  params.nThreads = n_threads;
+  DBSCAN dbscan(params);
+  DBSCANWarmStart<float> warm(params);
+  warm.cluster(w.points.data(), w.n);
+
+  std::vector<float> points = w.points;
+  std::mt19937 gen(7);
+  std::uniform_int_distribution<size_t> pick(0, w.n - 1);
+  std::uniform_real_distribution<float> jitter(-0.25f, 0.25f);
+  double warm_ms = 0, cold_ms = 0;
+  for (size_t s = 0; s < n_steps; ++s) {
+    for (size_t k = 0; k < w.n / 100; ++k) {
+      const size_t i = pick(gen);
+      for (size_t d = 0; d < NDim; ++d) {
+        points[(i * NDim) + d] += jitter(gen) * params.eps[d];
+      }
+    }
+    auto start = std::chrono::high_resolution_clock::now();
+    const auto& repaired = warm.update(points.data());
+    auto mid = std::chrono::high_resolution_clock::now();
+    const auto result = dbscan.cluster(points.data(), w.n);
+    auto end = std::chrono::high_resolution_clock::now();
+    warm_ms += std::chrono::duration<double, std::milli>(mid - start).count();
+    cold_ms += std::chrono::duration<double, std::milli>(end - mid).count();
+    if (repaired.nNoise != result.nNoise) {
+      std::cerr << "warm start mismatch at step " << s << std::endl;
+    }
+  }
+
+  std::cout << std::left << std::setw(10) << w.name
+            << " n=" << std::setw(10) << w.n
+            << " steps=" << n_steps
+            << " warm=" << std::fixed << std::setprecision(2) << warm_ms / static_cast<double>(n_steps) << " ms/step"
+            << " cold=" << cold_ms / static_cast<double>(n_steps) << " ms/step" << std::endl;
+}
+
+// Online trigger: small frames arriving every gap_us, timed one by one.
+// The calling thread takes the first of cpus, the workers the others.
+void run_latency(const Workload& w, size_t n_frames, int32_t n_threads, const std::vector<int32_t>& cpus, int32_t spin_us, int32_t gap_us)
+{
+  auto params = w.params;
+  params.nThreads = n_threads;
+  params.cpus = cpus;
+  params.spinMicros = spin_us;
+#if defined(__linux__)
+  if (!cpus.empty()) {
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(static_cast<size_t>(cpus.front()), &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+  }
+#endif
+  DBSCAN dbscan(params);
+
+  std::vector<double> latencies;
+  latencies.reserve(n_frames);
+  for (size_t f = 0; f < n_frames; ++f) {
+    const auto next = std::chrono::steady_clock::now() + std::chrono::microseconds(gap_us);
+    while (std::chrono::steady_clock::now() < next) {
+    }
+    auto start = std::chrono::high_resolution_clock::now();
+    dbscan.cluster(w.points.data(), w.n);
+    auto end = std::chrono::high_resolution_clock::now();
+    latencies.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+  }
+  std::sort(latencies.begin(), latencies.end());
+  auto percentile = [&](double q) { return latencies[std::min(latencies.size() - 1, static_cast<size_t>(q * static_cast<double>(latencies.size())))]; };
+
+  std::cout << std::left << std::setw(10) << w.name
+            << " n=" << std::setw(10) << w.n
+            << " frames=" << n_frames
+            << " spin=" << spin_us << " us"
+            << " p50=" << std::fixed << std::setprecision(1) << percentile(0.5) << " us"
+            << " p99=" << percentile(0.99) << " us"
+            << " p99.9=" << percentile(0.999) << " us"
+            << " max=" << latencies.back() << " us" << std::endl;
+  if (dbscan.pinningFailed()) {
+    std::cout << "  (some workers could not be pinned to --cpus and ran unpinned)" << std::endl;
+  }
+}
+
+// Small and full-size calls alternating on one instance, with every call
+// on the whole arena, on threads growing with n (pointsPerThread), and with
+// the thread counts calibrated online
+void run_mixed(const Workload& w, size_t n_frames, int32_t n_threads, int32_t points_per_thread)
+{
+  const size_t n_small = std::min<size_t>(w.n, 2000);
+  for (int mode = 0; mode < 3; ++mode) {
+    auto params = w.params;
+    params.nThreads = n_threads;
+    params.pointsPerThread = mode > 0 ? points_per_thread : 0;
+    params.calibrateParallelism = mode == 2;
+    DBSCAN dbscan(params);
+
+    double small_ms = 0, large_ms = 0;
+    for (size_t f = 0; f < n_frames; ++f) {
+      auto start = std::chrono::high_resolution_clock::now();
+      dbscan.cluster(w.points.data(), n_small);
+      auto mid = std::chrono::high_resolution_clock::now();
+      dbscan.cluster(w.points.data(), w.n);
+      auto end = std::chrono::high_resolution_clock::now();
+      small_ms += std::chrono::duration<double, std::milli>(mid - start).count();
+      large_ms += std::chrono::duration<double, std::milli>(end - mid).count();
+    }
+
+    std::cout << std::left << std::setw(10) << w.name
+              << " n=" << std::setw(10) << w.n
+              << " mode=" << std::setw(11) << (mode == 0 ? "all" : mode == 1 ? "model" : "calibrated")
+              << " small=" << std::fixed << std::setprecision(3) << small_ms / static_cast<double>(n_frames) << " ms"
+              << " large=" << large_ms / static_cast<double>(n_frames) << " ms" << std::endl;
+  }
+}
+
+// Anytime mode: time to the coarse result and to the refined one, against
+// a plain cluster() call
+void run_anytime(const Workload& w, int reps, int32_t n_threads)
+{
+  auto params = w.params;
+  params.nThreads = n_threads;
+  DBSCAN dbscan(params);
+  double coarse_ms = 0, refined_ms = 0, direct_ms = 0;
+  double dense = 0;
+  for (int r = 0; r < reps; ++r) {
+    auto start = std::chrono::high_resolution_clock::now();
+    const CancellationToken cancel;
+    auto anytime = dbscan.clusterAnytime(w.points.data(), w.n, cancel);
+    auto mid = std::chrono::high_resolution_clock::now();
+    const auto refined = anytime.refined.get();
+    auto end = std::chrono::high_resolution_clock::now();
+    dbscan.cluster(w.points.data(), w.n);
+    auto direct = std::chrono::high_resolution_clock::now();
+    coarse_ms += std::chrono::duration<double, std::milli>(mid - start).count();
+    refined_ms += std::chrono::duration<double, std::milli>(end - start).count();
+    direct_ms += std::chrono::duration<double, std::milli>(direct - end).count();
+    dense = static_cast<double>(std::count_if(anytime.coarse.labels.begin(), anytime.coarse.labels.end(), [](int32_t l) { return l >= 0; })) /
+            static_cast<double>(w.n);
+  }
+
+  std::cout << std::left << std::setw(10) << w.name
+            << " n=" << std::setw(10) << w.n
+            << " coarse=" << std::fixed << std::setprecision(2) << coarse_ms / reps << " ms"
+            << " (" << std::setprecision(1) << dense * 100 << "% resolved)"
+            << " refined=" << std::setprecision(2) << refined_ms / reps << " ms"
+            << " direct=" << direct_ms / reps << " ms" << std::endl;
+}
+
+// Region of interest: a box of the given fraction of the data's extent per
+// dimension, at its center, against clustering everything
+void run_region(const Workload& w, int reps, int32_t n_threads, double fraction)
+{
+  auto params = w.params;
+  params.nThreads = n_threads;
+  DBSCAN dbscan(params);
+  std::array<float, NDim> lower, upper;
+  for (size_t d = 0; d < NDim; ++d) {
+    float low = w.points[d], high = w.points[d];
+    for (size_t i = 0; i < w.n; ++i) {
+      low = std::min(low, w.points[(i * NDim) + d]);
+      high = std::max(high, w.points[(i * NDim) + d]);
+    }
+    const float center = (low + high) / 2, half = static_cast<float>(fraction) * (high - low) / 2;
+    lower[d] = center - half;
+    upper[d] = center + half;
+  }
+
+  double region_ms = 0, direct_ms = 0;
+  size_t resolved = 0;
+  for (int r = 0; r < reps; ++r) {
+    auto start = std::chrono::high_resolution_clock::now();
+    const auto region = dbscan.clusterRegion(w.points.data(), w.n, lower, upper);
+    auto mid = std::chrono::high_resolution_clock::now();
+    dbscan.cluster(w.points.data(), w.n);
+    auto end = std::chrono::high_resolution_clock::now();
+    region_ms += std::chrono::duration<double, std::milli>(mid - start).count();
+    direct_ms += std::chrono::duration<double, std::milli>(end - mid).count();
+    resolved = static_cast<size_t>(std::count_if(region.labels.begin(), region.labels.end(), [](int32_t l) { return l != DB_UNVISITED; }));
+  }
+
+  std::cout << std::left << std::setw(10) << w.name
+            << " n=" << std::setw(10) << w.n
+            << " box=" << fraction
+            << " resolved=" << resolved
+            << " region=" << std::fixed << std::setprecision(2) << region_ms / reps << " ms"
+            << " direct=" << direct_ms / reps << " ms" << std::endl;
+}
+
+#ifdef DBSCAN_WITH_DAEMON
+// Frames through an in-process daemon (shared memory plus socket) vs.
+// calling cluster() directly; the difference is the IPC cost per frame
+void run_daemon(const Workload& w, size_t n_frames, int32_t n_threads)
+{
+  auto params = w.params;
+  params.nThreads = n_threads;
+  const std::string socket_path = "/tmp/dbscan_bench_" + std::to_string(getpid()) + ".sock";
+  DBSCANDaemon daemon(params, socket_path, 1);
+  std::thread server([&] { daemon.run(); });
+
+  // The daemon may still be binding its socket
+  std::unique_ptr<DBSCANDaemonClient> client;
+  for (int attempt = 0; attempt < 100 && (client == nullptr || !client->connected()); ++attempt) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    client = std::make_unique<DBSCANDaemonClient>(socket_path, 1, static_cast<uint32_t>(w.n));
+  }
+  if (!client->connected()) {
+    std::cerr << "cannot connect to " << socket_path << std::endl;
+    daemon.stop();
+    server.join();
+    return;
+  }
+
+  // Empty frames: the round trip alone
+  DaemonReply reply{};
+  const size_t n_pings = 1000;
+  auto start = std::chrono::high_resolution_clock::now();
+  for (size_t p = 0; p < n_pings; ++p) {
+    client->submit(0, 0);
+    client->wait(reply);
+  }
+  auto end = std::chrono::high_resolution_clock::now();
+  const double round_trip_us = std::chrono::duration<double, std::micro>(end - start).count() / static_cast<double>(n_pings);
+
+  std::copy(w.points.begin(), w.points.end(), client->points(0));
+  double daemon_ms = 0, direct_ms = 0;
+  DBSCAN dbscan(params);
+  for (size_t f = 0; f < n_frames; ++f) {
+    start = std::chrono::high_resolution_clock::now();
+    client->submit(0, static_cast<uint32_t>(w.n));
+    client->wait(reply);
+    auto mid = std::chrono::high_resolution_clock::now();
+    const auto result = dbscan.cluster(w.points.data(), w.n);
+    end = std::chrono::high_resolution_clock::now();
+    daemon_ms += std::chrono::duration<double, std::milli>(mid - start).count();
+    direct_ms += std::chrono::duration<double, std::milli>(end - mid).count();
+    if (reply.status != 0 || reply.nClusters != result.nClusters || reply.nNoise != result.nNoise) {
+      std::cerr << "daemon mismatch at frame " << f << std::endl;
+    }
+  }
+  client.reset();
+  daemon.stop();
+  server.join();
+
+  std::cout << std::left << std::setw(10) << w.name
+            << " n=" << std::setw(10) << w.n
+            << " frames=" << n_frames
+            << " daemon=" << std::fixed << std::setprecision(2) << daemon_ms / static_cast<double>(n_frames) << " ms/frame"
+            << " direct=" << direct_ms / static_cast<double>(n_frames) << " ms/frame"
+            << " empty round trip=" << round_trip_us << " us" << std::endl;
+}
+#endif
+
+void print_usage()
+{
+  std::cout << "Usage: dbscan_bench [--train] [--workload blobs|giant|small|uniform|all]\n"
+            << "                    [--n points] [--reps r] [--threads t]\n"
+            << "                    [--pipeline frames] [--in-flight k] [--callers k] [--track frames]\n"
+            << "                    [--warm steps] [--daemon frames]\n"
+            << "                    [--connectivity unionfind|afforest] [--engine points|cells|sweep]\n"
+            << "                    [--storage explicit|compressed|hybrid]\n"
+            << "                    [--coords float|double|float16|bfloat16|int16|int32] [--compact]\n"
+            << "                    [--sorted] [--numa partitions (-1: one per node)]\n"
+            << "                    [--latency frames] [--gap us] [--spin us] [--cpus c0,c1,...]\n"
+            << "                    [--mixed frames] [--adaptive points per thread] [--anytime]\n"
+            << "                    [--roi fraction of the extent]\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  std::string workload = "all";
+  size_t n_points = 1'000'000;
+  int reps = 5;
+  int32_t n_threads = 0;
+  bool train = false;
+  size_t n_frames = 0;
+  size_t in_flight = 4;
+  size_t n_callers = 0;
+  size_t n_track = 0;
+  size_t n_warm = 0;
+  size_t n_daemon = 0;
+  Connectivity connectivity = Connectivity::UnionFind;
+  Engine engine = Engine::PointGraph;
+  NeighborStorage storage = NeighborStorage::Explicit;
+  Coords coords = Coords::Float;
+  bool compact = false;
+  bool sorted = false;
+  int32_t numa = 0;
+  size_t n_latency = 0;
+  int32_t gap_us = 200;
+  int32_t spin_us = 0;
+  std::vector<int32_t> cpus;
+  size_t n_mixed = 0;
+  int32_t points_per_thread = 16384;
+  bool anytime = false;
+  double roi = 0;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--train") {
+      train = true;
+    } else if (arg == "--workload" && i + 1 < argc) {
+      workload = argv[++i];
+    } else if (arg == "--n" && i + 1 < argc) {
+      n_points = std::stoul(argv[++i]);
+    } else if (arg == "--reps" && i + 1 < argc) {
+      reps = std::stoi(argv[++i]);
+    } else if (arg == "--threads" && i + 1 < argc) {
+      n_threads = std::stoi(argv[++i]);
+    } else if (arg == "--pipeline" && i + 1 < argc) {
+      n_frames = std::stoul(argv[++i]);
+    } else if (arg == "--in-flight" && i + 1 < argc) {
+      in_flight = std::stoul(argv[++i]);
+    } else if (arg == "--connectivity" && i + 1 < argc) {
+      connectivity = std::string(argv[++i]) == "afforest" ? Connectivity::Afforest : Connectivity::UnionFind;
+    } else if (arg == "--engine" && i + 1 < argc) {
+      const std::string name = argv[++i];
+      engine = name == "cells"   ? Engine::CellGraph
+               : name == "sweep" ? Engine::Sweep
+                                 : Engine::PointGraph;
+    } else if (arg == "--storage" && i + 1 < argc) {
+      const std::string name = argv[++i];
+      storage = name == "compressed" ? NeighborStorage::Compressed
+                : name == "hybrid"   ? NeighborStorage::Hybrid
+                                     : NeighborStorage::Explicit;
+    } else if (arg == "--coords" && i + 1 < argc) {
+      const std::string name = argv[++i];
+      coords = name == "int16"      ? Coords::Int16
+               : name == "int32"    ? Coords::Int32
+               : name == "double"   ? Coords::Double
+               : name == "float16"  ? Coords::Float16
+               : name == "bfloat16" ? Coords::BFloat16
+                                    : Coords::Float;
+    } else if (arg == "--compact") {
+      compact = true;
+    } else if (arg == "--latency" && i + 1 < argc) {
+      n_latency = std::stoul(argv[++i]);
+    } else if (arg == "--gap" && i + 1 < argc) {
+      gap_us = std::stoi(argv[++i]);
+    } else if (arg == "--spin" && i + 1 < argc) {
+      spin_us = std::stoi(argv[++i]);
+    } else if (arg == "--cpus" && i + 1 < argc) {
+      const std::string list = argv[++i];
+      for (size_t begin = 0; begin < list.size();) {
+        const size_t end = std::min(list.find(',', begin), list.size());
+        cpus.push_back(std::stoi(list.substr(begin, end - begin)));
+        begin = end + 1;
+      }
+    } else if (arg == "--mixed" && i + 1 < argc) {
+      n_mixed = std::stoul(argv[++i]);
+    } else if (arg == "--adaptive" && i + 1 < argc) {
+      points_per_thread = std::stoi(argv[++i]);
+    } else if (arg == "--anytime") {
+      anytime = true;
+    } else if (arg == "--roi" && i + 1 < argc) {
+      roi = std::stod(argv[++i]);
+    } else if (arg == "--numa" && i + 1 < argc) {
+      numa = std::stoi(argv[++i]);
+    } else if (arg == "--sorted") {
+      sorted = true;
+    } else if (arg == "--callers" && i + 1 < argc) {
+      n_callers = std::stoul(argv[++i]);
+    } else if (arg == "--track" && i + 1 < argc) {
+      n_track = std::stoul(argv[++i]);
+    } else if (arg == "--warm" && i + 1 < argc) {
+      n_warm = std::stoul(argv[++i]);
+    } else if (arg == "--daemon" && i + 1 < argc) {
+      n_daemon = std::stoul(argv[++i]);
+    } else {
+      print_usage();
+      return arg == "--help" ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+  }
+
+  // Training run for PGO: every workload at a couple of sizes so both the
+  // sparse (mostly noise) and dense (long neighbor lists) branches get profiled
+  if (train) {
+    for (size_t n : {100'000UL, 500'000UL}) {
+      for (const char* name : {"blobs", "giant", "small", "uniform"}) {
+        auto w = make_workload(name, n);
+        run_workload(w, 2, n_threads, Connectivity::UnionFind, Engine::PointGraph);
+        run_workload(w, 1, n_threads, Connectivity::Afforest, Engine::PointGraph);
+        run_workload(w, 1, n_threads, Connectivity::UnionFind, Engine::CellGraph);
+        run_workload(w, 1, n_threads, Connectivity::UnionFind, Engine::PointGraph, NeighborStorage::Compressed);
+        run_workload(w, 1, n_threads, Connectivity::UnionFind, Engine::PointGraph, NeighborStorage::Hybrid);
+        run_workload(w, 1, n_threads, Connectivity::UnionFind, Engine::PointGraph, NeighborStorage::Explicit, Coords::Int16);
+        run_workload(w, 1, n_threads, Connectivity::UnionFind, Engine::PointGraph, NeighborStorage::Explicit, Coords::Float, true);
+        sort_workload(w, NDim - 1);
+        run_workload(w, 1, n_threads, Connectivity::UnionFind, Engine::Sweep);
+      }
+    }
+    return EXIT_SUCCESS;
+  }
+
+  std::cout << "Parallel backend: " << ParallelBackendName << ", NUMA nodes: " << numaNodes().size() << std::endl;
+  std::vector<std::string> names;
+  if (workload == "all") {
+    names = {"blobs", "giant", "small", "uniform"};
+  } else {
+    names = {workload};
+  }
+  for (const auto& name : names) {
+    auto w = make_workload(name, n_points);
+    if (sorted) {
+      sort_workload(w, NDim - 1);
+    }
+    if (n_frames > 0) {
+      run_pipeline(w, n_frames, in_flight, n_threads);
+    } else if (n_callers > 0) {
+      run_concurrent(w, n_callers, reps, n_threads);
+    } else if (n_track > 0) {
+      run_tracking(w, n_track, n_threads);
+    } else if (n_warm > 0) {
+      run_warm(w, n_warm, n_threads);
+    } else if (n_latency > 0) {
+      run_latency(w, n_latency, n_threads, cpus, spin_us, gap_us);
+    } else if (n_mixed > 0) {
+      run_mixed(w, n_mixed, n_threads, points_per_thread);
+    } else if (anytime) {
+      run_anytime(w, reps, n_threads);
+    } else if (roi > 0) {
+      run_region(w, reps, n_threads, roi);
+    } else if (n_daemon > 0) {
+#ifdef DBSCAN_WITH_DAEMON
+      run_daemon(w, n_daemon, n_threads);
+#else
+      std::cerr << "built without the daemon (BUILD_DAEMON)" << std::endl;
+      return EXIT_FAILURE;
+#endif
+    } else {
+      run_workload(w, reps, n_threads, connectivity, engine, storage, coords, compact, numa);
+    }
+  }
+  return EXIT_SUCCESS;
+}
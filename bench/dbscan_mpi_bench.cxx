@@ -0,0 +1,109 @@
+#include "DBSCAN/DBSCANMPI.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace dbscan;
+
+namespace
+{
+
+// Weak scaling: every rank brings n points, the domain grows with the
+// ranks. Rank r draws the tile of rank r + 1, so every point has to move to
+// its owner, as with data read from unsorted files.
+std::vector<float> make_tile(size_t n, int tile, unsigned int seed)
+{
+  std::mt19937 gen(seed + static_cast<unsigned int>(tile));
+  std::normal_distribution<float> dist(0.0f, 0.5f);
+  std::uniform_real_distribution<float> noise(0.0f, 1.0f);
+  const size_t per_cluster = 50;
+  const auto side = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(n / per_cluster + 1))));
+  const float width = static_cast<float>(side) * 10.0f;
+  const float x0 = static_cast<float>(tile) * width;
+
+  // Small clusters on a lattice plus 10% uniform noise, in the plane
+  std::vector<float> points;
+  points.reserve(n * NDim);
+  for (size_t i = 0; i < n; ++i) {
+    const size_t c = i / per_cluster;
+    const bool is_noise = i % 10 == 0;
+    const float x = x0 + (is_noise ? noise(gen) * width : static_cast<float>(c % side) * 10.0f + dist(gen));
+    const float y = is_noise ? noise(gen) * width : static_cast<float>(c / side) * 10.0f + dist(gen);
+    for (size_t d = 0; d < NDim; ++d) {
+      points.push_back(d == 0 ? x : d == 1 ? y : 0.0f);
+    }
+  }
+  return points;
+}
+
+void print_usage()
+{
+  std::cout << "Usage: mpirun -np <ranks> dbscan_mpi_bench [--n points per rank] [--reps r] [--threads t]\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  MPI_Init(&argc, &argv);
+  int rank = 0;
+  int n_ranks = 1;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &n_ranks);
+
+  size_t n_points = 1'000'000;
+  int reps = 5;
+  int32_t n_threads = 0;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--n" && i + 1 < argc) {
+      n_points = std::stoul(argv[++i]);
+    } else if (arg == "--reps" && i + 1 < argc) {
+      reps = std::stoi(argv[++i]);
+    } else if (arg == "--threads" && i + 1 < argc) {
+      n_threads = std::stoi(argv[++i]);
+    } else {
+      if (rank == 0) {
+        print_usage();
+      }
+      MPI_Finalize();
+      return arg == "--help" ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+  }
+
+  std::array<float, NDim> eps;
+  eps.fill(0.5f);
+  const DBSCANMPI dbscan(DBSCANParams{eps, 5, n_threads}, MPI_COMM_WORLD);
+  const auto points = make_tile(n_points, (rank + 1) % n_ranks, 42);
+
+  // Slowest rank per repetition, best repetition
+  double best_ms = 0.0;
+  DBSCANMPIResult result;
+  for (int r = 0; r < reps; ++r) {
+    MPI_Barrier(MPI_COMM_WORLD);
+    auto start = std::chrono::high_resolution_clock::now();
+    result = dbscan.cluster(points.data(), n_points);
+    auto end = std::chrono::high_resolution_clock::now();
+    const double ms = std::chrono::duration<double, std::milli>(end - start).count();
+    double slowest = 0.0;
+    MPI_Allreduce(&ms, &slowest, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+    best_ms = r == 0 ? slowest : std::min(best_ms, slowest);
+  }
+
+  if (rank == 0) {
+    std::cout << "ranks=" << std::left << std::setw(4) << n_ranks
+              << " n/rank=" << std::setw(10) << n_points
+              << " time=" << std::fixed << std::setprecision(2) << best_ms << " ms"
+              << " clusters=" << result.nClusters
+              << " noise=" << result.nNoise << std::endl;
+  }
+  MPI_Finalize();
+  return EXIT_SUCCESS;
+}
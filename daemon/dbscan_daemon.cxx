@@ -0,0 +1,84 @@
+#include "DBSCAN/DBSCANDaemon.h"
+#include <array>
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+using namespace dbscan;
+
+namespace
+{
+
+DBSCANDaemon* g_daemon = nullptr;
+
+void handle_signal(int)
+{
+  if (g_daemon != nullptr) {
+    g_daemon->stop();
+  }
+}
+
+void print_usage()
+{
+  std::cout << "Usage: dbscan_daemon [--socket path] [--eps e] [--min-pts m] [--threads t] [--workers k]\n"
+            << "                     [--engine points|cells|sweep] [--storage explicit|compressed|hybrid]\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  std::string socket_path = "/tmp/dbscan.sock";
+  float eps = 0.5f;
+  int32_t min_pts = 10;
+  int32_t n_threads = 0;
+  size_t n_workers = 2;
+  Engine engine = Engine::PointGraph;
+  NeighborStorage storage = NeighborStorage::Explicit;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    if (arg == "--socket" && i + 1 < argc) {
+      socket_path = argv[++i];
+    } else if (arg == "--eps" && i + 1 < argc) {
+      eps = std::stof(argv[++i]);
+    } else if (arg == "--min-pts" && i + 1 < argc) {
+      min_pts = std::stoi(argv[++i]);
+    } else if (arg == "--threads" && i + 1 < argc) {
+      n_threads = std::stoi(argv[++i]);
+    } else if (arg == "--workers" && i + 1 < argc) {
+      n_workers = std::stoul(argv[++i]);
+    } else if (arg == "--engine" && i + 1 < argc) {
+      const std::string name = argv[++i];
+      engine = name == "cells"   ? Engine::CellGraph
+               : name == "sweep" ? Engine::Sweep
+                                 : Engine::PointGraph;
+    } else if (arg == "--storage" && i + 1 < argc) {
+      const std::string name = argv[++i];
+      storage = name == "compressed" ? NeighborStorage::Compressed
+                : name == "hybrid"   ? NeighborStorage::Hybrid
+                                     : NeighborStorage::Explicit;
+    } else {
+      print_usage();
+      return arg == "--help" ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+  }
+
+  std::array<float, NDim> eps_all;
+  eps_all.fill(eps);
+  DBSCANParams params{eps_all, min_pts, n_threads};
+  params.engine = engine;
+  params.neighborStorage = storage;
+
+  DBSCANDaemon daemon(params, socket_path, n_workers);
+  g_daemon = &daemon;
+  std::signal(SIGINT, handle_signal);
+  std::signal(SIGTERM, handle_signal);
+  std::cout << "Serving on " << socket_path << std::endl;
+  if (!daemon.run()) {
+    std::cerr << "cannot listen on " << socket_path << std::endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -1,24 +1,125 @@
+#pragma once
+
+#include "DBSCANAdaptive.h"
 #include "DBSCANCommon.h"
 #include "DBSCANDistance.h"
-#include <tbb/task_arena.h>
+#include "DBSCANGrid.h"
+#include "DBSCANParallel.h"
+#include "DBSCANStitch.h"
+#include <functional>
+#include <future>
 
 namespace dbscan
 {
 
+// clusterAnytime(): a coarse clustering now, the exact one later
+struct DBSCANAnytimeResult {
+  DBSCANResult coarse;               // status Coarse
+  std::future<DBSCANResult> refined; // what cluster() returns
+};
+
+// Thread safety: cluster() is const and may be called concurrently from any
+// number of threads on one instance. Every call leases its scratch buffers
+// from a lock-free workspace pool and runs its parallel phases in the shared
+// task arena, so concurrent callers split nThreads between them instead of
+// each bringing their own threads.
 class DBSCAN
 {
  public:
   DBSCAN(const DBSCANParams& p);
 
-  DBSCANResult cluster(const float* points, size_t n);
+  // n points of NDim coordinates each; T is any DBSCAN_FOR_EACH_COORD_TYPE
+  // type (see DBSCANCoord.h for how eps applies to integer coordinates)
+  template <typename T>
+  DBSCANResult cluster(const T* points, size_t n) const;
+  // Stoppable by options.cancel and options.deadline, see result.status
+  template <typename T>
+  DBSCANResult cluster(const T* points, size_t n, const DBSCANCallOptions& options) const;
+
+  // Anytime mode: returns as soon as the grid is built with a coarse
+  // clustering of the dense cells, while the exact one continues in the
+  // background on the same grid. The Sweep engine, NUMA partitions and
+  // NDim == 1 build no grid, so there the coarse labels are all
+  // DB_UNVISITED. options apply to the refinement, which stops on cancel
+  // instead of options.cancel. refined is a std::async future: destroying
+  // it waits for the refinement to end, so cancel first to drop it early.
+  // points, cancel and the engine must outlive the future. (DBSCANAnytime.cxx)
+  template <typename T>
+  DBSCANAnytimeResult clusterAnytime(const T* points, size_t n, const CancellationToken& cancel, const DBSCANCallOptions& options = {}) const;
+
+  // Region of interest: resolves only the clusters with a point in the box
+  // [lower, upper] (inclusive), expanding from the box through the grid as
+  // far as they reach. Their points get the ids cluster() gives them (a
+  // border point between clusters may take either), the box's other points
+  // DB_NOISE, all others stay DB_UNVISITED. nNoise counts the box only.
+  // (DBSCANRegion.cxx)
+  template <typename T>
+  DBSCANResult clusterRegion(const T* points, size_t n, const std::array<T, NDim>& lower, const std::array<T, NDim>& upper,
+                             const DBSCANCallOptions& options = {}) const;
+
+  // Boundary descriptor of a chunk clustered by cluster() into result, for
+  // stitch() with the chunk on the other side of cut (DBSCANStitch.cxx)
+  template <typename T>
+  BoundaryDescriptor<T> exportBoundary(const T* points, size_t n, const DBSCANResult& result, int32_t chunk, const StitchCut& cut) const;
+
+  // Whether a worker could not be pinned to its CPU of DBSCANParams::cpus
+  // (e.g. one outside the process's allowed set); it then runs unpinned
+  [[nodiscard]] bool pinningFailed() const { return mTaskArena.pinningFailed(); }
 
  private:
-  void findNeighbors(const float*, size_t n, NeighborList& neighbors);
-  void classify(size_t n, const NeighborList& neighbors, std::vector<int32_t>& labels) const;
+  friend class DBSCANPipeline;
+
+  // Runs body under the control of options (if any); a stopped call leaves
+  // result with its status and every label DB_UNVISITED
+  void runControlled(size_t n, const DBSCANCallOptions& options, DBSCANResult& result, const std::function<void()>& body) const;
+
+  // cluster() once the call is set up, on grid if built already (nullptr:
+  // build one); throws detail::Interrupted when stopped
+  template <typename T>
+  void clusterAll(const T* points, size_t n, const DBSCANCallOptions& options, BasicGrid<T>* grid, DBSCANResult& result) const;
+
+  // Pipeline stages, each runs inside mTaskArena and only touches its arguments
+  template <typename T>
+  void findNeighbors(const T*, size_t n, const BasicGrid<T>& grid, DBSCANWorkspace& workspace) const;
+  template <typename T>
+  void findNeighborsCompact(const T*, size_t n, const BasicGrid<T>& grid, NeighborList& neighbors) const;
+  template <typename T>
+  void findNeighborsCompressed(const T*, size_t n, const BasicGrid<T>& grid, CompressedNeighborList& neighbors) const;
+  template <typename T>
+  void findNeighborsHybrid(const T*, size_t n, const BasicGrid<T>& grid, HybridNeighborList& neighbors) const;
+  void classify(size_t n, DBSCANWorkspace& workspace, std::vector<int32_t>& labels) const;
+  void linkCorePoints(size_t n, DBSCANWorkspace& workspace) const;
+  template <typename Neighbors>
+  void linkCorePoints(size_t n, const Neighbors& neighbors, DBSCANWorkspace& workspace) const;
+  template <typename Neighbors>
+  void linkAfforest(size_t n, const Neighbors& neighbors, DBSCANWorkspace& workspace) const;
+  void assignLabels(size_t n, DBSCANWorkspace& workspace, std::vector<int32_t>& labels) const;
+  void countClusters(DBSCANResult& result) const;
+
+  // Alternative engine: connectivity over core grid cells (DBSCANCellGraph.cxx)
+  template <typename T>
+  void clusterCellGraph(const T* points, size_t n, const BasicGrid<T>& grid, DBSCANResult& result) const;
+
+  // 1-D engine: sort and sweep, no grid (DBSCANSweep.cxx)
+  template <typename T>
+  void clusterSweep(const T* points, size_t n, DBSCANResult& result) const;
+
+  // Sweep engine: core flags and forest from a rolling grid over the slabs
+  // around the sweep along the sorted dimension (DBSCANSweep.cxx)
+  template <typename T>
+  void linkSweep(const T* points, size_t n, DBSCANWorkspace& workspace) const;
+
+  // NUMA mode: slabs clustered by one engine per node, joined by stitch();
+  // false if the data is too narrow to cut (DBSCANNuma.cxx)
+  void createPartitions();
+  template <typename T>
+  bool clusterPartitioned(const T* points, size_t n, const DBSCANCallOptions& options, DBSCANResult& result) const;
 
   DBSCANParams mParams;
-  DBSCANDistance mDistance;
-  tbb::task_arena mTaskArena;
+  mutable TaskArena mTaskArena;            // execute() is safe to enter from several threads
+  mutable ParallelismTuner mTuner;         // threads per call (pointsPerThread, calibrateParallelism)
+  mutable DBSCANWorkspacePool mWorkspaces; // idle per-call workspaces
+  std::vector<std::unique_ptr<DBSCAN>> mPartitions; // NUMA mode: one engine per slab, pinned to its node
 };
 
 } // namespace dbscan
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+namespace dbscan
+{
+
+// Threads per cluster() call. Small calls lose more to task spawning and
+// shared cache lines than they gain from threads, so the model gives a
+// call one thread per pointsPerThread points (a power of two, at most
+// maxThreads). With calibration on, the calls of every size class (by
+// log2 n) hill-climb from the model's power of two to whichever neighbor
+// ran faster per point, re-probing now and then to follow the load.
+class ParallelismTuner
+{
+ public:
+  // Before the first choose(); off until then
+  void initialize(int32_t maxThreads, int32_t pointsPerThread, bool calibrate);
+
+  // 0: the whole arena
+  [[nodiscard]] int32_t choose(size_t n);
+  void record(size_t n, int32_t threads, double seconds);
+
+  // Chooses on construction, records the call's time on destruction
+  class Call
+  {
+   public:
+    Call(ParallelismTuner& tuner, size_t n);
+    ~Call();
+
+    Call(const Call&) = delete;
+    Call& operator=(const Call&) = delete;
+
+    [[nodiscard]] int32_t threads() const { return mThreads; }
+
+   private:
+    ParallelismTuner& mTuner;
+    size_t mN;
+    int32_t mThreads;
+    int64_t mStart;
+  };
+
+ private:
+  static constexpr size_t kLevels = 16;    // 1, 2, 4, ... threads
+  static constexpr size_t kClasses = 48;   // log2 n
+  static constexpr uint32_t kProbes = 3;   // calls per level before trusting its cost
+  static constexpr uint32_t kReprobe = 32; // calls between probes of a neighbor of the best level
+
+  struct SizeClass {
+    std::array<double, kLevels> cost{};      // seconds per point, moving average
+    std::array<uint32_t, kLevels> samples{};
+    uint64_t calls{0};
+    size_t level{kLevels}; // where the search stands (kLevels: not started)
+  };
+
+  [[nodiscard]] size_t modelLevel(size_t n) const;
+  size_t climb(SizeClass& sizeClass, uint64_t call) const;
+
+  size_t mMaxLevel{0};
+  int32_t mPointsPerThread{0};
+  bool mCalibrate{false};
+  std::mutex mMutex;
+  std::array<SizeClass, kClasses> mClasses;
+};
+
+} // namespace dbscan
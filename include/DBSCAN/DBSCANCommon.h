@@ -1,22 +1,102 @@
 #pragma once
 
+#include "DBSCANCompressedNeighbors.h"
+#include "DBSCANHybridNeighbors.h"
+#include "DBSCANParallel.h"
+#include <chrono>
+#include <atomic>
+#include <functional>
 #include <iomanip>
+#include <memory>
+#include <string_view>
 #include <vector>
 #include <cstdint>
 #include <span>
+#include <sstream>
+#include <string>
+#include <algorithm>
 #include <array>
 #include <iostream>
 
 namespace dbscan
 {
 
-constexpr int32_t NDim{2};
+// Number of coordinates per point, fixed at compile time (DBSCAN_NDIM in CMake)
+#ifndef DBSCAN_NDIM
+#define DBSCAN_NDIM 2
+#endif
+constexpr int32_t NDim{DBSCAN_NDIM};
+static_assert(NDim >= 1, "DBSCAN_NDIM must be at least 1");
+
+// Connected-components engine linking core points
+enum class Connectivity : int32_t {
+  UnionFind, // lock-free union-find over every core-core edge
+  Afforest,  // sampled linking first, then skip edges inside the dominant component
+};
+
+// Clustering engine
+enum class Engine : int32_t {
+  PointGraph, // per-point neighbor lists, connectivity over core points
+  CellGraph,  // connectivity over grid cells holding core points, no neighbor lists
+  Sweep,      // sweep along DBSCANParams::sortedDim with a rolling grid, no global grid
+};
+
+// Storage of the per-point neighbor graph (PointGraph engine)
+enum class NeighborStorage : int32_t {
+  Explicit,   // one std::vector<size_t> per point
+  Compressed, // delta + stream-vbyte coded, see CompressedNeighborList
+  Hybrid,     // whole cells within eps by reference, see HybridNeighborList
+};
 
 // Configuration parameters
 struct DBSCANParams {
-  std::array<float, NDim> eps; // Maximum distance per dimension
-  int32_t minPts;              // Minimum points to form a dense region
-  int32_t nThreads;            // Number of threads to use
+  std::array<float, NDim> eps;                                // Maximum distance per dimension
+  int32_t minPts;                                             // Minimum points to form a dense region
+  int32_t nThreads;                                           // Number of threads to use
+  Connectivity connectivity{Connectivity::UnionFind};         // Core point linking engine
+  Engine engine{Engine::PointGraph};                          // Clustering engine
+  NeighborStorage neighborStorage{NeighborStorage::Explicit}; // Neighbor graph representation
+  bool compactCoords{false};                                  // 16-bit cell-relative coordinates (Explicit storage; float types only, ignored for integers)
+  int32_t sortedDim{-1};                                      // input is sorted ascending along this dimension (-1: unsorted)
+  int32_t numaPartitions{0};                                  // slabs clustered per NUMA node, then stitched (0: off, -1: one per node)
+  int32_t numaNode{-1};                                       // NUMA node the task arena runs on (-1: anywhere)
+  std::vector<int32_t> cpus{};                                // CPUs for the arena's workers, one each, at most as many threads (empty: not pinned)
+  int32_t spinMicros{0};                                      // workers spin this long after a call before sleeping (low latency)
+  int32_t pointsPerThread{0};                                 // threads per call grow with n at this rate (0: always all)
+  bool calibrateParallelism{false};                           // measure calls and keep the fastest thread count per size
+};
+
+// Stops a running cluster() call from any thread
+class CancellationToken
+{
+ public:
+  void cancel() { mCancelled.store(true, std::memory_order_relaxed); }
+  void reset() { mCancelled.store(false, std::memory_order_relaxed); }
+  [[nodiscard]] bool cancelled() const { return mCancelled.load(std::memory_order_relaxed); }
+  [[nodiscard]] const std::atomic<bool>& flag() const { return mCancelled; }
+
+ private:
+  std::atomic<bool> mCancelled{false};
+};
+
+// Per-call options. Cancellation and the deadline are polled once per block
+// of every parallel loop, so a call stops within about one block per thread
+// (longer inside the few serial steps).
+struct DBSCANCallOptions {
+  const CancellationToken* cancel{nullptr};
+  std::chrono::steady_clock::time_point deadline{std::chrono::steady_clock::time_point::max()};
+  // Phase (as named by the timers) and the fraction done of its current
+  // parallel loop, in steps of 1/32; 0 on entering a phase, then never lower
+  // within it (a later loop of the phase reports once it passes that point).
+  // Called from any thread, one call at a time.
+  std::function<void(std::string_view phase, double fraction)> progress{};
+};
+
+enum class DBSCANStatus : int32_t {
+  Complete,
+  Cancelled,        // labels all DB_UNVISITED
+  DeadlineExceeded, // labels all DB_UNVISITED
+  Coarse,           // clusterAnytime(): dense cells only, the rest DB_UNVISITED
 };
 
 // Clustering result
@@ -24,6 +104,7 @@ struct DBSCANResult {
   std::vector<int32_t> labels;
   int32_t nClusters = 0;
   int32_t nNoise = 0;
+  DBSCANStatus status = DBSCANStatus::Complete;
 };
 
 // neighbor list
@@ -39,6 +120,73 @@ struct NeighborList {
   std::vector<std::vector<size_t>> neighbors;
 };
 
+// Per-call scratch buffers; kept between calls so the neighbor lists and the
+// union-find forest are not re-allocated for every frame. Only the neighbor
+// graph selected by DBSCANParams::neighborStorage is filled.
+struct DBSCANWorkspace {
+  void prepare(size_t n)
+  {
+    if (n > capacity) {
+      parent = std::make_unique<std::atomic<size_t>[]>(n);
+      capacity = n;
+    }
+    isCore.resize(n);
+  }
+  NeighborList neighbors;
+  CompressedNeighborList compressed;
+  HybridNeighborList hybrid;
+  std::unique_ptr<std::atomic<size_t>[]> parent;
+  std::vector<uint8_t> isCore; // bytes, not vector<bool>: written concurrently
+  size_t capacity{0};
+};
+
+// Lock-free pool of workspaces shared by concurrent callers.
+// A fixed array of slots, each either empty or holding one idle workspace;
+// exchange/CAS on a whole slot means no ABA and no locks. When every slot is
+// empty a fresh workspace is allocated, when every slot is full on release
+// the workspace is dropped, so the pool never blocks a caller.
+class DBSCANWorkspacePool
+{
+ public:
+  explicit DBSCANWorkspacePool(size_t nSlots) : mSlots(std::max<size_t>(1, nSlots)) {}
+  ~DBSCANWorkspacePool()
+  {
+    for (auto& slot : mSlots) {
+      delete slot.load(std::memory_order_relaxed);
+    }
+  }
+
+  DBSCANWorkspacePool(const DBSCANWorkspacePool&) = delete;
+  DBSCANWorkspacePool& operator=(const DBSCANWorkspacePool&) = delete;
+
+  [[nodiscard]] std::unique_ptr<DBSCANWorkspace> acquire()
+  {
+    for (auto& slot : mSlots) {
+      if (slot.load(std::memory_order_relaxed) != nullptr) {
+        if (auto* workspace = slot.exchange(nullptr, std::memory_order_acquire)) {
+          return std::unique_ptr<DBSCANWorkspace>(workspace);
+        }
+      }
+    }
+    return std::make_unique<DBSCANWorkspace>();
+  }
+
+  void release(std::unique_ptr<DBSCANWorkspace> workspace)
+  {
+    for (auto& slot : mSlots) {
+      DBSCANWorkspace* expected = nullptr;
+      if (slot.load(std::memory_order_relaxed) == nullptr &&
+          slot.compare_exchange_strong(expected, workspace.get(), std::memory_order_release, std::memory_order_relaxed)) {
+        workspace.release();
+        return;
+      }
+    }
+  }
+
+ private:
+  std::vector<std::atomic<DBSCANWorkspace*>> mSlots;
+};
+
 // Point classification
 enum DBSCANLabel : int32_t {
   DB_NOISE = -(1 << 0),
@@ -47,27 +195,53 @@ enum DBSCANLabel : int32_t {
   DB_CORE = -(1 << 3),
 };
 
+#ifndef DBSCAN_NO_TIMING
 #define MEASURE_TIMING
+#endif
+
+// Timed scopes also name the phases of progress reports (DBSCANCallOptions)
+#define DBSCAN_CONCAT_(a, b) a##b
+#define DBSCAN_CONCAT(a, b) DBSCAN_CONCAT_(a, b)
 #ifdef MEASURE_TIMING
 class ScopedTimer
 {
   std::string_view name;
+  std::string note;
   std::chrono::high_resolution_clock::time_point start;
 
  public:
   explicit ScopedTimer(std::string_view name)
     : name(name), start(std::chrono::high_resolution_clock::now()) {}
 
+  // Appended to the timing line, e.g. the size of what the phase built
+  void setNote(std::string text) { note = std::move(text); }
+
   ~ScopedTimer()
   {
     auto end = std::chrono::high_resolution_clock::now();
     double elapsed_ms = std::chrono::duration<double, std::milli>(end - start).count();
-    std::cout << name << " : " << std::fixed << std::setprecision(2) << elapsed_ms << " ms\n";
+    // Formatted apart and written at once: concurrent calls time their phases
+    // too, and manipulators on std::cout itself would race
+    std::ostringstream line;
+    line << name << " : " << std::fixed << std::setprecision(2) << elapsed_ms << " ms" << note << "\n";
+    std::cout << line.str();
   }
 };
-#define SCOPED_TIMER(name) ScopedTimer _timer##__LINE__(name)
 #else
-#define SCOPED_TIMER(name) ((void)0)
+class ScopedTimer
+{
+ public:
+  explicit ScopedTimer(std::string_view) {}
+  void setNote(const std::string&) {}
+};
+#endif
+#define NAMED_SCOPED_TIMER(timer, name) \
+  ScopedTimer timer(name);               \
+  const detail::ProgressPhase DBSCAN_CONCAT(_phase, __LINE__)(name)
+#ifdef MEASURE_TIMING
+#define SCOPED_TIMER(name) NAMED_SCOPED_TIMER(DBSCAN_CONCAT(_timer, __LINE__), name)
+#else
+#define SCOPED_TIMER(name) const detail::ProgressPhase DBSCAN_CONCAT(_phase, __LINE__)(name)
 #endif
 
 } // namespace dbscan
@@ -0,0 +1,241 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+#if defined(__SSSE3__)
+#include <immintrin.h>
+#endif
+
+namespace dbscan
+{
+
+namespace detail
+{
+// Stream-vbyte tables indexed by a control byte (four 2-bit length codes):
+// the data bytes of its group and, per byte of the four 32-bit values, the
+// data byte to take (0xFF: zero)
+struct VByteGroupTables {
+  std::array<uint8_t, 256> length{};
+  std::array<std::array<uint8_t, 16>, 256> shuffle{};
+
+  constexpr VByteGroupTables()
+  {
+    for (uint32_t key = 0; key < 256; ++key) {
+      uint8_t offset = 0;
+      for (uint32_t lane = 0; lane < 4; ++lane) {
+        const uint32_t bytes = ((key >> (2 * lane)) & 3) + 1;
+        for (uint32_t b = 0; b < 4; ++b) {
+          shuffle[key][(4 * lane) + b] = b < bytes ? static_cast<uint8_t>(offset + b) : 0xFF;
+        }
+        offset = static_cast<uint8_t>(offset + bytes);
+      }
+      length[key] = offset;
+    }
+  }
+};
+inline constexpr VByteGroupTables kVByteGroupTables{};
+} // namespace detail
+
+// Neighbor graph in compressed form, ~1-2.5 bytes per edge instead of 8.
+// Points are renumbered in grid-cell order (rank), where neighbors sit close
+// together, so the sorted ranks of a neighbor list are delta coded into small
+// integers. Per point the list is stored stream-vbyte style: 2-bit length
+// codes (four per control byte) followed by the 1-4 byte little-endian values.
+// The first value is the zigzag-coded distance to the point's own rank, the
+// following ones the gaps to the previous rank.
+// Iteration decodes on the fly, a group of four values per control byte (one
+// byte shuffle and a prefix sum with SSSE3), and yields the original point
+// indices. The byte buffer is padded so a group may always load 16 bytes.
+class CompressedNeighborList
+{
+ public:
+  class Iterator
+  {
+   public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = size_t;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const size_t*;
+    using reference = size_t;
+
+    Iterator(const CompressedNeighborList* list, const uint8_t* control, const uint8_t* data, uint32_t index, uint32_t count, uint32_t rank)
+      : mList(list), mControl(control), mData(data), mIndex(index), mCount(count), mRank(rank)
+    {
+      if (mIndex < mCount) {
+        decodeGroup();
+      }
+    }
+
+    size_t operator*() const { return mList->mOrder[mGroup[mIndex & 3]]; }
+
+    Iterator& operator++()
+    {
+      if (++mIndex < mCount && (mIndex & 3) == 0) {
+        decodeGroup();
+      }
+      return *this;
+    }
+
+    bool operator==(const Iterator& other) const { return mIndex == other.mIndex; }
+    bool operator!=(const Iterator& other) const { return mIndex != other.mIndex; }
+
+   private:
+    // Ranks of values mIndex .. mIndex + 3; lanes past mCount are garbage
+    void decodeGroup()
+    {
+      const uint8_t key = mControl[mIndex >> 2];
+      const auto& tables = detail::kVByteGroupTables;
+#if defined(__SSSE3__)
+      const __m128i data = _mm_loadu_si128(reinterpret_cast<const __m128i*>(mData));
+      const __m128i shuffle = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tables.shuffle[key].data()));
+      __m128i values = _mm_shuffle_epi8(data, shuffle);
+      uint32_t base = mRank;
+      if (mIndex == 0) {
+        base = firstRank(static_cast<uint32_t>(_mm_cvtsi128_si32(values)));
+        values = _mm_and_si128(values, _mm_set_epi32(-1, -1, -1, 0));
+      }
+      values = _mm_add_epi32(values, _mm_slli_si128(values, 4));
+      values = _mm_add_epi32(values, _mm_slli_si128(values, 8));
+      values = _mm_add_epi32(values, _mm_set1_epi32(static_cast<int32_t>(base)));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(mGroup.data()), values);
+#else
+      uint32_t rank = mRank;
+      for (uint32_t lane = 0; lane < 4; ++lane) {
+        uint32_t value = 0;
+        for (uint32_t b = 0; b < 4; ++b) {
+          const uint8_t from = tables.shuffle[key][(4 * lane) + b];
+          value |= from == 0xFF ? 0 : static_cast<uint32_t>(mData[from]) << (8 * b);
+        }
+        rank = (lane == 0 && mIndex == 0) ? firstRank(value) : rank + value;
+        mGroup[lane] = rank;
+      }
+#endif
+      mRank = mGroup[3];
+      mData += tables.length[key];
+    }
+
+    // zigzag: even -> +v/2, odd -> -(v+1)/2, relative to the own rank
+    [[nodiscard]] uint32_t firstRank(uint32_t value) const
+    {
+      return (value & 1) ? mRank - ((value + 1) >> 1) : mRank + (value >> 1);
+    }
+
+    const CompressedNeighborList* mList;
+    const uint8_t* mControl;
+    const uint8_t* mData;
+    uint32_t mIndex;
+    uint32_t mCount;
+    uint32_t mRank; // own rank before the first group, then the last rank decoded
+    std::array<uint32_t, 4> mGroup{};
+  };
+
+  struct Range {
+    Iterator first;
+    Iterator last;
+    [[nodiscard]] Iterator begin() const { return first; }
+    [[nodiscard]] Iterator end() const { return last; }
+  };
+
+  [[nodiscard]] int32_t getSize(size_t i) const
+  {
+    return static_cast<int32_t>(mCounts[i]);
+  }
+
+  // Sum of all list sizes
+  [[nodiscard]] size_t edges() const { return mEdges; }
+
+  [[nodiscard]] Range getNeighbors(size_t i) const
+  {
+    const uint8_t* control = mBytes.data() + mOffsets[i];
+    const uint32_t count = mCounts[i];
+    const uint8_t* data = control + ((count + 3) / 4);
+    return {Iterator(this, control, data, 0, count, mRank[i]), Iterator(this, control, data, count, count, 0)};
+  }
+
+  // Bytes held by the graph, for diagnostics
+  [[nodiscard]] size_t memoryBytes() const
+  {
+    return mBytes.capacity() + (mOffsets.capacity() * sizeof(size_t)) +
+           ((mCounts.capacity() + mOrder.capacity() + mRank.capacity()) * sizeof(uint32_t));
+  }
+
+  // Renumbering: order[rank] = point index, rank[point index] = rank
+  std::vector<uint32_t>& order() { return mOrder; }
+  std::vector<uint32_t>& rank() { return mRank; }
+  [[nodiscard]] uint32_t rankOf(size_t i) const { return mRank[i]; }
+
+  // Encode one sorted list of neighbor ranks of the point with rank `own`,
+  // appending to `bytes`; returns the number of bytes written
+  static size_t encode(uint32_t own, const std::vector<uint32_t>& sortedRanks, std::vector<uint8_t>& bytes)
+  {
+    const size_t start = bytes.size();
+    const size_t count = sortedRanks.size();
+    const size_t controlBytes = (count + 3) / 4;
+    bytes.resize(start + controlBytes, 0);
+    uint32_t previous = own;
+    for (size_t j = 0; j < count; ++j) {
+      uint32_t value;
+      if (j == 0) {
+        value = sortedRanks[0] >= own ? 2 * (sortedRanks[0] - own) : (2 * (own - sortedRanks[0])) - 1;
+      } else {
+        value = sortedRanks[j] - previous;
+      }
+      previous = sortedRanks[j];
+      const uint32_t length = value < (1U << 8) ? 1 : value < (1U << 16) ? 2 : value < (1U << 24) ? 3 : 4;
+      bytes[start + (j >> 2)] |= static_cast<uint8_t>((length - 1) << ((j & 3) * 2));
+      for (uint32_t b = 0; b < length; ++b) {
+        bytes.push_back(static_cast<uint8_t>(value >> (8 * b)));
+      }
+    }
+    return bytes.size() - start;
+  }
+
+  // Build from per-block encodings: block k covers points [begins[k], next
+  // begin) with `bytes` laid out in point order and per-point local offsets
+  struct Block {
+    size_t begin{0};
+    std::vector<uint8_t> bytes;
+    std::vector<size_t> localOffsets;
+    std::vector<uint32_t> counts;
+  };
+  void assemble(size_t n, std::vector<Block>& blocks)
+  {
+    std::sort(blocks.begin(), blocks.end(), [](const Block& a, const Block& b) { return a.begin < b.begin; });
+    size_t total = 0;
+    for (const auto& block : blocks) {
+      total += block.bytes.size();
+    }
+    mBytes.clear();
+    mBytes.reserve(total + kPadding);
+    mOffsets.resize(n);
+    mCounts.resize(n);
+    mEdges = 0;
+    for (const auto& block : blocks) {
+      const size_t base = mBytes.size();
+      for (size_t k = 0; k < block.localOffsets.size(); ++k) {
+        mOffsets[block.begin + k] = base + block.localOffsets[k];
+        mCounts[block.begin + k] = block.counts[k];
+        mEdges += block.counts[k];
+      }
+      mBytes.insert(mBytes.end(), block.bytes.begin(), block.bytes.end());
+    }
+    mBytes.resize(mBytes.size() + kPadding, 0);
+  }
+
+ private:
+  // A group decode reads up to 16 bytes from its first data byte
+  static constexpr size_t kPadding = 16;
+
+  std::vector<uint8_t> mBytes;
+  std::vector<size_t> mOffsets;
+  std::vector<uint32_t> mCounts;
+  std::vector<uint32_t> mOrder;
+  std::vector<uint32_t> mRank;
+  size_t mEdges{0};
+};
+
+} // namespace dbscan
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+namespace dbscan
+{
+
+// IEEE binary16 storage. Conversions are branch-free bit manipulation so
+// loops over arrays of them vectorize (F16C/NEON need no special casing).
+struct Float16 {
+  uint16_t bits{0};
+
+  static Float16 fromFloat(float f)
+  {
+    // round to nearest even; overflow to inf, NaN stays NaN
+    uint32_t x = std::bit_cast<uint32_t>(f);
+    const auto sign = static_cast<uint16_t>((x >> 16) & 0x8000U);
+    x &= 0x7FFFFFFFU;
+    if (x >= 0x47800000U) {
+      return {static_cast<uint16_t>(sign | (x > 0x7F800000U ? 0x7E00U : 0x7C00U))};
+    }
+    if (x < 0x38800000U) {
+      // subnormal: let the FPU round by adding 0.5, which aligns the mantissa
+      const float denorm = std::bit_cast<float>(x) + 0.5f;
+      return {static_cast<uint16_t>(sign | (std::bit_cast<uint32_t>(denorm) - 0x3F000000U))};
+    }
+    const uint32_t odd = (x >> 13) & 1U;
+    x += (static_cast<uint32_t>(15 - 127) << 23) + 0xFFFU + odd;
+    return {static_cast<uint16_t>(sign | (x >> 13))};
+  }
+
+  [[nodiscard]] float toFloat() const
+  {
+    // rebias by multiplication, which also normalizes subnormals
+    const uint32_t magnitude = bits & 0x7FFFU;
+    const float scaled = std::bit_cast<float>(magnitude << 13) * 0x1p112f;
+    const uint32_t special = magnitude >= 0x7C00U ? 0x7F800000U : 0U;
+    return std::bit_cast<float>(std::bit_cast<uint32_t>(scaled) | special | (static_cast<uint32_t>(bits & 0x8000U) << 16));
+  }
+
+  friend bool operator<(Float16 a, Float16 b) { return a.toFloat() < b.toFloat(); }
+};
+
+// bfloat16 storage: the upper half of a float, same range, 8 bit mantissa
+struct BFloat16 {
+  uint16_t bits{0};
+
+  static BFloat16 fromFloat(float f)
+  {
+    const uint32_t x = std::bit_cast<uint32_t>(f);
+    if ((x & 0x7FFFFFFFU) > 0x7F800000U) {
+      return {static_cast<uint16_t>((x >> 16) | 0x40U)}; // quiet NaN
+    }
+    return {static_cast<uint16_t>((x + 0x7FFFU + ((x >> 16) & 1U)) >> 16)}; // round to nearest even
+  }
+
+  [[nodiscard]] float toFloat() const { return std::bit_cast<float>(static_cast<uint32_t>(bits) << 16); }
+
+  friend bool operator<(BFloat16 a, BFloat16 b) { return a.toFloat() < b.toFloat(); }
+};
+
+// Coordinate scalar types accepted by DBSCAN::cluster().
+// Storage is the type in the caller's array, Compute the type differences and
+// eps comparisons are evaluated in (wide enough that a difference of two
+// coordinates cannot overflow), Real the type used for approximate geometry
+// such as projections.
+//
+// Integer coordinates (digitized pad/row/timebin indices) are handled
+// exactly: eps is truncated to an integer E (|a - b| <= eps <=> |a - b| <= E),
+// cells are max(E, 1) wide and cell keys come from integer division, or a
+// shift when the cell width is a power of two.
+// double computes in double (meter precision at continental scale); the 16
+// bit float types are storage only and compute in float, trading precision
+// for half the memory bandwidth.
+template <typename T>
+struct CoordTraits {
+  static_assert(std::is_arithmetic_v<T>, "unsupported coordinate type");
+
+  using Storage = T;
+  using Compute = std::conditional_t<std::is_integral_v<T>, std::conditional_t<(sizeof(T) <= 2), int32_t, int64_t>, T>;
+  using Real = std::conditional_t<(sizeof(Compute) > 4), double, float>;
+  static constexpr bool kIntegral = std::is_integral_v<T>;
+
+  static Compute load(T v) { return static_cast<Compute>(v); }
+
+  static Compute toEps(float eps)
+  {
+    if constexpr (kIntegral) {
+      return static_cast<Compute>(std::floor(eps));
+    } else {
+      return static_cast<Compute>(eps);
+    }
+  }
+
+  static Compute toCellSize(float eps)
+  {
+    if constexpr (kIntegral) {
+      return std::max<Compute>(toEps(eps), 1);
+    } else {
+      return static_cast<Compute>(eps);
+    }
+  }
+};
+
+template <typename T>
+struct HalfCoordTraits {
+  using Storage = T;
+  using Compute = float;
+  using Real = float;
+  static constexpr bool kIntegral = false;
+
+  static float load(T v) { return v.toFloat(); }
+  static float toEps(float eps) { return eps; }
+  static float toCellSize(float eps) { return eps; }
+};
+
+template <>
+struct CoordTraits<Float16> : HalfCoordTraits<Float16> {};
+template <>
+struct CoordTraits<BFloat16> : HalfCoordTraits<BFloat16> {};
+
+// Coordinate types the library is instantiated for; X(type) per entry
+#define DBSCAN_FOR_EACH_COORD_TYPE(X) \
+  X(float)                            \
+  X(double)                           \
+  X(Float16)                          \
+  X(BFloat16)                         \
+  X(int16_t)                          \
+  X(int32_t)
+
+} // namespace dbscan
+
+// Extremes, used as min/max seeds for bounding boxes
+template <>
+struct std::numeric_limits<dbscan::Float16> {
+  static constexpr bool is_specialized = true;
+  static constexpr dbscan::Float16 max() { return {0x7BFFU}; }
+  static constexpr dbscan::Float16 lowest() { return {0xFBFFU}; }
+};
+template <>
+struct std::numeric_limits<dbscan::BFloat16> {
+  static constexpr bool is_specialized = true;
+  static constexpr dbscan::BFloat16 max() { return {0x7F7FU}; }
+  static constexpr dbscan::BFloat16 lowest() { return {0xFF7FU}; }
+};
@@ -0,0 +1,161 @@
+#pragma once
+
+#include "DBSCAN.h"
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace dbscan
+{
+
+// Frames travel through a shared-memory region each client creates
+// (memfd) and hands to the daemon once, over a Unix-domain socket. The
+// region is a header followed by nSlots slots; a slot holds up to capacity
+// points (NDim floats each) and, behind them, their labels. Only small
+// messages cross the socket afterwards: a request names a slot, the reply
+// says its labels are ready.
+struct DaemonRingHeader {
+  uint32_t magic;
+  uint32_t nDim;
+  uint32_t nSlots;
+  uint32_t capacity; // points per slot
+};
+
+constexpr uint32_t kDaemonMagic = 0x44425344; // "DBSD"
+
+inline size_t daemonAlign(size_t bytes)
+{
+  return (bytes + 63) & ~size_t{63};
+}
+
+inline size_t daemonSlotBytes(uint32_t capacity)
+{
+  return daemonAlign(size_t{capacity} * NDim * sizeof(float)) + daemonAlign(size_t{capacity} * sizeof(int32_t));
+}
+
+inline size_t daemonRegionBytes(uint32_t nSlots, uint32_t capacity)
+{
+  return daemonAlign(sizeof(DaemonRingHeader)) + (size_t{nSlots} * daemonSlotBytes(capacity));
+}
+
+inline float* daemonSlotPoints(void* region, uint32_t capacity, uint32_t slot)
+{
+  return reinterpret_cast<float*>(static_cast<char*>(region) + daemonAlign(sizeof(DaemonRingHeader)) + (slot * daemonSlotBytes(capacity)));
+}
+
+inline int32_t* daemonSlotLabels(void* region, uint32_t capacity, uint32_t slot)
+{
+  return reinterpret_cast<int32_t*>(reinterpret_cast<char*>(daemonSlotPoints(region, capacity, slot)) + daemonAlign(size_t{capacity} * NDim * sizeof(float)));
+}
+
+// Socket messages (SOCK_SEQPACKET, one message each)
+struct DaemonRequest {
+  uint32_t slot;
+  uint32_t n;        // points written to the slot
+  int32_t priority;  // higher runs first; equal priorities in order of arrival
+  uint32_t reserved;
+  uint64_t tag;      // echoed in the reply
+};
+
+struct DaemonReply {
+  uint32_t slot;
+  int32_t status;    // 0, or -1 for a request naming a bad slot or too many points
+  int32_t nClusters;
+  int32_t nNoise;
+  uint64_t tag;
+};
+
+// Clustering service for the processes of one node: a single tuned engine
+// and thread pool instead of one per process. Requests that arrive
+// together are queued by priority and served by nWorkers threads, which run
+// their frames concurrently in the engine's shared task arena.
+//
+// Clients are trusted: the daemon reads the points in place while the
+// client could still write them. The socket is created with mode 0600, so
+// only processes of the same user can connect.
+class DBSCANDaemon
+{
+ public:
+  DBSCANDaemon(const DBSCANParams& p, std::string socketPath, size_t nWorkers = 2);
+  ~DBSCANDaemon();
+
+  DBSCANDaemon(const DBSCANDaemon&) = delete;
+  DBSCANDaemon& operator=(const DBSCANDaemon&) = delete;
+
+  // Serve clients until stop(); false if the socket could not be set up
+  bool run();
+  // Thread- and signal-safe
+  void stop();
+
+ private:
+  struct Client;
+  struct Job {
+    std::shared_ptr<Client> client;
+    DaemonRequest request;
+    uint64_t sequence;
+  };
+  struct JobOrder {
+    bool operator()(const Job& a, const Job& b) const
+    {
+      return a.request.priority != b.request.priority ? a.request.priority < b.request.priority : a.sequence > b.sequence;
+    }
+  };
+
+  bool acceptClient();
+  bool receiveHello(Client& client);
+  bool readRequests(const std::shared_ptr<Client>& client);
+  void runWorker();
+  void serve(const Job& job);
+
+  DBSCAN mEngine;
+  std::string mSocketPath;
+  size_t mNumWorkers;
+  int mListenFd{-1};
+  int mStopFd{-1}; // eventfd
+  int mEpollFd{-1};
+  std::map<int, std::shared_ptr<Client>> mClients;
+  uint64_t mSequence{0};
+
+  std::mutex mMutex;
+  std::condition_variable mCondition;
+  std::priority_queue<Job, std::vector<Job>, JobOrder> mJobs;
+  bool mStopping{false};
+  std::vector<std::thread> mWorkers;
+};
+
+// Client side: creates the region, connects and submits frames. Write up
+// to capacity() points to points(slot), submit(slot, n), and read
+// labels(slot) once wait() returns its reply. A slot must not be reused
+// before its reply. Not thread-safe.
+class DBSCANDaemonClient
+{
+ public:
+  DBSCANDaemonClient(const std::string& socketPath, uint32_t nSlots = 4, uint32_t capacity = 1U << 20);
+  ~DBSCANDaemonClient();
+
+  DBSCANDaemonClient(const DBSCANDaemonClient&) = delete;
+  DBSCANDaemonClient& operator=(const DBSCANDaemonClient&) = delete;
+
+  [[nodiscard]] bool connected() const { return mSocket >= 0; }
+  [[nodiscard]] uint32_t capacity() const { return mCapacity; }
+  [[nodiscard]] float* points(uint32_t slot) const { return daemonSlotPoints(mRegion, mCapacity, slot); }
+  [[nodiscard]] const int32_t* labels(uint32_t slot) const { return daemonSlotLabels(mRegion, mCapacity, slot); }
+
+  bool submit(uint32_t slot, uint32_t n, int32_t priority = 0, uint64_t tag = 0);
+  // Next finished request, in order of completion
+  bool wait(DaemonReply& reply);
+
+ private:
+  int mSocket{-1};
+  void* mRegion{nullptr};
+  size_t mRegionBytes{0};
+  uint32_t mCapacity{0};
+};
+
+} // namespace dbscan
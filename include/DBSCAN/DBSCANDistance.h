@@ -1,25 +1,42 @@
 #pragma once
 
 #include "DBSCAN/DBSCANCommon.h"
+#include "DBSCAN/DBSCANCoord.h"
+#include <algorithm>
+#include <array>
 #include <cmath>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
 
 namespace dbscan
 {
 
-class DBSCANDistance
+// Neighbor tests for coordinates of type T, evaluated in CoordTraits<T>::Compute
+// (exact for integer coordinates)
+template <typename T>
+class BasicDistance
 {
   using EPS = decltype(DBSCANParams::eps);
+  using Traits = CoordTraits<T>;
+  using Compute = typename Traits::Compute;
 
  public:
-  DBSCANDistance(const EPS& eps) : mEps(eps) {}
+  BasicDistance(const EPS& eps)
+  {
+#pragma unroll(NDim)
+    for (size_t d = 0; d < NDim; ++d) {
+      mEps[d] = Traits::toEps(eps[d]);
+    }
+  }
 
   // Check if two points are neighbors using L-infinity distance
   // Returns true if ALL dimensions are within their respective thresholds
-  inline bool areNeighbors(const float* p1, const float* p2) const
+  inline bool areNeighbors(const T* p1, const T* p2) const
   {
 #pragma unroll(NDim)
     for (size_t d{0}; d < NDim; ++d) {
-      const float diff = std::abs(p1[d] - p2[d]);
+      const Compute diff = std::abs(Traits::load(p1[d]) - Traits::load(p2[d]));
       if (diff > mEps[d]) {
         return false;
       }
@@ -27,12 +44,78 @@ class DBSCANDistance
     return true;
   }
 
+  // Tile test: is any of `count` points, stored as one array per dimension,
+  // within eps of query? Branch-free inner loop so it vectorizes; used for
+  // dense cell pairs where early exit per pair costs more than it saves.
+  inline bool anyNeighbor(const T* query, const std::array<const T*, NDim>& soa, size_t count) const
+  {
+    if constexpr (std::is_same_v<T, int16_t>) {
+      return anyNeighborInWindow(query, soa, count);
+    }
+    constexpr size_t kTile = 16;
+    for (size_t b = 0; b < count; b += kTile) {
+      const size_t e = std::min(count, b + kTile);
+      bool hit = false;
+      for (size_t k = b; k < e; ++k) {
+        bool inside = true;
+#pragma unroll(NDim)
+        for (size_t d = 0; d < NDim; ++d) {
+          inside &= std::abs(Traits::load(query[d]) - Traits::load(soa[d][k])) <= mEps[d];
+        }
+        hit |= inside;
+      }
+      if (hit) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // anyNeighbor() for int16_t: the window [query - eps, query + eps],
+  // clamped to the int16_t range, holds exactly the coordinates within eps.
+  // Testing uint16_t(x - lower) <= width keeps every lane 16 bits wide (twice
+  // the int32_t differences per vector) and the loop free of branches
+  inline bool anyNeighborInWindow(const T* query, const std::array<const T*, NDim>& soa, size_t count) const
+  {
+    constexpr size_t kTile = 32;
+    std::array<uint16_t, NDim> lower, width;
+#pragma unroll(NDim)
+    for (size_t d = 0; d < NDim; ++d) {
+      const int64_t q = query[d];
+      const int64_t lo = std::max<int64_t>(q - mEps[d], std::numeric_limits<int16_t>::min());
+      const int64_t hi = std::min<int64_t>(q + mEps[d], std::numeric_limits<int16_t>::max());
+      lower[d] = static_cast<uint16_t>(lo);
+      width[d] = static_cast<uint16_t>(hi - lo);
+    }
+    for (size_t b = 0; b < count; b += kTile) {
+      const size_t n = std::min(count - b, kTile);
+      std::array<uint16_t, kTile> inside;
+      inside.fill(0xFFFF);
+      // One pass per dimension keeps each loop a single vectorizable sweep
+      for (size_t d = 0; d < NDim; ++d) {
+        const T* column = soa[d] + b;
+        for (size_t k = 0; k < n; ++k) {
+          const auto offset = static_cast<uint16_t>(static_cast<uint16_t>(column[k]) - lower[d]);
+          inside[k] = static_cast<uint16_t>(inside[k] & (offset <= width[d] ? 0xFFFF : 0));
+        }
+      }
+      uint16_t hit = 0;
+      for (size_t k = 0; k < n; ++k) {
+        hit = static_cast<uint16_t>(hit | inside[k]);
+      }
+      if (hit != 0) {
+        return true;
+      }
+    }
+    return false;
+  }
+
   // Batch compute
-  void computeNeighbors(const float* query, const float* points, const std::vector<size_t>& candidates, std::vector<size_t>& neighbors) const
+  void computeNeighbors(const T* query, const T* points, const std::vector<size_t>& candidates, std::vector<size_t>& neighbors) const
   {
     neighbors.clear();
     for (auto idx : candidates) {
-      const float* p = &points[idx * NDim];
+      const T* p = &points[idx * NDim];
       if (areNeighbors(query, p)) {
         neighbors.push_back(idx);
       }
@@ -40,7 +123,9 @@ class DBSCANDistance
   }
 
  private:
-  EPS mEps;
+  std::array<Compute, NDim> mEps;
 };
 
+using DBSCANDistance = BasicDistance<float>;
+
 } // namespace dbscan
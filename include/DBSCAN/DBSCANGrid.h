@@ -1,12 +1,15 @@
 #pragma once
 
 #include "DBSCANCommon.h"
+#include "DBSCANCoord.h"
 #include <cstddef>
 #include <cstdint>
 #include <vector>
 #include <array>
 #include <cmath>
 #include <algorithm>
+#include <bit>
+#include <limits>
 
 namespace dbscan
 {
@@ -17,12 +20,29 @@ using GridCell = std::vector<size_t>;
 //  Grid coordinates
 using GridCoord = std::array<int32_t, NDim>;
 
-// Supports different cell sizes per dimension
-class Grid
+// Supports different cell sizes per dimension and any coordinate type with
+// CoordTraits; cellSizes are eps, converted per the traits
+template <typename T>
+class BasicGrid
 {
+  using Traits = CoordTraits<T>;
+  using Compute = typename Traits::Compute;
+
  public:
-  Grid(const float* points, size_t n, const std::array<float, NDim>& cellSizes)
-    : mPoints(points), mNPoints(n), mCellSizes(cellSizes) {}
+  BasicGrid(const T* points, size_t n, const std::array<float, NDim>& cellSizes)
+    : mPoints(points), mNPoints(n)
+  {
+#pragma unroll(NDim)
+    for (size_t d = 0; d < NDim; ++d) {
+      mCellSizes[d] = Traits::toCellSize(cellSizes[d]);
+      mShifts[d] = -1;
+      if constexpr (Traits::kIntegral) {
+        if ((mCellSizes[d] & (mCellSizes[d] - 1)) == 0) {
+          mShifts[d] = static_cast<int32_t>(std::countr_zero(static_cast<uint64_t>(mCellSizes[d])));
+        }
+      }
+    }
+  }
 
   void initGrid()
   {
@@ -45,13 +65,20 @@ class Grid
   }
 
   // Get grid coordinates for a point
-  [[nodiscard]] GridCoord getGridCoords(size_t idx) const
+  [[nodiscard]] GridCoord getGridCoords(size_t idx) const { return getGridCoordsOf(&mPoints[idx * NDim]); }
+
+  // Get grid coordinates for any NDim coordinates, clamped to the grid
+  [[nodiscard]] GridCoord getGridCoordsOf(const T* point) const
   {
     GridCoord coords{};
 #pragma unroll(NDim)
     for (size_t d = 0; d < NDim; ++d) {
-      float val = mPoints[(idx * NDim) + d];
-      coords[d] = static_cast<int32_t>((val - mMinBounds[d]) / mCellSizes[d]);
+      const Compute offset = Traits::load(point[d]) - mMinBounds[d];
+      if constexpr (Traits::kIntegral) {
+        coords[d] = static_cast<int32_t>(mShifts[d] >= 0 ? offset >> mShifts[d] : offset / mCellSizes[d]);
+      } else {
+        coords[d] = static_cast<int32_t>(offset / mCellSizes[d]);
+      }
       coords[d] = std::clamp(coords[d], 0, static_cast<int32_t>(mGridDims[d]) - 1);
     }
     return coords;
@@ -81,6 +108,120 @@ class Grid
     return &mCells[getCellIndex(coords)];
   }
 
+  // Number of cells and access by flat index
+  [[nodiscard]] size_t getNCells() const { return mCells.size(); }
+  [[nodiscard]] const GridCell& getCellAt(size_t index) const { return mCells[index]; }
+
+  // Get grid coordinates from a flat index (inverse of getCellIndex)
+  [[nodiscard]] GridCoord getCellCoords(size_t index) const
+  {
+    GridCoord coords{};
+#pragma unroll(NDim)
+    for (size_t d = 0; d < NDim; ++d) {
+      coords[d] = static_cast<int32_t>(index % mGridDims[d]);
+      index /= mGridDims[d];
+    }
+    return coords;
+  }
+
+  // Get flat indices of the neighboring cells (including the cell itself)
+  void getNeighborCellIndices(const GridCoord& coords, std::vector<size_t>& neighbors) const
+  {
+    neighbors.clear();
+    size_t nOffsets = 1;
+    for (size_t d = 0; d < NDim; ++d) {
+      nOffsets *= 3;
+    }
+    for (size_t o = 0; o < nOffsets; ++o) {
+      GridCoord nbr;
+      bool inside = true;
+      size_t code = o;
+#pragma unroll(NDim)
+      for (size_t d = 0; d < NDim; ++d) {
+        nbr[d] = coords[d] + static_cast<int32_t>(code % 3) - 1;
+        code /= 3;
+        inside = inside && nbr[d] >= 0 && nbr[d] < static_cast<int32_t>(mGridDims[d]);
+      }
+      if (inside) {
+        neighbors.push_back(getCellIndex(nbr));
+      }
+    }
+  }
+
+  // Optional compact copy of the coordinates for bandwidth-bound neighbor
+  // search: points in cell order (cell c starts at getCompactBegin(c)), each
+  // as NDim 16-bit offsets from its cell origin in units of cellSize / kCompactScale.
+  // 16 bits span two cells, which covers the wider clamped last cell.
+  // Quantization and float rounding are bounded by getCompactMargin() units.
+  // Floating-point coordinates only: for integer T this is a no-op, their
+  // exact test needs no compact copy (hasCompactCoords() stays false).
+  // Parallel over cells; call from within the engine's task arena.
+  static constexpr int32_t kCompactScale = 32768;
+  using CompactCoord = std::array<uint16_t, NDim>;
+
+  void buildCompactCoords()
+  {
+    if constexpr (!Traits::kIntegral) {
+      SCOPED_TIMER("\t\tbuildCompactCoords");
+      std::array<double, NDim> units{};
+#pragma unroll(NDim)
+      for (size_t d = 0; d < NDim; ++d) {
+        // a few ulps of the largest coordinate: covers the float cell
+        // assignment and the rounding of the exact test
+        const Compute extent = std::max(std::abs(mMinBounds[d]), std::abs(mMaxBounds[d]));
+        const Compute ulp = std::nextafter(extent, std::numeric_limits<Compute>::max()) - extent;
+        const double margin = 8. * static_cast<double>(ulp) / static_cast<double>(mCellSizes[d]) * kCompactScale;
+        mCompactMargin[d] = 2 + static_cast<int32_t>(std::min(std::ceil(margin), double(kCompactScale)));
+        units[d] = kCompactScale / static_cast<double>(mCellSizes[d]);
+      }
+      const size_t nCells = mCells.size();
+      mCompactBegin.resize(nCells + 1);
+      parallelFor(0, nCells, [&](size_t begin, size_t end) {
+        for (size_t c = begin; c < end; ++c) {
+          mCompactBegin[c] = mCells[c].size();
+        }
+      });
+      mCompactBegin[nCells] = parallelExclusiveScan(mCompactBegin.data(), mCompactBegin.data(), nCells);
+      mCompactCoords.resize(mCompactBegin[nCells]);
+      parallelFor(0, nCells, [&](size_t begin, size_t end) {
+        for (size_t c = begin; c < end; ++c) {
+          if (mCells[c].empty()) {
+            continue;
+          }
+          const auto coords = getCellCoords(c);
+          std::array<double, NDim> origin;
+#pragma unroll(NDim)
+          for (size_t d = 0; d < NDim; ++d) {
+            origin[d] = static_cast<double>(mMinBounds[d]) + (static_cast<double>(coords[d]) * static_cast<double>(mCellSizes[d]));
+          }
+          CompactCoord* out = &mCompactCoords[mCompactBegin[c]];
+          for (auto idx : mCells[c]) {
+#pragma unroll(NDim)
+            for (size_t d = 0; d < NDim; ++d) {
+              const double offset = (static_cast<double>(Traits::load(mPoints[(idx * NDim) + d])) - origin[d]) * units[d];
+              (*out)[d] = static_cast<uint16_t>(std::clamp(std::floor(offset), 0., 65535.));
+            }
+            ++out;
+          }
+        }
+      });
+    }
+  }
+
+  [[nodiscard]] bool hasCompactCoords() const { return !mCompactBegin.empty(); }
+  [[nodiscard]] const CompactCoord* getCompactCoords(size_t cell) const { return &mCompactCoords[mCompactBegin[cell]]; }
+  [[nodiscard]] const std::array<int32_t, NDim>& getCompactMargin() const { return mCompactMargin; }
+
+  // Incremental re-binning (DBSCANWarmStart): idx has moved from cell
+  // `from` to cell `to`; order within a cell is not preserved
+  void moveCell(size_t idx, size_t from, size_t to)
+  {
+    auto& source = mCells[from];
+    *std::find(source.begin(), source.end(), idx) = source.back();
+    source.pop_back();
+    mCells[to].push_back(idx);
+  }
+
   // Get neighboring cells (including the cell itself)
   void getNeighborCells(const GridCoord& coords, std::vector<const GridCell*>& neighbors) const
   {
@@ -115,12 +256,12 @@ class Grid
 
   void computeBounds()
   {
-    mMinBounds.fill(std::numeric_limits<float>::max());
-    mMaxBounds.fill(std::numeric_limits<float>::lowest());
+    mMinBounds.fill(std::numeric_limits<Compute>::max());
+    mMaxBounds.fill(std::numeric_limits<Compute>::lowest());
     for (size_t i = 0; i < mNPoints; ++i) {
 #pragma unroll(NDim)
       for (size_t d = 0; d < NDim; ++d) {
-        float val = mPoints[(i * NDim) + d];
+        const Compute val = Traits::load(mPoints[(i * NDim) + d]);
         mMinBounds[d] = std::min(mMinBounds[d], val);
         mMaxBounds[d] = std::max(mMaxBounds[d], val);
       }
@@ -132,14 +273,21 @@ class Grid
     mGridDims.fill(1);
 #pragma unroll(NDim)
     for (size_t d = 0; d < NDim; ++d) {
-      float range = mMaxBounds[d] - mMinBounds[d];
-      mGridDims[d] = std::max(size_t(1), static_cast<size_t>(std::ceil(range / mCellSizes[d])));
+      const Compute range = mMaxBounds[d] - mMinBounds[d];
+      if constexpr (Traits::kIntegral) {
+        mGridDims[d] = static_cast<size_t>(range / mCellSizes[d]) + 1; // exact keys, no clamping needed
+      } else {
+        mGridDims[d] = std::max(size_t(1), static_cast<size_t>(std::ceil(range / mCellSizes[d])));
+      }
     }
   }
 
   void allocateCells()
   {
-    auto total_cells = static_cast<size_t>(mGridDims[0] * mGridDims[1]);
+    size_t total_cells = 1;
+    for (size_t d = 0; d < NDim; ++d) {
+      total_cells *= mGridDims[d];
+    }
     mCells.resize(total_cells);
   }
 
@@ -152,13 +300,19 @@ class Grid
     }
   }
 
-  const float* mPoints;
+  const T* mPoints;
   size_t mNPoints;
-  std::array<float, NDim> mCellSizes;
-  std::array<float, NDim> mMinBounds;
-  std::array<float, NDim> mMaxBounds;
+  std::array<Compute, NDim> mCellSizes;
+  std::array<int32_t, NDim> mShifts; // log2 of an integer power-of-two cell size, else -1
+  std::array<Compute, NDim> mMinBounds;
+  std::array<Compute, NDim> mMaxBounds;
   std::array<size_t, NDim> mGridDims;
   std::vector<GridCell> mCells;
+  std::vector<size_t> mCompactBegin;
+  std::vector<CompactCoord> mCompactCoords;
+  std::array<int32_t, NDim> mCompactMargin{};
 };
 
+using Grid = BasicGrid<float>;
+
 } // namespace dbscan
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+namespace dbscan
+{
+
+// Neighbor graph with implicit whole cells.
+// In dense regions most neighbors of a point are "every point of the cells
+// around me". A cell whose tight bounding box lies within eps of the point is
+// stored as one cell reference; only partially overlapping cells contribute
+// explicit point indices. Iteration walks the referenced cells (skipping the
+// point itself) and then the explicit indices, so consumers see a plain list.
+class HybridNeighborList
+{
+ public:
+  class Iterator
+  {
+   public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = size_t;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const size_t*;
+    using reference = size_t;
+
+    Iterator(const HybridNeighborList* list, size_t self, size_t ref, size_t refEnd, size_t explicitIndex)
+      : mList(list), mSelf(self), mRef(ref), mRefEnd(refEnd), mExplicit(explicitIndex)
+    {
+      if (mRef < mRefEnd) {
+        loadCell();
+        settle();
+      }
+    }
+
+    size_t operator*() const
+    {
+      return mRef < mRefEnd ? mList->mCellPoints[mMember] : mList->mExplicit[mExplicit];
+    }
+
+    Iterator& operator++()
+    {
+      if (mRef < mRefEnd) {
+        ++mMember;
+        settle();
+      } else {
+        ++mExplicit;
+      }
+      return *this;
+    }
+
+    bool operator==(const Iterator& other) const { return mRef == other.mRef && mExplicit == other.mExplicit && mMember == other.mMember; }
+    bool operator!=(const Iterator& other) const { return !(*this == other); }
+
+   private:
+    void loadCell()
+    {
+      mMember = mList->mRefs[mRef].begin;
+      mMemberEnd = mList->mRefs[mRef].end;
+    }
+
+    // Move to the next member that is not the point itself, leaving the
+    // cell phase (mMember = 0) once the last referenced cell is exhausted
+    void settle()
+    {
+      while (true) {
+        if (mMember < mMemberEnd) {
+          if (mList->mCellPoints[mMember] != mSelf) {
+            return;
+          }
+          ++mMember;
+          continue;
+        }
+        if (++mRef == mRefEnd) {
+          mMember = mMemberEnd = 0;
+          return;
+        }
+        loadCell();
+      }
+    }
+
+    const HybridNeighborList* mList;
+    size_t mSelf;
+    size_t mRef;
+    size_t mRefEnd;
+    size_t mExplicit;
+    uint32_t mMember{0};
+    uint32_t mMemberEnd{0};
+  };
+
+  struct Range {
+    Iterator first;
+    Iterator last;
+    [[nodiscard]] Iterator begin() const { return first; }
+    [[nodiscard]] Iterator end() const { return last; }
+  };
+
+  [[nodiscard]] int32_t getSize(size_t i) const
+  {
+    return static_cast<int32_t>(mSizes[i]);
+  }
+
+  // Sum of all list sizes
+  [[nodiscard]] size_t edges() const { return mEdges; }
+
+  [[nodiscard]] Range getNeighbors(size_t i) const
+  {
+    return {Iterator(this, i, mRefOffsets[i], mRefOffsets[i + 1], mExplicitOffsets[i]),
+            Iterator(this, i, mRefOffsets[i + 1], mRefOffsets[i + 1], mExplicitOffsets[i + 1])};
+  }
+
+  // Bytes held by the graph, for diagnostics
+  [[nodiscard]] size_t memoryBytes() const
+  {
+    return ((mRefOffsets.capacity() + mExplicitOffsets.capacity()) * sizeof(size_t)) + (mRefs.capacity() * sizeof(CellRef)) +
+           ((mCellPoints.capacity() + mExplicit.capacity() + mSizes.capacity()) * sizeof(uint32_t));
+  }
+
+  // Points of all cells, cell after cell, copied so the list outlives the
+  // grid; a cell reference is a range [begin, end) into it
+  struct CellRef {
+    uint32_t begin;
+    uint32_t end;
+  };
+  std::vector<uint32_t>& cellPoints() { return mCellPoints; }
+
+  // Per-block output of the neighbor search, concatenated by assemble()
+  struct Block {
+    size_t begin{0};
+    std::vector<CellRef> refs;             // referenced cells, all points of the block
+    std::vector<uint32_t> explicitIndices; // explicit neighbors, all points of the block
+    std::vector<uint32_t> refCounts;       // per point
+    std::vector<uint32_t> explicitCounts;  // per point
+    std::vector<uint32_t> sizes;           // total neighbor count per point
+  };
+  void assemble(size_t n, std::vector<Block>& blocks)
+  {
+    std::sort(blocks.begin(), blocks.end(), [](const Block& a, const Block& b) { return a.begin < b.begin; });
+    size_t nRefs = 0, nExplicit = 0;
+    for (const auto& block : blocks) {
+      nRefs += block.refs.size();
+      nExplicit += block.explicitIndices.size();
+    }
+    mRefs.clear();
+    mRefs.reserve(nRefs);
+    mExplicit.clear();
+    mExplicit.reserve(nExplicit);
+    mRefOffsets.resize(n + 1);
+    mExplicitOffsets.resize(n + 1);
+    mSizes.resize(n);
+    mEdges = 0;
+    for (const auto& block : blocks) {
+      size_t ref = mRefs.size(), expl = mExplicit.size();
+      for (size_t k = 0; k < block.sizes.size(); ++k) {
+        mRefOffsets[block.begin + k] = ref;
+        mExplicitOffsets[block.begin + k] = expl;
+        mSizes[block.begin + k] = block.sizes[k];
+        mEdges += block.sizes[k];
+        ref += block.refCounts[k];
+        expl += block.explicitCounts[k];
+      }
+      mRefs.insert(mRefs.end(), block.refs.begin(), block.refs.end());
+      mExplicit.insert(mExplicit.end(), block.explicitIndices.begin(), block.explicitIndices.end());
+    }
+    mRefOffsets[n] = mRefs.size();
+    mExplicitOffsets[n] = mExplicit.size();
+  }
+
+ private:
+  std::vector<uint32_t> mCellPoints;
+  std::vector<size_t> mRefOffsets;
+  std::vector<CellRef> mRefs;
+  std::vector<size_t> mExplicitOffsets;
+  std::vector<uint32_t> mExplicit;
+  std::vector<uint32_t> mSizes;
+  size_t mEdges{0};
+};
+
+} // namespace dbscan
@@ -0,0 +1,44 @@
+#pragma once
+
+#include "DBSCAN.h"
+#include <mpi.h>
+#include <cstdint>
+#include <vector>
+
+namespace dbscan
+{
+
+// Result of a distributed clustering, for the points the rank passed in
+struct DBSCANMPIResult {
+  std::vector<int64_t> labels; // global cluster id (rank << 32 | local label) or DB_NOISE
+  int64_t nClusters = 0;       // over all ranks
+  int64_t nNoise = 0;          // over all ranks
+};
+
+// DBSCAN over the ranks of an MPI communicator (ENABLE_MPI in CMake).
+// Every rank passes any share of the points. A k-d decomposition with
+// splitting planes at weighted quantiles of a gathered sample gives every
+// rank a box; points move to the owner of their box and to the ranks whose
+// box is within eps (the halo). Each rank runs DBSCAN::cluster() on its box
+// and halo, exactly as on a single node. Owners then report the core flag
+// and cluster of their halo points, which links clusters across boxes; the
+// cross-box links are few, so every rank unites all of them in a replicated
+// union-find and ends with the same global ids.
+//
+// cluster() is collective: all ranks of the communicator must call it.
+class DBSCANMPI
+{
+ public:
+  DBSCANMPI(const DBSCANParams& p, MPI_Comm comm);
+
+  template <typename T>
+  DBSCANMPIResult cluster(const T* points, size_t n) const;
+
+ private:
+  DBSCANParams mParams;
+  DBSCAN mDBSCAN; // the clustering of each box
+  MPI_Comm mComm;
+  mutable TaskArena mTaskArena;
+};
+
+} // namespace dbscan
@@ -0,0 +1,761 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Parallel backend, chosen at configure time (PARALLEL_BACKEND in CMake).
+// Defaults to oneTBB when the header is used without the build system.
+#if !defined(DBSCAN_BACKEND_TBB) && !defined(DBSCAN_BACKEND_OPENMP) && !defined(DBSCAN_BACKEND_STD) && !defined(DBSCAN_BACKEND_SERIAL)
+#define DBSCAN_BACKEND_TBB
+#endif
+
+#if defined(DBSCAN_BACKEND_TBB)
+#include <tbb/blocked_range.h>
+#include <tbb/info.h>
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_reduce.h>
+#include <tbb/parallel_scan.h>
+#include <tbb/parallel_sort.h>
+#include <tbb/task.h>
+#include <tbb/task_arena.h>
+#include <tbb/task_scheduler_observer.h>
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+#elif defined(DBSCAN_BACKEND_OPENMP)
+#include <omp.h>
+#elif defined(DBSCAN_BACKEND_STD)
+#include <execution>
+#include <thread>
+#endif
+
+namespace dbscan
+{
+
+#if defined(DBSCAN_BACKEND_TBB)
+constexpr const char* ParallelBackendName{"tbb"};
+#elif defined(DBSCAN_BACKEND_OPENMP)
+constexpr const char* ParallelBackendName{"openmp"};
+#elif defined(DBSCAN_BACKEND_STD)
+constexpr const char* ParallelBackendName{"std::execution"};
+#else
+constexpr const char* ParallelBackendName{"serial"};
+#endif
+
+namespace detail
+{
+#if defined(DBSCAN_BACKEND_OPENMP)
+// Thread cap of the arena currently executing on this thread (0: runtime default)
+inline thread_local int32_t tArenaThreads{0};
+#endif
+
+// Threads the current call of this thread asked for (0: the whole arena),
+// see TaskArena::Degree
+inline thread_local int32_t tCallThreads{0};
+
+// Chunking for backends without an adaptive partitioner; a few chunks per
+// thread keep dynamic scheduling balanced without per-element overhead
+inline size_t chunkSize(size_t n, size_t grain, size_t nThreads)
+{
+  if (grain > 1) {
+    return grain;
+  }
+  return std::max<size_t>(1, n / (std::max<size_t>(1, nThreads) * 8));
+}
+
+inline size_t hardwareThreads()
+{
+#if defined(DBSCAN_BACKEND_OPENMP)
+  return static_cast<size_t>(tArenaThreads > 0 ? tArenaThreads : omp_get_max_threads());
+#elif defined(DBSCAN_BACKEND_TBB)
+  return static_cast<size_t>(tbb::this_task_arena::max_concurrency());
+#elif defined(DBSCAN_BACKEND_STD)
+  // std::execution has no portable way to report its pool; assume one
+  // thread per hardware thread (1 when the count is unknown)
+  return tCallThreads > 0 ? static_cast<size_t>(tCallThreads) : std::max<size_t>(1, std::thread::hardware_concurrency());
+#else
+  return 1;
+#endif
+}
+
+// Busy-wait hint to the core
+inline void cpuRelax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield");
+#endif
+}
+
+#if defined(DBSCAN_BACKEND_TBB)
+// Pins every worker entering the arena to cpus[slot] and gives it back its
+// own affinity when it leaves; slot 0 belongs to the calling thread, which
+// the caller pins itself if it wants to. The arena must have no more slots
+// than cpus. A worker that cannot be pinned runs where it was allowed to
+// and sets failed.
+class PinningObserver : public tbb::task_scheduler_observer
+{
+ public:
+  PinningObserver(tbb::task_arena& arena, std::vector<int32_t> cpus, std::atomic<bool>& failed)
+    : tbb::task_scheduler_observer(arena), mCpus(std::move(cpus)), mFailed(failed)
+  {
+    observe(true);
+  }
+  ~PinningObserver() override { observe(false); }
+
+  void on_scheduler_entry(bool isWorker) override
+  {
+#if defined(__linux__)
+    const int slot = tbb::this_task_arena::current_thread_index();
+    if (!isWorker || slot < 0 || static_cast<size_t>(slot) >= mCpus.size()) {
+      return;
+    }
+    const int32_t cpu = mCpus[static_cast<size_t>(slot)];
+    cpu_set_t original;
+    if (cpu < 0 || cpu >= CPU_SETSIZE || pthread_getaffinity_np(pthread_self(), sizeof(original), &original) != 0) {
+      mFailed.store(true, std::memory_order_relaxed);
+      return;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(static_cast<size_t>(cpu), &set);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) {
+      mFailed.store(true, std::memory_order_relaxed);
+      return;
+    }
+    const std::lock_guard lock(mMutex);
+    mOriginal.emplace_back(pthread_self(), original);
+#else
+    (void)isWorker;
+#endif
+  }
+
+  void on_scheduler_exit(bool isWorker) override
+  {
+#if defined(__linux__)
+    if (!isWorker) {
+      return;
+    }
+    const std::lock_guard lock(mMutex);
+    const auto saved = std::find_if(mOriginal.begin(), mOriginal.end(), [](const auto& entry) { return pthread_equal(entry.first, pthread_self()) != 0; });
+    if (saved != mOriginal.end()) {
+      pthread_setaffinity_np(pthread_self(), sizeof(saved->second), &saved->second);
+      *saved = mOriginal.back();
+      mOriginal.pop_back();
+    }
+#else
+    (void)isWorker;
+#endif
+  }
+
+ private:
+  std::vector<int32_t> mCpus;
+  std::atomic<bool>& mFailed;
+#if defined(__linux__)
+  std::mutex mMutex;
+  std::vector<std::pair<pthread_t, cpu_set_t>> mOriginal; // affinity of the workers pinned now
+#endif
+};
+#endif
+
+// Thrown on the calling thread by a parallel primitive whose call was
+// stopped; cluster() catches it
+struct Interrupted {
+};
+
+// Cancellation, deadline and progress of one call, polled by the parallel
+// primitives once per block
+class CallControl
+{
+ public:
+  using Progress = std::function<void(std::string_view phase, double fraction)>;
+
+  // Statuses of poll()
+  static constexpr int32_t kRunning = 0;
+  static constexpr int32_t kCancelled = 1;
+  static constexpr int32_t kPastDeadline = 2;
+
+  CallControl(const std::atomic<bool>* cancel, std::chrono::steady_clock::time_point deadline, Progress progress)
+    : mCancel(cancel), mDeadline(deadline), mProgress(std::move(progress))
+  {
+  }
+
+  int32_t poll()
+  {
+    int32_t status = mStatus.load(std::memory_order_relaxed);
+    if (status != kRunning) {
+      return status;
+    }
+    if (mCancel != nullptr && mCancel->load(std::memory_order_relaxed)) {
+      status = kCancelled;
+    } else if (mDeadline != std::chrono::steady_clock::time_point::max() && std::chrono::steady_clock::now() >= mDeadline) {
+      status = kPastDeadline;
+    } else {
+      return kRunning;
+    }
+    mStatus.store(status, std::memory_order_relaxed);
+#if defined(DBSCAN_BACKEND_TBB)
+    // The blocks not started yet are dropped instead of polling one by one
+    if (auto* context = tbb::task::current_context()) {
+      context->cancel_group_execution();
+    }
+#endif
+    return status;
+  }
+
+  void check()
+  {
+    if (poll() != kRunning) {
+      throw Interrupted{};
+    }
+  }
+
+  // Phases nest; enter() returns the enclosing one (and how far it got) for leave()
+  struct Entry {
+    const char* phase;
+    double fraction;
+  };
+  Entry enter(const char* phase)
+  {
+    while (*phase == '\t') {
+      ++phase;
+    }
+    const Entry previous{mPhase.exchange(phase, std::memory_order_relaxed), mFraction.exchange(0.0, std::memory_order_relaxed)};
+    report(phase, 0.0);
+    return previous;
+  }
+  void leave(const Entry& previous)
+  {
+    mPhase.store(previous.phase, std::memory_order_relaxed);
+    mFraction.store(previous.fraction, std::memory_order_relaxed);
+  }
+
+  // A loop of total elements went from done to done + count; reported in
+  // steps of 1/kSteps, by whichever thread crosses one
+  void advance(size_t done, size_t count, size_t total)
+  {
+    if (mProgress && (done * kSteps) / total != ((done + count) * kSteps) / total) {
+      report(mPhase.load(std::memory_order_relaxed), static_cast<double>(done + count) / static_cast<double>(total));
+    }
+  }
+
+ private:
+  static constexpr size_t kSteps = 32;
+
+  // One report at a time; the others are dropped rather than queued, as are
+  // fractions below one already reported in this phase (a later loop of the
+  // phase, or a thread that lost the race to report)
+  void report(const char* phase, double fraction)
+  {
+    if (!mProgress || phase == nullptr || mReporting.exchange(true, std::memory_order_acquire)) {
+      return;
+    }
+    if (fraction >= mFraction.load(std::memory_order_relaxed)) {
+      mFraction.store(fraction, std::memory_order_relaxed);
+      mProgress(phase, fraction);
+    }
+    mReporting.store(false, std::memory_order_release);
+  }
+
+  const std::atomic<bool>* mCancel;
+  std::chrono::steady_clock::time_point mDeadline;
+  Progress mProgress;
+  std::atomic<int32_t> mStatus{kRunning};
+  std::atomic<const char*> mPhase{nullptr};
+  std::atomic<double> mFraction{0.0}; // last reported in the current phase
+  std::atomic<bool> mReporting{false};
+};
+
+// Control of the call running on this thread (null: none)
+inline thread_local CallControl* tControl{nullptr};
+
+// Installs control on this thread while alive
+class ControlScope
+{
+ public:
+  explicit ControlScope(CallControl* control) : mOuter(tControl) { tControl = control; }
+  ~ControlScope() { tControl = mOuter; }
+
+  ControlScope(const ControlScope&) = delete;
+  ControlScope& operator=(const ControlScope&) = delete;
+
+ private:
+  CallControl* mOuter;
+};
+
+// Names the phase of the controlled call on this thread while alive
+class ProgressPhase
+{
+ public:
+  explicit ProgressPhase(const char* name) : mControl(tControl)
+  {
+    if (mControl != nullptr) {
+      mPrevious = mControl->enter(name);
+    }
+  }
+  ~ProgressPhase()
+  {
+    if (mControl != nullptr) {
+      mControl->leave(mPrevious);
+    }
+  }
+
+  ProgressPhase(const ProgressPhase&) = delete;
+  ProgressPhase& operator=(const ProgressPhase&) = delete;
+
+ private:
+  CallControl* mControl;
+  CallControl::Entry mPrevious{};
+};
+
+// One parallel loop under the thread's control, if any: blocks are skipped
+// once the call is stopped, and check() throws on the calling thread after
+// the loop. Loops nested in its blocks run unchecked, so nothing throws
+// inside a parallel region.
+class ControlledLoop
+{
+ public:
+  explicit ControlledLoop(size_t total) : mControl(tControl), mTotal(total) { tControl = nullptr; }
+  ~ControlledLoop() { tControl = mControl; }
+
+  ControlledLoop(const ControlledLoop&) = delete;
+  ControlledLoop& operator=(const ControlledLoop&) = delete;
+
+  [[nodiscard]] bool skip() const { return mControl != nullptr && mControl->poll() != CallControl::kRunning; }
+  void done(size_t count)
+  {
+    if (mControl != nullptr) {
+      mControl->advance(mDone.fetch_add(count, std::memory_order_relaxed), count, mTotal);
+    }
+  }
+  void check()
+  {
+    tControl = mControl;
+    if (mControl != nullptr) {
+      mControl->check();
+    }
+  }
+
+ private:
+  CallControl* mControl;
+  size_t mTotal;
+  std::atomic<size_t> mDone{0};
+};
+
+// Shared with the spinning tasks, which may outlive their arena's last call
+struct SpinState {
+  std::atomic<int32_t> active{0}; // calls inside the arena
+  std::atomic<int64_t> deadline{0}; // steady_clock ticks
+};
+} // namespace detail
+
+// NUMA nodes an arena can be placed on; {-1} (anywhere) when the backend
+// cannot tell (oneTBB needs its hwloc binding library, tbbbind, for this)
+inline std::vector<int32_t> numaNodes()
+{
+#if defined(DBSCAN_BACKEND_TBB)
+  const auto nodes = tbb::info::numa_nodes();
+  return {nodes.begin(), nodes.end()};
+#else
+  return {-1};
+#endif
+}
+
+// Thread-capped execution context: all parallel primitives called from inside
+// execute() run on at most nThreads threads (nThreads <= 0: all hardware threads).
+// std::execution offers no way to cap its pool: there the cap only sizes
+// the chunks loops are split into (hardwareThreads() reports it), and the
+// implementation decides how many threads run them.
+class TaskArena
+{
+ public:
+  // numaNode >= 0 keeps the threads on that node (TBB only)
+  void initialize(int32_t nThreads, [[maybe_unused]] int32_t numaNode = -1)
+  {
+    mThreads = nThreads;
+#if defined(DBSCAN_BACKEND_TBB)
+    mNumaNode = numaNode;
+    mArena.initialize(constraints(nThreads));
+#endif
+  }
+
+  // Runs f on the arena, or on a narrower one when the calling thread is
+  // inside a Degree
+  template <typename F>
+  void execute(F&& f)
+  {
+    const int32_t degree = detail::tCallThreads;
+#if defined(DBSCAN_BACKEND_TBB)
+    if (degree > 0 && degree < mArena.max_concurrency()) {
+      narrow(degree).execute(std::forward<F>(f));
+    } else {
+      mArena.execute(std::forward<F>(f));
+    }
+#elif defined(DBSCAN_BACKEND_OPENMP)
+    struct Restore {
+      int32_t previous;
+      ~Restore() { detail::tArenaThreads = previous; }
+    } restore{detail::tArenaThreads}; // f may throw detail::Interrupted
+    detail::tArenaThreads = degree > 0 && (mThreads <= 0 || degree < mThreads) ? degree : mThreads;
+    f();
+#elif defined(DBSCAN_BACKEND_STD)
+    struct Restore {
+      int32_t previous;
+      ~Restore() { detail::tCallThreads = previous; }
+    } restore{degree};
+    detail::tCallThreads = degree > 0 && (mThreads <= 0 || degree < mThreads) ? degree : mThreads;
+    f();
+#else
+    (void)degree; // serial has nothing to cap
+    f();
+#endif
+  }
+
+  [[nodiscard]] int32_t getThreads() const { return mThreads; }
+
+  // Threads execute() runs on at most
+  [[nodiscard]] int32_t maxThreads() const
+  {
+#if defined(DBSCAN_BACKEND_TBB)
+    return mArena.max_concurrency();
+#elif defined(DBSCAN_BACKEND_OPENMP)
+    return mThreads > 0 ? mThreads : omp_get_max_threads();
+#elif defined(DBSCAN_BACKEND_STD)
+    // the cap chunking follows, not an enforced pool size (see above)
+    return mThreads > 0 ? mThreads : static_cast<int32_t>(detail::hardwareThreads());
+#else
+    return 1;
+#endif
+  }
+
+  // Caps execute() on this thread at threads (a power of two) while alive;
+  // TBB keeps one narrower arena per power of two, created on first use
+  class Degree
+  {
+   public:
+    explicit Degree(int32_t threads) : mPrevious(detail::tCallThreads) { detail::tCallThreads = threads; }
+    ~Degree() { detail::tCallThreads = mPrevious; }
+
+    Degree(const Degree&) = delete;
+    Degree& operator=(const Degree&) = delete;
+
+   private:
+    int32_t mPrevious;
+  };
+
+  // Workers stay on these CPUs, one each, from the second on; the arena
+  // shrinks to cpus.size() threads if it had more (TBB on Linux; empty: not
+  // pinned). Call after initialize(), before the first execute().
+  void pin([[maybe_unused]] const std::vector<int32_t>& cpus)
+  {
+#if defined(DBSCAN_BACKEND_TBB)
+    mCpus = cpus;
+    mObserver.reset();
+    if (!cpus.empty()) {
+      const auto nCpus = static_cast<int32_t>(cpus.size());
+      if (mThreads <= 0 || mThreads > nCpus) {
+        mThreads = nCpus;
+        mArena.terminate();
+        mArena.initialize(constraints(mThreads));
+      }
+      mObserver = std::make_unique<detail::PinningObserver>(mArena, cpus, mPinningFailed);
+    }
+#endif
+  }
+
+  // Whether a worker could not be pinned to its CPU of pin()
+  [[nodiscard]] bool pinningFailed() const
+  {
+#if defined(DBSCAN_BACKEND_TBB)
+    return mPinningFailed.load(std::memory_order_relaxed);
+#else
+    return false;
+#endif
+  }
+
+  // A call running in the arena; when the last call in flight ends, the
+  // workers spin for spinMicros instead of going to sleep, so a call that
+  // follows finds them awake (TBB only)
+  class Call
+  {
+   public:
+    Call(TaskArena& arena, int32_t spinMicros) : mArena(arena), mSpinMicros(spinMicros)
+    {
+      mArena.mSpin->active.fetch_add(1, std::memory_order_acq_rel);
+    }
+    ~Call() { mArena.leave(mSpinMicros); }
+
+    Call(const Call&) = delete;
+    Call& operator=(const Call&) = delete;
+
+   private:
+    TaskArena& mArena;
+    int32_t mSpinMicros;
+  };
+
+ private:
+  void leave([[maybe_unused]] int32_t spinMicros)
+  {
+    const bool last = mSpin->active.fetch_sub(1, std::memory_order_acq_rel) == 1;
+#if defined(DBSCAN_BACKEND_TBB)
+    if (!last || spinMicros <= 0) {
+      return;
+    }
+    using Clock = std::chrono::steady_clock;
+    const auto deadline = (Clock::now() + std::chrono::microseconds(spinMicros)).time_since_epoch().count();
+    mSpin->deadline.store(deadline, std::memory_order_release);
+    // One spinner per worker; each stops at the deadline or when a call comes in
+    const int workers = mArena.max_concurrency() - 1;
+    for (int w = 0; w < workers; ++w) {
+      mArena.enqueue([spin = mSpin] {
+        while (spin->active.load(std::memory_order_acquire) == 0 &&
+               Clock::now().time_since_epoch().count() < spin->deadline.load(std::memory_order_acquire)) {
+          detail::cpuRelax();
+        }
+      });
+    }
+#else
+    (void)last;
+#endif
+  }
+
+#if defined(DBSCAN_BACKEND_TBB)
+  [[nodiscard]] tbb::task_arena::constraints constraints(int32_t nThreads) const
+  {
+    tbb::task_arena::constraints c;
+    c.numa_id = mNumaNode >= 0 ? mNumaNode : tbb::task_arena::automatic;
+    c.max_concurrency = nThreads > 0 ? nThreads : tbb::task_arena::automatic;
+    return c;
+  }
+
+  tbb::task_arena& narrow(int32_t degree)
+  {
+    const auto level = static_cast<size_t>(std::bit_width(static_cast<uint32_t>(degree)) - 1);
+    std::call_once(mNarrowOnce[level], [&] {
+      mNarrow[level] = std::make_unique<tbb::task_arena>(constraints(1 << level));
+      if (!mCpus.empty()) {
+        mNarrowObservers[level] = std::make_unique<detail::PinningObserver>(*mNarrow[level], mCpus, mPinningFailed);
+      }
+    });
+    return *mNarrow[level];
+  }
+
+  static constexpr size_t kNarrowLevels = 16;
+#endif
+
+  int32_t mThreads{0};
+  std::shared_ptr<detail::SpinState> mSpin{std::make_shared<detail::SpinState>()};
+#if defined(DBSCAN_BACKEND_TBB)
+  int32_t mNumaNode{-1};
+  std::vector<int32_t> mCpus;
+  std::atomic<bool> mPinningFailed{false};
+  tbb::task_arena mArena;
+  std::unique_ptr<detail::PinningObserver> mObserver; // declared after mArena: detaches first
+  std::array<std::once_flag, kNarrowLevels> mNarrowOnce;
+  std::array<std::unique_ptr<tbb::task_arena>, kNarrowLevels> mNarrow;
+  std::array<std::unique_ptr<detail::PinningObserver>, kNarrowLevels> mNarrowObservers;
+#endif
+};
+
+// Apply body(begin, end) to disjoint sub-ranges covering [begin, end)
+template <typename Body>
+void parallelFor(size_t begin, size_t end, const Body& body, size_t grain = 1)
+{
+  if (begin >= end) {
+    return;
+  }
+  detail::ControlledLoop loop(end - begin);
+  auto block = [&](size_t b, size_t e) {
+    if (!loop.skip()) {
+      body(b, e);
+      loop.done(e - b);
+    }
+  };
+#if defined(DBSCAN_BACKEND_TBB)
+  tbb::parallel_for(tbb::blocked_range<size_t>(begin, end, grain),
+                    [&](const tbb::blocked_range<size_t>& range) { block(range.begin(), range.end()); });
+#elif defined(DBSCAN_BACKEND_OPENMP)
+  const size_t nThreads = detail::hardwareThreads();
+  const size_t chunk = detail::chunkSize(end - begin, grain, nThreads);
+  const size_t nChunks = (end - begin + chunk - 1) / chunk;
+#pragma omp parallel for schedule(dynamic) num_threads(static_cast<int>(nThreads))
+  for (size_t c = 0; c < nChunks; ++c) {
+    const size_t b = begin + (c * chunk);
+    block(b, std::min(end, b + chunk));
+  }
+#elif defined(DBSCAN_BACKEND_STD)
+  const size_t chunk = detail::chunkSize(end - begin, grain, detail::hardwareThreads());
+  std::vector<size_t> starts;
+  for (size_t b = begin; b < end; b += chunk) {
+    starts.push_back(b);
+  }
+  std::for_each(std::execution::par, starts.begin(), starts.end(),
+                [&](size_t b) { block(b, std::min(end, b + chunk)); });
+#else
+  (void)grain;
+  block(begin, end);
+#endif
+  loop.check();
+}
+
+// Reduce over [begin, end): body(begin, end, acc) -> acc folds a sub-range,
+// combine(a, b) -> acc merges partial results (must be associative)
+template <typename T, typename Body, typename Combine>
+T parallelReduce(size_t begin, size_t end, T identity, const Body& body, const Combine& combine, size_t grain = 1)
+{
+  if (begin >= end) {
+    return identity;
+  }
+#if defined(DBSCAN_BACKEND_TBB)
+  detail::ControlledLoop loop(end - begin);
+  T result = tbb::parallel_reduce(
+    tbb::blocked_range<size_t>(begin, end, grain), identity,
+    [&](const tbb::blocked_range<size_t>& range, T acc) {
+      if (loop.skip()) {
+        return acc;
+      }
+      acc = body(range.begin(), range.end(), acc);
+      loop.done(range.size());
+      return acc;
+    },
+    combine);
+  loop.check();
+  return result;
+#elif defined(DBSCAN_BACKEND_OPENMP) || defined(DBSCAN_BACKEND_STD)
+  const size_t chunk = detail::chunkSize(end - begin, grain, detail::hardwareThreads());
+  const size_t nChunks = (end - begin + chunk - 1) / chunk;
+  std::vector<T> partial(nChunks, identity);
+  parallelFor(0, nChunks, [&](size_t cb, size_t ce) {
+    for (size_t c = cb; c < ce; ++c) {
+      const size_t b = begin + (c * chunk);
+      partial[c] = body(b, std::min(end, b + chunk), identity);
+    } }, 1);
+  T result = identity;
+  for (const auto& p : partial) {
+    result = combine(result, p);
+  }
+  return result;
+#else
+  (void)grain;
+  (void)combine;
+  return body(begin, end, identity);
+#endif
+}
+
+// Exclusive prefix sum out[i] = in[0] + ... + in[i-1]; in and out may alias.
+// Returns the total sum.
+template <typename T>
+T parallelExclusiveScan(const T* in, T* out, size_t n, size_t grain = 1)
+{
+  if (n == 0) {
+    return T{};
+  }
+#if defined(DBSCAN_BACKEND_TBB)
+  detail::ControlledLoop loop(n);
+  const T total = tbb::parallel_scan(
+    tbb::blocked_range<size_t>(0, n, std::max<size_t>(grain, 1024)), T{},
+    [&](const tbb::blocked_range<size_t>& range, T sum, bool isFinal) {
+      if (loop.skip()) {
+        return sum;
+      }
+      for (size_t i = range.begin(); i < range.end(); ++i) {
+        const T v = in[i];
+        if (isFinal) {
+          out[i] = sum;
+        }
+        sum += v;
+      }
+      if (isFinal) {
+        loop.done(range.size());
+      }
+      return sum;
+    },
+    [](const T& a, const T& b) { return a + b; });
+  loop.check();
+  return total;
+#elif defined(DBSCAN_BACKEND_OPENMP) || defined(DBSCAN_BACKEND_STD)
+  // Two passes: per-chunk totals, serial scan over chunks, per-chunk local scan
+  const size_t chunk = detail::chunkSize(n, std::max<size_t>(grain, 1024), detail::hardwareThreads());
+  const size_t nChunks = (n + chunk - 1) / chunk;
+  std::vector<T> offsets(nChunks + 1, T{});
+  parallelFor(0, nChunks, [&](size_t cb, size_t ce) {
+    for (size_t c = cb; c < ce; ++c) {
+      T sum{};
+      for (size_t i = c * chunk; i < std::min(n, (c + 1) * chunk); ++i) {
+        sum += in[i];
+      }
+      offsets[c + 1] = sum;
+    } }, 1);
+  for (size_t c = 0; c < nChunks; ++c) {
+    offsets[c + 1] += offsets[c];
+  }
+  parallelFor(0, nChunks, [&](size_t cb, size_t ce) {
+    for (size_t c = cb; c < ce; ++c) {
+      T sum = offsets[c];
+      for (size_t i = c * chunk; i < std::min(n, (c + 1) * chunk); ++i) {
+        const T v = in[i];
+        out[i] = sum;
+        sum += v;
+      }
+    } }, 1);
+  return offsets[nChunks];
+#else
+  (void)grain;
+  T sum{};
+  for (size_t i = 0; i < n; ++i) {
+    const T v = in[i];
+    out[i] = sum;
+    sum += v;
+  }
+  return sum;
+#endif
+}
+
+// Sort the random-access range [first, last) by comp (not stable)
+template <typename It, typename Compare>
+void parallelSort(It first, It last, const Compare& comp)
+{
+#if defined(DBSCAN_BACKEND_TBB)
+  tbb::parallel_sort(first, last, comp);
+#elif defined(DBSCAN_BACKEND_STD)
+  std::sort(std::execution::par, first, last, comp);
+#elif defined(DBSCAN_BACKEND_OPENMP)
+  // Sort one chunk per thread, then merge neighboring runs pairwise
+  const auto n = static_cast<size_t>(std::distance(first, last));
+  const size_t nChunks = std::max<size_t>(1, std::min(detail::hardwareThreads(), n / 4096));
+  const size_t chunk = (n + nChunks - 1) / nChunks;
+  parallelFor(0, nChunks, [&](size_t cb, size_t ce) {
+    for (size_t c = cb; c < ce; ++c) {
+      const auto b = static_cast<std::ptrdiff_t>(std::min(n, c * chunk));
+      const auto e = static_cast<std::ptrdiff_t>(std::min(n, (c + 1) * chunk));
+      std::sort(first + b, first + e, comp);
+    } }, 1);
+  for (size_t width = chunk; width < n; width *= 2) {
+    const size_t nPairs = (n + (2 * width) - 1) / (2 * width);
+    parallelFor(0, nPairs, [&](size_t pb, size_t pe) {
+      for (size_t p = pb; p < pe; ++p) {
+        const size_t b = p * 2 * width, m = std::min(n, b + width), e = std::min(n, b + (2 * width));
+        std::inplace_merge(first + static_cast<std::ptrdiff_t>(b), first + static_cast<std::ptrdiff_t>(m),
+                           first + static_cast<std::ptrdiff_t>(e), comp);
+      } }, 1);
+  }
+#else
+  std::sort(first, last, comp);
+#endif
+}
+
+} // namespace dbscan
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "DBSCAN.h"
+#include <array>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <semaphore>
+#include <thread>
+#include <vector>
+
+namespace dbscan
+{
+
+// Asynchronous clustering of a stream of frames.
+// The stages of consecutive frames (grid -> neighbors -> union -> relabel) run
+// concurrently on one stage thread each, so throughput approaches the slowest
+// stage rather than the sum of all stages. Parallel work inside a stage shares
+// the engine's task arena, on the threads the engine's tuner picks for the
+// frame (pointsPerThread, calibrateParallelism). At most maxInFlight frames
+// are in the pipeline; submit() blocks until a slot (and its recycled
+// workspace) is free.
+// The stages are those of the PointGraph engine (any neighbor storage and
+// connectivity, compactCoords). Other engines, NUMA partitions and 1-D
+// builds have no such stages: their frames are clustered whole by cluster()
+// in the first stage. Results match cluster() either way, but such frames
+// no longer overlap (each still runs in parallel on the arena).
+class DBSCANPipeline
+{
+ public:
+  DBSCANPipeline(const DBSCANParams& p, size_t maxInFlight = 4);
+  ~DBSCANPipeline();
+
+  DBSCANPipeline(const DBSCANPipeline&) = delete;
+  DBSCANPipeline& operator=(const DBSCANPipeline&) = delete;
+
+  // Takes ownership of the frame (NDim floats per point)
+  std::future<DBSCANResult> submit(std::vector<float> points);
+
+ private:
+  struct Frame;
+
+  enum Stage : size_t {
+    STAGE_GRID,
+    STAGE_NEIGHBORS,
+    STAGE_UNION,
+    STAGE_RELABEL,
+    N_STAGES
+  };
+
+  // Hand-over queue between two stage threads
+  class FrameQueue
+  {
+   public:
+    void push(std::unique_ptr<Frame> frame);
+    std::unique_ptr<Frame> pop(); // nullptr once closed and drained
+    void close();
+
+   private:
+    std::mutex mMutex;
+    std::condition_variable mCondition;
+    std::deque<std::unique_ptr<Frame>> mFrames;
+    bool mClosed{false};
+  };
+
+  void runStage(Stage stage);
+  void processStage(Stage stage, Frame& frame);
+  void finishFrame(std::unique_ptr<Frame> frame);
+
+  DBSCAN mEngine;
+  bool mStaged; // frames run stage by stage, see the class comment
+  std::counting_semaphore<> mSlots;
+  DBSCANWorkspacePool mWorkspaces;
+  std::array<FrameQueue, N_STAGES> mQueues;
+  std::vector<std::thread> mThreads;
+};
+
+} // namespace dbscan
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "DBSCANCommon.h"
+#include <algorithm>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace dbscan
+{
+
+// Cut between two adjacent chunks of one data set, e.g. time chunks
+// clustered in separate processes: the points of one chunk lie below
+// position along dim, those of the other at or above. Chunks must be wider
+// than eps along dim, so neighbors never skip a chunk.
+struct StitchCut {
+  int32_t dim;
+  double position;
+};
+
+// The points of a chunk within 2 eps of a cut (DBSCAN::exportBoundary).
+// Points within eps may gain neighbors across the cut and become core, the
+// band beyond covers the points those can reach; local neighbor counts come
+// along so the merge needs nothing else from the chunk.
+template <typename T>
+struct BoundaryDescriptor {
+  int32_t chunk;               // caller's chunk number, unique per chunk
+  StitchCut cut;
+  std::vector<size_t> ids;     // local point indices, ascending
+  std::vector<T> points;       // NDim coordinates per point
+  std::vector<int32_t> labels; // local labels
+  std::vector<int32_t> counts; // local neighbor counts
+};
+
+// Cluster id across chunks: the chunk in the upper 32 bits, a local label
+// (a root point index) below. A stitched cluster takes the smallest id of
+// the local clusters it is made of.
+inline int64_t globalClusterId(int32_t chunk, int32_t label)
+{
+  return (static_cast<int64_t>(chunk) << 32) | static_cast<uint32_t>(label);
+}
+
+// How the labels of one chunk translate into global cluster ids
+struct StitchRemap {
+  int32_t chunk;
+  std::vector<std::pair<int32_t, int64_t>> clusters; // local label -> global id, where not globalClusterId(chunk, label); sorted
+  std::vector<std::pair<size_t, int64_t>> points;    // points changed beyond that (new core or border points); sorted
+
+  // Global id of local point i with local label; negative labels (noise)
+  // pass through unless the point joined a cluster
+  [[nodiscard]] int64_t globalId(size_t i, int32_t label) const
+  {
+    const auto point = std::lower_bound(points.begin(), points.end(), std::pair<size_t, int64_t>{i, INT64_MIN});
+    if (point != points.end() && point->first == i) {
+      return point->second;
+    }
+    if (label < 0) {
+      return label;
+    }
+    const auto cluster = std::lower_bound(clusters.begin(), clusters.end(), std::pair<int32_t, int64_t>{label, INT64_MIN});
+    return cluster != clusters.end() && cluster->first == label ? cluster->second : globalClusterId(chunk, label);
+  }
+};
+
+struct StitchResult {
+  std::vector<StitchRemap> chunks; // one per chunk seen in the descriptors, by chunk number
+};
+
+// Merge chunks clustered separately from the descriptors of both sides of
+// every cut (any number of cuts). Exact: the result equals clustering the
+// union of the chunks, up to which cluster a border point joins. p must be
+// the parameters the chunks were clustered with.
+template <typename T>
+StitchResult stitch(std::span<const BoundaryDescriptor<T>> descriptors, const DBSCANParams& p);
+
+} // namespace dbscan
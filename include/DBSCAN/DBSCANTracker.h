@@ -0,0 +1,94 @@
+#pragma once
+
+#include "DBSCANCommon.h"
+#include "DBSCANParallel.h"
+#include <array>
+#include <cstdint>
+#include <vector>
+
+namespace dbscan
+{
+
+// Change of a cluster from one frame to the next
+enum class TrackEventType : int32_t {
+  Birth, // track appeared without a predecessor
+  Death, // track has no successor
+  Split, // track split off from other, which lives on
+  Merge, // track absorbed other
+};
+
+struct TrackEvent {
+  TrackEventType type;
+  int32_t track;     // stable id
+  int32_t other{-1}; // stable id of the second track (Split, Merge)
+};
+
+// Frame-to-frame matching
+struct DBSCANTrackerParams {
+  std::array<float, NDim> cellSizes; // matching grid, typically eps; <= 0 ignores a dimension (e.g. time)
+  int32_t minOverlap{1};             // shared cells for two clusters to be related
+  int32_t nThreads{0};               // Number of threads to use
+};
+
+// Tracking result of one frame
+struct TrackedFrame {
+  std::vector<int32_t> ids; // stable cluster id per point, DB_NOISE for noise
+  std::vector<TrackEvent> events;
+  int32_t nClusters = 0;
+};
+
+// Stable cluster ids across consecutive frames.
+// The labels of DBSCANResult are union-find roots and change arbitrarily
+// between frames. The tracker relates the clusters of two frames by the
+// grid cells they both occupy: (cell, cluster) pairs of each frame are
+// sorted, joined on the cell and the resulting (previous, current) pairs
+// counted, giving a sparse contingency table in O(n log n) instead of
+// comparing every pair of clusters.
+//
+// Each previous cluster hands its id to the current cluster it shares most
+// cells with. A current cluster inherits from the strongest of the previous
+// clusters that picked it (the others merged into it); one that none picked
+// split off its strongest predecessor, one without predecessor is born.
+//
+// update() is not thread-safe; frames must come in order.
+class DBSCANTracker
+{
+ public:
+  explicit DBSCANTracker(const DBSCANTrackerParams& p);
+
+  // Match the clustering of the next frame against the previous one
+  template <typename T>
+  TrackedFrame update(const T* points, size_t n, const DBSCANResult& result);
+
+  // Forget the previous frame: everything in the next one is a birth
+  void reset();
+
+ private:
+  using CellKey = std::array<int64_t, NDim>;
+  struct Occupancy {
+    CellKey cell;
+    int32_t cluster; // dense index within its frame
+
+    friend bool operator<(const Occupancy& a, const Occupancy& b)
+    {
+      return a.cell < b.cell || (a.cell == b.cell && a.cluster < b.cluster);
+    }
+    friend bool operator==(const Occupancy& a, const Occupancy& b) = default;
+  };
+  struct Link {
+    int32_t previous;
+    int32_t current;
+    int32_t shared; // cells
+  };
+
+  std::vector<Link> countLinks(const std::vector<Occupancy>& current);
+  void match(size_t nCurrent, const std::vector<Link>& links, std::vector<int32_t>& ids, std::vector<TrackEvent>& events);
+
+  DBSCANTrackerParams mParams;
+  TaskArena mTaskArena;
+  std::vector<Occupancy> mPrevious;   // occupied cells of the previous frame, sorted
+  std::vector<int32_t> mPreviousIds;  // dense cluster index -> stable id
+  int32_t mNextId{0};
+};
+
+} // namespace dbscan
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+namespace dbscan
+{
+
+// Lock-free union-find on an array of atomic parent indices, shared by the
+// point-level and the cell-level connectivity engines
+
+// Root of x, halving the path on the way
+inline size_t find(std::atomic<size_t>* parent, size_t x)
+{
+  while (true) {
+    size_t p = parent[x].load(std::memory_order_acquire);
+    if (p == x) {
+      return x;
+    }
+
+    // Path halving
+    size_t gp = parent[p].load(std::memory_order_acquire);
+    if (p == gp) {
+      return p;
+    }
+
+    parent[x].compare_exchange_weak(p, gp, std::memory_order_release);
+    x = p;
+  }
+}
+
+// Merge the sets of x and y; the smaller root index becomes the new root
+inline void unite(std::atomic<size_t>* parent, size_t x, size_t y)
+{
+  while (true) {
+    x = find(parent, x);
+    y = find(parent, y);
+    if (x == y) {
+      return;
+    }
+
+    if (x > y) {
+      std::swap(x, y); // Smaller root wins
+    }
+
+    size_t expected = y;
+    if (parent[y].compare_exchange_strong(expected, x, std::memory_order_acq_rel)) {
+      return;
+    }
+  }
+}
+
+} // namespace dbscan
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "DBSCANCommon.h"
+#include "DBSCANDistance.h"
+#include "DBSCANGrid.h"
+#include "DBSCANParallel.h"
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace dbscan
+{
+
+// Reclustering of the same n points after they moved a little.
+// cluster() runs from scratch and keeps the grid, the neighbor count of
+// every point and the union-find forest. update() then only re-bins the
+// points whose coordinates changed and diffs their old and new
+// neighborhoods. Counts, core flags and the forest are repaired locally:
+// added core-core edges are united. A removed edge or a lost core point is
+// harmless when the core points around it stay connected, which a bounded
+// search close by usually shows; a small part split off is found whole by
+// the search and becomes a cluster of its own. Only clusters where that
+// fails are re-linked. The result is exact, except that a border point next
+// to two clusters may keep the one it had (cluster() may pick either). The
+// cost follows the number of moved points (plus a few streaming passes over
+// the labels), not n. If more than a quarter of the points moved, update()
+// reclusters from scratch.
+//
+// Not thread-safe: one simulation loop per instance.
+template <typename T>
+class DBSCANWarmStart
+{
+ public:
+  explicit DBSCANWarmStart(const DBSCANParams& p);
+
+  // Cluster from scratch; the points are copied
+  const DBSCANResult& cluster(const T* points, size_t n);
+
+  // The same points at new positions, detecting the moved ones
+  const DBSCANResult& update(const T* points);
+
+  // As above, with the indices of the moved points given (sorted, unique)
+  const DBSCANResult& update(const T* points, std::span<const size_t> moved);
+
+ private:
+  // visit(idx) for the neighbors of point i at the current positions until it returns false
+  template <typename Visit>
+  void forEachNeighbor(size_t i, std::vector<const GridCell*>& cells, const Visit& visit) const;
+  void countClusters();
+
+  DBSCANParams mParams;
+  BasicDistance<T> mDistance;
+  TaskArena mTaskArena;
+
+  size_t mNPoints{0};
+  std::vector<T> mPositions; // the grid indexes this copy
+  std::optional<BasicGrid<T>> mGrid;
+  std::vector<size_t> mCellOf;
+  std::vector<int32_t> mCounts; // neighbors, the point itself excluded
+  std::vector<uint8_t> mIsCore;
+  std::unique_ptr<std::atomic<size_t>[]> mParent; // core points point at their root
+  std::vector<uint8_t> mMark; // scratch flags, all clear between calls
+  DBSCANResult mResult;
+};
+
+} // namespace dbscan
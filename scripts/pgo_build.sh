@@ -0,0 +1,47 @@
+#!/usr/bin/env bash
+# Two-stage profile-guided optimization build.
+#
+#   1. instrumented build (PGO=GENERATE) in build-pgo-gen/
+#   2. training run over the synthetic benchmark workloads (target pgo-train)
+#   3. optimized build (PGO=USE) in build-pgo-use/
+#   4. plain Release build in build-release/ and a benchmark comparison
+#
+# Usage: scripts/pgo_build.sh [benchmark points]
+#
+# AutoFDO variant (needs perf with LBR and create_gcov / llvm-profgen):
+#   cmake -S . -B build-afdo -DCMAKE_BUILD_TYPE=RelWithDebInfo -DENABLE_TIMING=OFF
+#   cmake --build build-afdo
+#   perf record -b -o perf.data build-afdo/dbscan_bench --train
+#   create_gcov --binary=build-afdo/dbscan_bench --profile=perf.data --gcov=dbscan.afdo   # GCC
+#   llvm-profgen --binary=build-afdo/dbscan_bench --perfdata=perf.data -o dbscan.prof     # Clang
+#   cmake -S . -B build-afdo-use -DPGO=AUTOFDO -DPGO_AUTOFDO_PROFILE=$PWD/dbscan.afdo -DENABLE_TIMING=OFF
+set -euo pipefail
+
+SRC_DIR="$(cd "$(dirname "$0")/.." && pwd)"
+PROFILE_DIR="${SRC_DIR}/pgo-profiles"
+N_POINTS="${1:-1000000}"
+JOBS="$(nproc)"
+
+common_args=(-DCMAKE_BUILD_TYPE=Release -DENABLE_TIMING=OFF -DPGO_PROFILE_DIR="${PROFILE_DIR}")
+
+rm -rf "${PROFILE_DIR}"
+
+echo "==> Stage 1: instrumented build"
+cmake -S "${SRC_DIR}" -B "${SRC_DIR}/build-pgo-gen" "${common_args[@]}" -DPGO=GENERATE
+cmake --build "${SRC_DIR}/build-pgo-gen" -j"${JOBS}" --target dbscan_bench
+
+echo "==> Training run"
+cmake --build "${SRC_DIR}/build-pgo-gen" --target pgo-train
+
+echo "==> Stage 2: optimized build"
+cmake -S "${SRC_DIR}" -B "${SRC_DIR}/build-pgo-use" "${common_args[@]}" -DPGO=USE
+cmake --build "${SRC_DIR}/build-pgo-use" -j"${JOBS}"
+
+echo "==> Baseline build"
+cmake -S "${SRC_DIR}" -B "${SRC_DIR}/build-release" "${common_args[@]}" -DPGO=OFF
+cmake --build "${SRC_DIR}/build-release" -j"${JOBS}" --target dbscan_bench
+
+echo "==> Release (no profile)"
+"${SRC_DIR}/build-release/dbscan_bench" --n "${N_POINTS}"
+echo "==> Release + PGO"
+"${SRC_DIR}/build-pgo-use/dbscan_bench" --n "${N_POINTS}"
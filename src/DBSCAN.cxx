@@ -1,75 +1,213 @@
 #include "DBSCAN/DBSCAN.h"
 #include "DBSCAN/DBSCANCommon.h"
 #include "DBSCAN/DBSCANGrid.h"
-#include <tbb/parallel_for.h>
+#include "DBSCAN/DBSCANParallel.h"
+#include "DBSCAN/DBSCANUnionFind.h"
 #include <algorithm>
+#include <atomic>
 #include <queue>
 #include <chrono>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <utility>
 
 namespace dbscan
 {
 
-DBSCAN::DBSCAN(const DBSCANParams& p) : mParams(p), mDistance(mParams.eps)
+namespace
+{
+// Size of a compact neighbor graph next to what explicit lists would take,
+// for the timing line of the phase that built it
+template <typename Neighbors>
+std::string neighborMemoryNote([[maybe_unused]] const char* kind, [[maybe_unused]] size_t n, [[maybe_unused]] const Neighbors& neighbors)
 {
-  mTaskArena.initialize(mParams.nThreads);
+#ifdef MEASURE_TIMING
+  const double explicitMB = static_cast<double>((neighbors.edges() * sizeof(size_t)) + (n * sizeof(std::vector<size_t>))) / (1024. * 1024.);
+  const double compactMB = static_cast<double>(neighbors.memoryBytes()) / (1024. * 1024.);
+  std::ostringstream note;
+  note << std::fixed << std::setprecision(2) << ", " << compactMB << " MB " << kind << " vs " << explicitMB << " MB explicit";
+  return note.str();
+#else
+  return {};
+#endif
 }
+} // namespace
 
-DBSCANResult DBSCAN::cluster(const float* points, size_t n)
+DBSCAN::DBSCAN(const DBSCANParams& p)
+  : mParams(p), mWorkspaces(static_cast<size_t>(std::max(1, mParams.nThreads)) * 2)
+{
+  mTaskArena.initialize(mParams.nThreads, mParams.numaNode);
+  mTaskArena.pin(mParams.cpus);
+  mTuner.initialize(mTaskArena.maxThreads(), mParams.pointsPerThread, mParams.calibrateParallelism);
+  if (mParams.numaPartitions != 0) {
+    createPartitions();
+  }
+}
+
+template <typename T>
+DBSCANResult DBSCAN::cluster(const T* points, size_t n) const
+{
+  return cluster(points, n, DBSCANCallOptions{});
+}
+
+template <typename T>
+DBSCANResult DBSCAN::cluster(const T* points, size_t n, const DBSCANCallOptions& options) const
 {
   DBSCANResult result;
   result.labels.resize(n, DB_UNVISITED);
   if (n == 0) {
     return result;
   }
+  const TaskArena::Call call(mTaskArena, mParams.spinMicros);
+  runControlled(n, options, result, [&] { clusterAll(points, n, options, static_cast<BasicGrid<T>*>(nullptr), result); });
+  return result;
+}
+
+void DBSCAN::runControlled(size_t n, const DBSCANCallOptions& options, DBSCANResult& result, const std::function<void()>& body) const
+{
+  if (options.cancel == nullptr && options.deadline == std::chrono::steady_clock::time_point::max() && !options.progress) {
+    body();
+    return;
+  }
+  detail::CallControl control(options.cancel != nullptr ? &options.cancel->flag() : nullptr, options.deadline, options.progress);
+  try {
+    const detail::ControlScope scope(&control);
+    control.check();
+    body();
+  } catch (const detail::Interrupted&) {
+    result.status = control.poll() == detail::CallControl::kPastDeadline ? DBSCANStatus::DeadlineExceeded : DBSCANStatus::Cancelled;
+  }
+  if (result.status != DBSCANStatus::Complete) {
+    // Partial labels would look like a valid clustering
+    mTaskArena.execute([&] {
+      parallelFor(0, n, [&](size_t begin, size_t end) { std::fill(&result.labels[begin], &result.labels[begin] + (end - begin), DB_UNVISITED); }, 4096);
+    });
+    result.nClusters = 0;
+    result.nNoise = 0;
+  }
+}
+
+template <typename T>
+void DBSCAN::clusterAll(const T* points, size_t n, const DBSCANCallOptions& options, BasicGrid<T>* grid, DBSCANResult& result) const
+{
+  if (!mPartitions.empty() && clusterPartitioned(points, n, options, result)) {
+    countClusters(result);
+    return;
+  }
+
+  // Every phase of this call runs on the threads the tuner picks for n
+  const ParallelismTuner::Call tuned(mTuner, n);
+  const TaskArena::Degree degree(tuned.threads());
+
+  if constexpr (NDim == 1) {
+    {
+      SCOPED_TIMER("clusterSweep");
+      clusterSweep(points, n, result);
+    }
+    countClusters(result);
+    return;
+  }
+
+  std::optional<BasicGrid<T>> ownGrid;
+  auto initGrid = [&]() -> BasicGrid<T>& {
+    if (grid == nullptr) {
+      SCOPED_TIMER("\tinit grid");
+      grid = &ownGrid.emplace(points, n, mParams.eps);
+      grid->initGrid();
+    }
+    return *grid;
+  };
+
+  if (mParams.engine == Engine::CellGraph) {
+    {
+      SCOPED_TIMER("clusterCellGraph");
+      clusterCellGraph(points, n, initGrid(), result);
+    }
+    countClusters(result);
+    return;
+  }
+
+  auto leased = mWorkspaces.acquire();
+  auto& workspace = *leased;
+  workspace.prepare(n);
+
+  if (mParams.engine == Engine::Sweep) {
+    {
+      SCOPED_TIMER("linkSweep");
+      linkSweep(points, n, workspace);
+    }
+    {
+      SCOPED_TIMER("Assignment");
+      assignLabels(n, workspace, result.labels);
+      countClusters(result);
+    }
+    mWorkspaces.release(std::move(leased));
+    return;
+  }
 
   // Step 1: Find neighbors for all points using grid
-  NeighborList neighbors;
   {
     SCOPED_TIMER("findNeighbors");
-    findNeighbors(points, n, neighbors);
+    auto& cells = initGrid();
+    if (mParams.compactCoords && !cells.hasCompactCoords()) {
+      mTaskArena.execute([&] { cells.buildCompactCoords(); });
+    }
+    findNeighbors(points, n, cells, workspace);
   }
   // Step 2: Classify points and form clusters
   {
     SCOPED_TIMER("Classification");
-    classify(n, neighbors, result.labels);
+    classify(n, workspace, result.labels);
   }
   // Step 3: Count clusters and noise points
   {
     SCOPED_TIMER("Assignment");
-    int32_t max_label = *std::ranges::max_element(result.labels);
-    result.nClusters = max_label + 1;
-    result.nNoise = static_cast<int32_t>(std::count(result.labels.begin(), result.labels.end(), DB_NOISE));
+    countClusters(result);
   }
 
-  return result;
+  mWorkspaces.release(std::move(leased));
 }
 
-void DBSCAN::findNeighbors(const float* points, size_t n, NeighborList& neighbors)
+template <typename T>
+void DBSCAN::findNeighbors(const T* points, size_t n, const BasicGrid<T>& grid, DBSCANWorkspace& workspace) const
 {
-  Grid grid(points, n, mParams.eps);
-  {
-    SCOPED_TIMER("\tinit grid");
-    grid.initGrid();
+  if (mParams.neighborStorage == NeighborStorage::Compressed) {
+    findNeighborsCompressed(points, n, grid, workspace.compressed);
+    return;
+  }
+  if (mParams.neighborStorage == NeighborStorage::Hybrid) {
+    findNeighborsHybrid(points, n, grid, workspace.hybrid);
+    return;
   }
 
+  if (grid.hasCompactCoords()) {
+    findNeighborsCompact(points, n, grid, workspace.neighbors);
+    return;
+  }
+
+  auto& neighbors = workspace.neighbors;
+  const BasicDistance<T> distance(mParams.eps);
   // Parallel neighbor finding
   mTaskArena.execute([&] {
     SCOPED_TIMER("\tneighbor finding");
     neighbors.neighbors.resize(n);
 
-    tbb::parallel_for(tbb::blocked_range<size_t>(0, n), [&](const tbb::blocked_range<size_t>& range) {
+    parallelFor(0, n, [&](size_t begin, size_t end) {
       std::vector<const GridCell*> neighbor_cells;
       neighbor_cells.reserve(NDim * NDim);
 
-      for (size_t i = range.begin(); i < range.end(); ++i) {
-        const float* query = &points[i * NDim];
+      for (size_t i = begin; i < end; ++i) {
+        const T* query = &points[i * NDim];
         auto coords = grid.getGridCoords(i);
         grid.getNeighborCells(coords, neighbor_cells);
 
         neighbors.neighbors[i].clear();
         for (const GridCell* cell : neighbor_cells) {
           for (auto idx : *cell) {
-            if (idx != i && mDistance.areNeighbors(query, &points[idx * NDim])) {
+            if (idx != i && distance.areNeighbors(query, &points[idx * NDim])) {
               neighbors.neighbors[i].push_back(idx);
             }
           }
@@ -79,98 +217,472 @@ void DBSCAN::findNeighbors(const float* points, size_t n, NeighborList& neighbor
   });
 }
 
-namespace
+template <typename T>
+void DBSCAN::findNeighborsCompact(const T* points, size_t n, const BasicGrid<T>& grid, NeighborList& neighbors) const
 {
-inline size_t find(std::vector<std::atomic<size_t>>& parent, size_t x)
+  // Candidates are classified on the 16-bit cell-relative coordinates:
+  // clearly inside eps, clearly outside, or within the error margin of the
+  // boundary, where the exact test on the original coordinates decides
+  constexpr int32_t kScale = BasicGrid<T>::kCompactScale; // eps is one cell
+  std::array<int32_t, NDim> inside, outside;
+#pragma unroll(NDim)
+  for (size_t d = 0; d < NDim; ++d) {
+    inside[d] = kScale - grid.getCompactMargin()[d];
+    outside[d] = kScale + grid.getCompactMargin()[d];
+  }
+  const BasicDistance<T> distance(mParams.eps);
+
+  // Queries run cell by cell: the neighbor cells and their offsets are
+  // shared by all points of a cell and the query's own compact coordinates
+  // are read in order
+  struct NeighborCell {
+    size_t index;
+    std::array<int32_t, NDim> delta; // cell offset in compact units
+  };
+  mTaskArena.execute([&] {
+    SCOPED_TIMER("\tneighbor finding (compact)");
+    neighbors.neighbors.resize(n);
+
+    parallelFor(0, grid.getNCells(), [&](size_t begin, size_t end) {
+      std::vector<size_t> cellIndices;
+      std::vector<NeighborCell> neighborCells;
+      std::vector<uint8_t> verdicts; // 0 outside, 1 inside, 2 check exactly
+
+      for (size_t c = begin; c < end; ++c) {
+        const auto& queries = grid.getCellAt(c);
+        if (queries.empty()) {
+          continue;
+        }
+        const auto coords = grid.getCellCoords(c);
+        grid.getNeighborCellIndices(coords, cellIndices);
+        neighborCells.clear();
+        for (size_t nc : cellIndices) {
+          if (grid.getCellAt(nc).empty()) {
+            continue;
+          }
+          const auto cellCoords = grid.getCellCoords(nc);
+          NeighborCell cell{nc, {}};
+#pragma unroll(NDim)
+          for (size_t d = 0; d < NDim; ++d) {
+            cell.delta[d] = (cellCoords[d] - coords[d]) * kScale;
+          }
+          neighborCells.push_back(cell);
+        }
+
+        const auto* own = grid.getCompactCoords(c);
+        for (size_t q = 0; q < queries.size(); ++q) {
+          const size_t i = queries[q];
+          const T* query = &points[i * NDim];
+          auto& list = neighbors.neighbors[i];
+          list.clear();
+          for (const auto& neighborCell : neighborCells) {
+            const auto& cell = grid.getCellAt(neighborCell.index);
+            const size_t count = cell.size();
+            std::array<int32_t, NDim> base;
+#pragma unroll(NDim)
+            for (size_t d = 0; d < NDim; ++d) {
+              base[d] = neighborCell.delta[d] - static_cast<int32_t>(own[q][d]);
+            }
+
+            // Branch-free pass over the cell's compact coordinates
+            const auto* compact = grid.getCompactCoords(neighborCell.index);
+            verdicts.resize(count);
+            for (size_t k = 0; k < count; ++k) {
+              bool out = false, near = false;
+#pragma unroll(NDim)
+              for (size_t d = 0; d < NDim; ++d) {
+                const int32_t diff = std::abs(base[d] + static_cast<int32_t>(compact[k][d]));
+                out |= diff > outside[d];
+                near |= diff >= inside[d];
+              }
+              verdicts[k] = out ? 0 : (near ? 2 : 1);
+            }
+
+            for (size_t k = 0; k < count; ++k) {
+              const size_t idx = cell[k];
+              if (verdicts[k] != 0 && idx != i && (verdicts[k] == 1 || distance.areNeighbors(query, &points[idx * NDim]))) {
+                list.push_back(idx);
+              }
+            }
+          }
+        }
+      }
+    });
+  });
+}
+
+template <typename T>
+void DBSCAN::findNeighborsCompressed(const T* points, size_t n, const BasicGrid<T>& grid, CompressedNeighborList& neighbors) const
 {
-  while (true) {
-    size_t p = parent[x].load(std::memory_order_acquire);
-    if (p == x) {
-      return x;
+  const BasicDistance<T> distance(mParams.eps);
+  mTaskArena.execute([&] {
+    // Renumber points in grid-cell order so neighbor ranks are clustered
+    {
+      SCOPED_TIMER("\trenumbering");
+      const size_t nCells = grid.getNCells();
+      std::vector<uint32_t> cellOffsets(nCells);
+      parallelFor(0, nCells, [&](size_t begin, size_t end) {
+        for (size_t c = begin; c < end; ++c) {
+          cellOffsets[c] = static_cast<uint32_t>(grid.getCellAt(c).size());
+        }
+      });
+      parallelExclusiveScan(cellOffsets.data(), cellOffsets.data(), nCells);
+      auto& order = neighbors.order();
+      auto& rank = neighbors.rank();
+      order.resize(n);
+      rank.resize(n);
+      parallelFor(0, nCells, [&](size_t begin, size_t end) {
+        for (size_t c = begin; c < end; ++c) {
+          uint32_t r = cellOffsets[c];
+          for (auto idx : grid.getCellAt(c)) {
+            order[r] = static_cast<uint32_t>(idx);
+            rank[idx] = r++;
+          }
+        }
+      });
     }
 
-    // Path halving
-    size_t gp = parent[p].load(std::memory_order_acquire);
-    if (p == gp) {
-      return p;
+    // Each block encodes its points into its own buffer, blocks are
+    // concatenated afterwards
+    NAMED_SCOPED_TIMER(timer, "\tneighbor finding (compressed)");
+    std::mutex blocksMutex;
+    std::vector<CompressedNeighborList::Block> blocks;
+    parallelFor(0, n, [&](size_t begin, size_t end) {
+      CompressedNeighborList::Block block;
+      block.begin = begin;
+      block.localOffsets.reserve(end - begin);
+      block.counts.reserve(end - begin);
+      std::vector<const GridCell*> neighbor_cells;
+      std::vector<uint32_t> ranks;
+
+      for (size_t i = begin; i < end; ++i) {
+        const T* query = &points[i * NDim];
+        grid.getNeighborCells(grid.getGridCoords(i), neighbor_cells);
+        // Ranks run cell by cell in storage order, so visiting the cells in
+        // address order yields the neighbor ranks already sorted
+        std::sort(neighbor_cells.begin(), neighbor_cells.end());
+        ranks.clear();
+        for (const GridCell* cell : neighbor_cells) {
+          for (auto idx : *cell) {
+            if (idx != i && distance.areNeighbors(query, &points[idx * NDim])) {
+              ranks.push_back(neighbors.rankOf(idx));
+            }
+          }
+        }
+        block.localOffsets.push_back(block.bytes.size());
+        block.counts.push_back(static_cast<uint32_t>(ranks.size()));
+        CompressedNeighborList::encode(neighbors.rankOf(i), ranks, block.bytes);
+      }
+      std::lock_guard lock(blocksMutex);
+      blocks.push_back(std::move(block));
+    });
+    neighbors.assemble(n, blocks);
+    timer.setNote(neighborMemoryNote("compressed", n, neighbors));
+  });
+}
+
+template <typename T>
+void DBSCAN::findNeighborsHybrid(const T* points, size_t n, const BasicGrid<T>& grid, HybridNeighborList& neighbors) const
+{
+  const BasicDistance<T> distance(mParams.eps);
+  mTaskArena.execute([&] {
+    // Cell membership (CSR) and tight bounding box of every cell
+    const size_t nCells = grid.getNCells();
+    std::vector<size_t> offsets(nCells + 1);
+    std::vector<std::array<T, NDim>> lo(nCells), hi(nCells);
+    {
+      SCOPED_TIMER("\tcell bounds");
+      auto& members = neighbors.cellPoints();
+      parallelFor(0, nCells, [&](size_t begin, size_t end) {
+        for (size_t c = begin; c < end; ++c) {
+          offsets[c] = grid.getCellAt(c).size();
+        }
+      });
+      offsets[nCells] = parallelExclusiveScan(offsets.data(), offsets.data(), nCells);
+      members.resize(n);
+      parallelFor(0, nCells, [&](size_t begin, size_t end) {
+        for (size_t c = begin; c < end; ++c) {
+          size_t k = offsets[c];
+          lo[c].fill(std::numeric_limits<T>::max());
+          hi[c].fill(std::numeric_limits<T>::lowest());
+          for (auto idx : grid.getCellAt(c)) {
+            members[k++] = static_cast<uint32_t>(idx);
+#pragma unroll(NDim)
+            for (size_t d = 0; d < NDim; ++d) {
+              lo[c][d] = std::min(lo[c][d], points[(idx * NDim) + d]);
+              hi[c][d] = std::max(hi[c][d], points[(idx * NDim) + d]);
+            }
+          }
+        }
+      });
     }
 
-    parent[x].compare_exchange_weak(p, gp, std::memory_order_release);
-    x = p;
+    // A cell is referenced as a whole if its bounding box lies within eps of
+    // the point: the extreme coordinates are points of the cell, so this is
+    // exactly the per-point test applied to every member
+    NAMED_SCOPED_TIMER(timer, "\tneighbor finding (hybrid)");
+    std::mutex blocksMutex;
+    std::vector<HybridNeighborList::Block> blocks;
+    parallelFor(0, n, [&](size_t begin, size_t end) {
+      HybridNeighborList::Block block;
+      block.begin = begin;
+      block.refCounts.reserve(end - begin);
+      block.explicitCounts.reserve(end - begin);
+      block.sizes.reserve(end - begin);
+      std::vector<size_t> neighbor_cells;
+
+      for (size_t i = begin; i < end; ++i) {
+        const T* query = &points[i * NDim];
+        const auto coords = grid.getGridCoords(i);
+        const size_t own = grid.getCellIndex(coords);
+        grid.getNeighborCellIndices(coords, neighbor_cells);
+        const size_t refs = block.refs.size(), expl = block.explicitIndices.size();
+        uint32_t size = 0;
+        for (size_t nc : neighbor_cells) {
+          const auto& cell = grid.getCellAt(nc);
+          if (cell.empty()) {
+            continue;
+          }
+          if (distance.areNeighbors(query, lo[nc].data()) && distance.areNeighbors(query, hi[nc].data())) {
+            block.refs.push_back({static_cast<uint32_t>(offsets[nc]), static_cast<uint32_t>(offsets[nc + 1])});
+            size += static_cast<uint32_t>(cell.size() - (nc == own ? 1 : 0));
+            continue;
+          }
+          for (auto idx : cell) {
+            if (idx != i && distance.areNeighbors(query, &points[idx * NDim])) {
+              block.explicitIndices.push_back(static_cast<uint32_t>(idx));
+              ++size;
+            }
+          }
+        }
+        block.refCounts.push_back(static_cast<uint32_t>(block.refs.size() - refs));
+        block.explicitCounts.push_back(static_cast<uint32_t>(block.explicitIndices.size() - expl));
+        block.sizes.push_back(size);
+      }
+      std::lock_guard lock(blocksMutex);
+      blocks.push_back(std::move(block));
+    });
+    neighbors.assemble(n, blocks);
+    timer.setNote(neighborMemoryNote("hybrid", n, neighbors));
+  });
+}
+
+void DBSCAN::countClusters(DBSCANResult& result) const
+{
+  using Counts = std::pair<int32_t, int32_t>; // (max label, noise)
+  const auto& labels = result.labels;
+  Counts counts{DB_UNVISITED, 0};
+  mTaskArena.execute([&] {
+    counts = parallelReduce(
+      0, labels.size(), Counts{DB_UNVISITED, 0},
+      [&](size_t begin, size_t end, Counts acc) {
+        for (size_t i = begin; i < end; ++i) {
+          acc.first = std::max(acc.first, labels[i]);
+          acc.second += labels[i] == DB_NOISE ? 1 : 0;
+        }
+        return acc;
+      },
+      [](const Counts& a, const Counts& b) { return Counts{std::max(a.first, b.first), a.second + b.second}; });
+  });
+  result.nClusters = counts.first + 1;
+  result.nNoise = counts.second;
+}
+
+void DBSCAN::classify(size_t n, DBSCANWorkspace& workspace, std::vector<int32_t>& labels) const
+{
+  linkCorePoints(n, workspace);
+  assignLabels(n, workspace, labels);
+}
+
+void DBSCAN::linkCorePoints(size_t n, DBSCANWorkspace& workspace) const
+{
+  if (mParams.neighborStorage == NeighborStorage::Compressed) {
+    linkCorePoints(n, workspace.compressed, workspace);
+  } else if (mParams.neighborStorage == NeighborStorage::Hybrid) {
+    linkCorePoints(n, workspace.hybrid, workspace);
+  } else {
+    linkCorePoints(n, workspace.neighbors, workspace);
   }
 }
 
-inline void unite(std::vector<std::atomic<size_t>>& parent, size_t x, size_t y)
+template <typename Neighbors>
+void DBSCAN::linkCorePoints(size_t n, const Neighbors& neighbors, DBSCANWorkspace& workspace) const
 {
-  while (true) {
-    x = find(parent, x);
-    y = find(parent, y);
-    if (x == y) {
-      return;
+  auto* parent = workspace.parent.get();
+  auto& isCore = workspace.isCore;
+
+  mTaskArena.execute([&] {
+    // Phase 1: Initialize + mark core points (already parallel)
+    {
+      SCOPED_TIMER("\tinit core points");
+      parallelFor(0, n, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          parent[i].store(i, std::memory_order_relaxed);
+          isCore[i] = neighbors.getSize(i) >= mParams.minPts;
+        }
+      });
     }
 
-    if (x > y) {
-      std::swap(x, y); // Smaller root wins
+    // Phase 2: Parallel union of core-to-core edges. Border points must not
+    // take part: a border point next to two clusters would bridge them.
+    if (mParams.connectivity == Connectivity::Afforest) {
+      SCOPED_TIMER("\tunion (afforest)");
+      linkAfforest(n, neighbors, workspace);
+    } else {
+      SCOPED_TIMER("\tunion");
+      parallelFor(0, n, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          if (!isCore[i]) {
+            continue;
+          }
+
+          for (size_t neighbor : neighbors.getNeighbors(i)) {
+            // Lists are symmetric, so each core-core edge is united once
+            if (neighbor > i && isCore[neighbor]) {
+              unite(parent, i, neighbor);
+            }
+          }
+        }
+      });
     }
 
-    size_t expected = y;
-    if (parent[y].compare_exchange_strong(expected, x, std::memory_order_acq_rel)) {
-      return;
+    // Phase 3: Attach border points to the first core neighbor. The forest only
+    // contains core points, nothing points at a border point, so a plain store suffices.
+    {
+      SCOPED_TIMER("\tborder attachment");
+      parallelFor(0, n, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          if (isCore[i]) {
+            continue;
+          }
+
+          for (size_t neighbor : neighbors.getNeighbors(i)) {
+            if (isCore[neighbor]) {
+              parent[i].store(neighbor, std::memory_order_relaxed);
+              break;
+            }
+          }
+        }
+      });
     }
-  }
+  });
 }
-} // namespace
 
-void DBSCAN::classify(size_t n, const NeighborList& neighbors, std::vector<int32_t>& labels) const
+template <typename Neighbors>
+void DBSCAN::linkAfforest(size_t n, const Neighbors& neighbors, DBSCANWorkspace& workspace) const
 {
-  std::vector<std::atomic<size_t>> parent(n);
-  std::vector<bool> isCore(n, false);
+  // Afforest (Sutton et al.): link a few sampled edges per vertex, find the
+  // component that already holds most vertices and skip every vertex in it.
+  // With one giant cluster this removes nearly all CAS traffic on its root.
+  constexpr size_t kSampleRounds = 2;
+  constexpr size_t kDominantSamples = 1024;
 
-  // Phase 1: Initialize + mark core points (already parallel)
-  {
-    SCOPED_TIMER("\tinit core points");
-    tbb::parallel_for(tbb::blocked_range<size_t>(0, n),
-                      [&](const auto& range) {
-                        for (size_t i = range.begin(); i < range.end(); ++i) {
-                          parent[i].store(i, std::memory_order_relaxed);
-                          isCore[i] = neighbors.getSize(i) >= mParams.minPts;
-                        }
-                      });
+  auto* parent = workspace.parent.get();
+  const auto& isCore = workspace.isCore;
+
+  auto compress = [&] {
+    parallelFor(0, n, [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; ++i) {
+        if (isCore[i]) {
+          parent[i].store(find(parent, i), std::memory_order_relaxed);
+        }
+      }
+    });
+  };
+
+  // Sampling: link each core point to its r-th core neighbor
+  for (size_t r = 0; r < kSampleRounds; ++r) {
+    parallelFor(0, n, [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; ++i) {
+        if (!isCore[i]) {
+          continue;
+        }
+        size_t seen = 0;
+        for (size_t neighbor : neighbors.getNeighbors(i)) {
+          if (isCore[neighbor] && seen++ == r) {
+            unite(parent, i, neighbor);
+            break;
+          }
+        }
+      }
+    });
+    compress();
   }
 
-  // Phase 2: Parallel union of core-to-neighbor edges
-  {
-    SCOPED_TIMER("\tunion");
-    tbb::parallel_for(tbb::blocked_range<size_t>(0, n),
-                      [&](const auto& range) {
-                        for (size_t i = range.begin(); i < range.end(); ++i) {
-                          if (!isCore[i]) {
-                            continue;
-                          }
-
-                          for (size_t neighbor : neighbors.getNeighbors(i)) {
-                            // Union core point with all neighbors
-                            unite(parent, i, neighbor);
-                          }
-                        }
-                      });
-  }
-
-  // Phase 3: Path compression + assign labels
-  {
-    SCOPED_TIMER("\tpath compression");
-    tbb::parallel_for(tbb::blocked_range<size_t>(0, n),
-                      [&](const auto& range) {
-                        for (size_t i = range.begin(); i < range.end(); ++i) {
-                          size_t root = find(parent, i);
-                          if (isCore[root]) {
-                            labels[i] = static_cast<int32_t>(root); // Use root as cluster ID (remap later)
-                          } else {
-                            labels[i] = DB_NOISE;
-                          }
-                        }
-                      });
+  // Most frequent root among a fixed pseudo-random sample of core points
+  std::vector<size_t> roots;
+  roots.reserve(kDominantSamples);
+  uint64_t state = 0x9E3779B97F4A7C15ULL;
+  for (size_t s = 0; s < kDominantSamples; ++s) {
+    state = (state * 6364136223846793005ULL) + 1442695040888963407ULL;
+    const size_t i = static_cast<size_t>(state >> 33) % n;
+    if (isCore[i]) {
+      roots.push_back(find(parent, i));
+    }
+  }
+  if (roots.empty()) {
+    // Too few core points for sampling to hit any: nothing is skipped
+    roots.push_back(n);
   }
+  std::sort(roots.begin(), roots.end());
+  size_t dominant = roots.front(), bestCount = 0;
+  for (size_t b = 0; b < roots.size();) {
+    size_t e = b;
+    while (e < roots.size() && roots[e] == roots[b]) {
+      ++e;
+    }
+    if (e - b > bestCount) {
+      bestCount = e - b;
+      dominant = roots[b];
+    }
+    b = e;
+  }
+
+  // Finish: remaining core-core edges of vertices outside the dominant
+  // component. Edges into it are seen from the outside end, so both
+  // directions have to be visited here.
+  parallelFor(0, n, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      if (!isCore[i] || find(parent, i) == dominant) {
+        continue;
+      }
+      size_t seen = 0;
+      for (size_t neighbor : neighbors.getNeighbors(i)) {
+        if (isCore[neighbor] && seen++ >= kSampleRounds) {
+          unite(parent, i, neighbor);
+        }
+      }
+    }
+  });
+}
+
+void DBSCAN::assignLabels(size_t n, DBSCANWorkspace& workspace, std::vector<int32_t>& labels) const
+{
+  auto* parent = workspace.parent.get();
+  const auto& isCore = workspace.isCore;
+
+  // Phase 4: Path compression + assign labels
+  mTaskArena.execute([&] {
+    SCOPED_TIMER("\tpath compression");
+    parallelFor(0, n, [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; ++i) {
+        size_t root = find(parent, i);
+        if (isCore[root]) {
+          labels[i] = static_cast<int32_t>(root); // Use root as cluster ID (remap later)
+        } else {
+          labels[i] = DB_NOISE;
+        }
+      }
+    });
+  });
 }
 
+#define DBSCAN_INSTANTIATE(T)                                                       \
+  template DBSCANResult DBSCAN::cluster<T>(const T*, size_t) const;               \
+  template DBSCANResult DBSCAN::cluster<T>(const T*, size_t, const DBSCANCallOptions&) const; \
+  template void DBSCAN::clusterAll<T>(const T*, size_t, const DBSCANCallOptions&, BasicGrid<T>*, DBSCANResult&) const; \
+  template void DBSCAN::findNeighbors<T>(const T*, size_t, const BasicGrid<T>&, DBSCANWorkspace&) const;
+DBSCAN_FOR_EACH_COORD_TYPE(DBSCAN_INSTANTIATE)
+#undef DBSCAN_INSTANTIATE
+
 } // namespace dbscan
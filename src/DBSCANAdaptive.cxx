@@ -0,0 +1,116 @@
+#include "DBSCAN/DBSCANAdaptive.h"
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <exception>
+#include <initializer_list>
+
+namespace dbscan
+{
+
+namespace
+{
+// Weight of a new sample in the moving average
+constexpr double kSmoothing = 0.25;
+
+int64_t now()
+{
+  return std::chrono::steady_clock::now().time_since_epoch().count();
+}
+} // namespace
+
+void ParallelismTuner::initialize(int32_t maxThreads, int32_t pointsPerThread, bool calibrate)
+{
+  mMaxLevel = std::min(kLevels - 1, static_cast<size_t>(std::bit_width(static_cast<uint32_t>(std::max(1, maxThreads))) - 1));
+  mPointsPerThread = pointsPerThread;
+  mCalibrate = calibrate;
+}
+
+size_t ParallelismTuner::modelLevel(size_t n) const
+{
+  if (mPointsPerThread <= 0) {
+    return mMaxLevel;
+  }
+  const size_t threads = (n + static_cast<size_t>(mPointsPerThread) - 1) / static_cast<size_t>(mPointsPerThread);
+  return std::min(mMaxLevel, static_cast<size_t>(std::bit_width(std::max<size_t>(1, threads) - 1))); // round up
+}
+
+int32_t ParallelismTuner::choose(size_t n)
+{
+  if (mPointsPerThread <= 0 && !mCalibrate) {
+    return 0;
+  }
+  size_t level = modelLevel(n);
+  if (mCalibrate) {
+    std::lock_guard lock(mMutex);
+    auto& sizeClass = mClasses[std::min(kClasses - 1, static_cast<size_t>(std::bit_width(n)))];
+    const uint64_t call = sizeClass.calls++;
+    if (sizeClass.level > mMaxLevel) {
+      sizeClass.level = level;
+    }
+    level = climb(sizeClass, call);
+  }
+  return level >= mMaxLevel ? 0 : 1 << level;
+}
+
+size_t ParallelismTuner::climb(SizeClass& sizeClass, uint64_t call) const
+{
+  // Hill climbing from the model's level: sample the current level, then its
+  // two neighbors, and move to the cheaper neighbor until neither is cheaper.
+  // Every kReprobe calls one neighbor of the settled level is tried again.
+  size_t& current = sizeClass.level;
+  while (true) {
+    if (sizeClass.samples[current] < kProbes) {
+      return current;
+    }
+    const size_t lower = current > 0 ? current - 1 : current;
+    const size_t upper = std::min(mMaxLevel, current + 1);
+    for (const size_t l : {lower, upper}) {
+      if (sizeClass.samples[l] < kProbes) {
+        return l;
+      }
+    }
+    size_t best = current;
+    for (const size_t l : {lower, upper}) {
+      if (sizeClass.cost[l] < sizeClass.cost[best]) {
+        best = l;
+      }
+    }
+    if (best == current) {
+      break;
+    }
+    current = best;
+  }
+  if (call % kReprobe == 0) {
+    return (call / kReprobe) % 2 == 0 ? std::min(mMaxLevel, current + 1) : (current > 0 ? current - 1 : current);
+  }
+  return current;
+}
+
+void ParallelismTuner::record(size_t n, int32_t threads, double seconds)
+{
+  if (!mCalibrate || n == 0) {
+    return;
+  }
+  const size_t level = threads > 0 ? static_cast<size_t>(std::bit_width(static_cast<uint32_t>(threads)) - 1) : mMaxLevel;
+  const double cost = seconds / static_cast<double>(n);
+  std::lock_guard lock(mMutex);
+  auto& sizeClass = mClasses[std::min(kClasses - 1, static_cast<size_t>(std::bit_width(n)))];
+  auto& average = sizeClass.cost[level];
+  average = sizeClass.samples[level]++ == 0 ? cost : ((1 - kSmoothing) * average) + (kSmoothing * cost);
+}
+
+ParallelismTuner::Call::Call(ParallelismTuner& tuner, size_t n) : mTuner(tuner), mN(n), mThreads(tuner.choose(n)), mStart(now())
+{
+}
+
+ParallelismTuner::Call::~Call()
+{
+  if (std::uncaught_exceptions() > 0) {
+    return; // stopped calls say nothing about the cost
+  }
+  const std::chrono::steady_clock::duration elapsed(now() - mStart);
+  mTuner.record(mN, mThreads, std::chrono::duration<double>(elapsed).count());
+}
+
+} // namespace dbscan
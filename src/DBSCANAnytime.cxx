@@ -0,0 +1,129 @@
+#include "DBSCAN/DBSCAN.h"
+#include "DBSCAN/DBSCANUnionFind.h"
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <utility>
+
+namespace dbscan
+{
+
+template <typename T>
+DBSCANAnytimeResult DBSCAN::clusterAnytime(const T* points, size_t n, const CancellationToken& cancel, const DBSCANCallOptions& options) const
+{
+  DBSCANAnytimeResult anytime;
+  auto& coarse = anytime.coarse;
+  coarse.labels.resize(n, DB_UNVISITED);
+  coarse.status = DBSCANStatus::Coarse;
+  if (n == 0) {
+    std::promise<DBSCANResult> empty;
+    anytime.refined = empty.get_future();
+    empty.set_value(DBSCANResult{});
+    return anytime;
+  }
+
+  // Sweep, NUMA partitions and 1-D data never read a grid: the refinement
+  // starts at once and nothing is resolved coarsely. Otherwise the
+  // refinement takes the grid over, so it is built only once.
+  const bool coarsePass = NDim > 1 && mParams.engine != Engine::Sweep && mPartitions.empty();
+  std::shared_ptr<BasicGrid<T>> grid;
+  if (coarsePass) {
+    grid = std::make_shared<BasicGrid<T>>(points, n, mParams.eps);
+    mTaskArena.execute([&] {
+      {
+        SCOPED_TIMER("\tinit grid");
+        grid->initGrid();
+      }
+      const size_t nCells = grid->getNCells();
+      const auto minPts = static_cast<size_t>(std::max(0, mParams.minPts));
+      auto dense = [&](size_t c) { return grid->getCellAt(c).size() > minPts; };
+
+      // Step 1: Points sharing a cell are within eps, so a cell holding more
+      // than minPts points is core throughout. Adjacent dense cells are taken
+      // as connected without a distance test, which may join clusters the
+      // exact result keeps apart.
+      auto cellParent = std::make_unique<std::atomic<size_t>[]>(nCells);
+      {
+        SCOPED_TIMER("\tdense cells");
+        parallelFor(0, nCells, [&](size_t begin, size_t end) {
+          for (size_t c = begin; c < end; ++c) {
+            cellParent[c].store(c, std::memory_order_relaxed);
+          }
+        });
+        parallelFor(0, nCells, [&](size_t begin, size_t end) {
+          std::vector<size_t> neighborCells;
+          for (size_t c = begin; c < end; ++c) {
+            if (!dense(c)) {
+              continue;
+            }
+            grid->getNeighborCellIndices(grid->getCellCoords(c), neighborCells);
+            for (size_t nc : neighborCells) {
+              if (nc > c && dense(nc)) {
+                unite(cellParent.get(), c, nc);
+              }
+            }
+          }
+        });
+      }
+
+      // Step 2: Cluster id = smallest point index in the component; points
+      // outside dense cells stay unresolved
+      {
+        SCOPED_TIMER("\tcoarse labels");
+        std::unique_ptr<std::atomic<size_t>[]> minPoint(new std::atomic<size_t>[nCells]);
+        parallelFor(0, nCells, [&](size_t begin, size_t end) {
+          for (size_t c = begin; c < end; ++c) {
+            minPoint[c].store(std::numeric_limits<size_t>::max(), std::memory_order_relaxed);
+          }
+        });
+        parallelFor(0, nCells, [&](size_t begin, size_t end) {
+          for (size_t c = begin; c < end; ++c) {
+            if (!dense(c)) {
+              continue;
+            }
+            const auto& cell = grid->getCellAt(c);
+            const size_t first = *std::min_element(cell.begin(), cell.end());
+            auto& slot = minPoint[find(cellParent.get(), c)];
+            size_t current = slot.load(std::memory_order_relaxed);
+            while (first < current && !slot.compare_exchange_weak(current, first, std::memory_order_relaxed)) {
+            }
+          }
+        });
+        parallelFor(0, nCells, [&](size_t begin, size_t end) {
+          for (size_t c = begin; c < end; ++c) {
+            if (!dense(c)) {
+              continue;
+            }
+            const auto id = static_cast<int32_t>(minPoint[find(cellParent.get(), c)].load(std::memory_order_relaxed));
+            for (auto idx : grid->getCellAt(c)) {
+              coarse.labels[idx] = id;
+            }
+          }
+        });
+      }
+    });
+  }
+  countClusters(coarse);
+  coarse.nClusters = std::max(0, coarse.nClusters); // no dense cell: every label DB_UNVISITED
+
+  // Step 3: The exact clustering, as cluster() would run it, on the grid
+  // built above (if any), stoppable through cancel
+  DBSCANCallOptions refine = options;
+  refine.cancel = &cancel;
+  anytime.refined = std::async(std::launch::async, [this, points, n, refine = std::move(refine), grid = std::move(grid)] {
+    DBSCANResult result;
+    result.labels.resize(n, DB_UNVISITED);
+    const TaskArena::Call call(mTaskArena, mParams.spinMicros);
+    runControlled(n, refine, result, [&] { clusterAll(points, n, refine, grid.get(), result); });
+    return result;
+  });
+  return anytime;
+}
+
+#define DBSCAN_INSTANTIATE(T) \
+  template DBSCANAnytimeResult DBSCAN::clusterAnytime<T>(const T*, size_t, const CancellationToken&, const DBSCANCallOptions&) const;
+DBSCAN_FOR_EACH_COORD_TYPE(DBSCAN_INSTANTIATE)
+#undef DBSCAN_INSTANTIATE
+
+} // namespace dbscan
@@ -0,0 +1,282 @@
+#include "DBSCAN/DBSCAN.h"
+#include "DBSCAN/DBSCANCommon.h"
+#include "DBSCAN/DBSCANGrid.h"
+#include "DBSCAN/DBSCANParallel.h"
+#include "DBSCAN/DBSCANUnionFind.h"
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <utility>
+
+namespace dbscan
+{
+
+namespace
+{
+// Core points of every cell, contiguous per cell (CSR), with their
+// coordinates copied next to each other per dimension for the tile kernel
+template <typename T>
+struct CoreCells {
+  std::vector<size_t> offsets; // cell -> first entry, size nCells + 1
+  std::vector<size_t> points;  // point index
+  std::array<std::vector<T>, NDim> coords;
+
+  [[nodiscard]] size_t size(size_t cell) const { return offsets[cell + 1] - offsets[cell]; }
+};
+
+// Cells with at least this many core points on both sides use the tile kernel
+constexpr size_t kTileMinPoints = 32;
+} // namespace
+
+template <typename T>
+void DBSCAN::clusterCellGraph(const T* points, size_t n, const BasicGrid<T>& grid, DBSCANResult& result) const
+{
+  const BasicDistance<T> distance(mParams.eps);
+  const size_t nCells = grid.getNCells();
+  const auto minPts = static_cast<size_t>(std::max(0, mParams.minPts));
+
+  mTaskArena.execute([&] {
+    // Step 1: Core points. Points sharing a cell are always within eps, so a
+    // cell holding more than minPts points is core throughout; otherwise
+    // count neighbors and stop as soon as minPts is reached.
+    std::vector<uint8_t> isCore(n, 0);
+    {
+      SCOPED_TIMER("\tcore points");
+      parallelFor(0, n, [&](size_t begin, size_t end) {
+        std::vector<const GridCell*> neighborCells;
+        for (size_t i = begin; i < end; ++i) {
+          const auto coords = grid.getGridCoords(i);
+          const GridCell* own = grid.getCell(coords);
+          if (own->size() > minPts) {
+            isCore[i] = 1;
+            continue;
+          }
+          grid.getNeighborCells(coords, neighborCells);
+          const T* query = &points[i * NDim];
+          size_t count = 0;
+          for (const GridCell* cell : neighborCells) {
+            for (auto idx : *cell) {
+              if (idx != i && distance.areNeighbors(query, &points[idx * NDim])) {
+                ++count;
+              }
+            }
+            if (count >= minPts) {
+              break;
+            }
+          }
+          isCore[i] = count >= minPts;
+        }
+      });
+    }
+
+    // Step 2: Gather core points per cell (count, scan, fill)
+    CoreCells<T> core;
+    {
+      SCOPED_TIMER("\tcore cells");
+      core.offsets.assign(nCells + 1, 0);
+      parallelFor(0, nCells, [&](size_t begin, size_t end) {
+        for (size_t c = begin; c < end; ++c) {
+          size_t count = 0;
+          for (auto idx : grid.getCellAt(c)) {
+            count += isCore[idx];
+          }
+          core.offsets[c] = count;
+        }
+      });
+      const size_t nCore = parallelExclusiveScan(core.offsets.data(), core.offsets.data(), nCells);
+      core.offsets[nCells] = nCore;
+      core.points.resize(nCore);
+      for (auto& dim : core.coords) {
+        dim.resize(nCore);
+      }
+      parallelFor(0, nCells, [&](size_t begin, size_t end) {
+        for (size_t c = begin; c < end; ++c) {
+          size_t k = core.offsets[c];
+          for (auto idx : grid.getCellAt(c)) {
+            if (isCore[idx]) {
+              core.points[k] = idx;
+#pragma unroll(NDim)
+              for (size_t d = 0; d < NDim; ++d) {
+                core.coords[d][k] = points[(idx * NDim) + d];
+              }
+              ++k;
+            }
+          }
+        }
+      });
+    }
+
+    // Two adjacent core cells are connected if any core pair across them is
+    // within eps. Points are ordered by their projection onto the axis between
+    // the cells (in units of eps): a pair within eps differs by at most the
+    // number of axes the cells are offset along, so the scan stops early.
+    // Projections are taken in double relative to the first core point of a,
+    // so they stay exact to ~1e-15 even far from the origin, where absolute
+    // float coordinates would round by more than the slack.
+    auto cellsConnected = [&](size_t a, size_t b, const GridCoord& dir) {
+      const size_t na = core.size(a), nb = core.size(b);
+      if (na >= kTileMinPoints && nb >= kTileMinPoints) {
+        std::array<const T*, NDim> soa;
+#pragma unroll(NDim)
+        for (size_t d = 0; d < NDim; ++d) {
+          soa[d] = &core.coords[d][core.offsets[b]];
+        }
+        for (size_t k = core.offsets[a]; k < core.offsets[a + 1]; ++k) {
+          if (distance.anyNeighbor(&points[core.points[k] * NDim], soa, nb)) {
+            return true;
+          }
+        }
+        return false;
+      }
+
+      std::array<double, NDim> origin;
+#pragma unroll(NDim)
+      for (size_t d = 0; d < NDim; ++d) {
+        origin[d] = static_cast<double>(CoordTraits<T>::load(core.coords[d][core.offsets[a]]));
+      }
+      auto project = [&](size_t k) {
+        double proj = 0;
+#pragma unroll(NDim)
+        for (size_t d = 0; d < NDim; ++d) {
+          proj += static_cast<double>(dir[d]) * (static_cast<double>(CoordTraits<T>::load(core.coords[d][k])) - origin[d]) /
+                  static_cast<double>(mParams.eps[d]);
+        }
+        return proj;
+      };
+      double bound = 0;
+#pragma unroll(NDim)
+      for (size_t d = 0; d < NDim; ++d) {
+        if (dir[d] != 0) {
+          bound += 1;
+        }
+      }
+      // The bound only prunes, the exact test decides; the slack covers a
+      // float difference rounded down onto eps (2^-24 relative)
+      bound *= 1 + 1e-6;
+
+      std::vector<std::pair<double, size_t>> pa, pb;
+      pa.reserve(na);
+      pb.reserve(nb);
+      for (size_t k = core.offsets[a]; k < core.offsets[a + 1]; ++k) {
+        pa.emplace_back(project(k), core.points[k]);
+      }
+      for (size_t k = core.offsets[b]; k < core.offsets[b + 1]; ++k) {
+        pb.emplace_back(project(k), core.points[k]);
+      }
+      std::sort(pa.begin(), pa.end(), [](const auto& x, const auto& y) { return x.first > y.first; }); // closest to b first
+      std::sort(pb.begin(), pb.end());                                                                 // closest to a first
+      for (const auto& [projA, ia] : pa) {
+        if (pb.front().first - projA > bound) {
+          return false; // every later point of a is even further away
+        }
+        for (const auto& [projB, ib] : pb) {
+          if (projB - projA > bound) {
+            break;
+          }
+          if (distance.areNeighbors(&points[ia * NDim], &points[ib * NDim])) {
+            return true;
+          }
+        }
+      }
+      return false;
+    };
+
+    // Step 3: Connectivity over core cells; each adjacent pair is tested once
+    // and only while the two cells are still in different components
+    auto cellParent = std::make_unique<std::atomic<size_t>[]>(nCells);
+    {
+      SCOPED_TIMER("\tcell graph");
+      parallelFor(0, nCells, [&](size_t begin, size_t end) {
+        for (size_t c = begin; c < end; ++c) {
+          cellParent[c].store(c, std::memory_order_relaxed);
+        }
+      });
+      parallelFor(0, nCells, [&](size_t begin, size_t end) {
+        std::vector<size_t> neighborCells;
+        for (size_t c = begin; c < end; ++c) {
+          if (core.size(c) == 0) {
+            continue;
+          }
+          const auto coords = grid.getCellCoords(c);
+          grid.getNeighborCellIndices(coords, neighborCells);
+          for (size_t nc : neighborCells) {
+            if (nc <= c || core.size(nc) == 0 || find(cellParent.get(), c) == find(cellParent.get(), nc)) {
+              continue;
+            }
+            const auto ncCoords = grid.getCellCoords(nc);
+            GridCoord dir;
+#pragma unroll(NDim)
+            for (size_t d = 0; d < NDim; ++d) {
+              dir[d] = ncCoords[d] - coords[d];
+            }
+            if (cellsConnected(c, nc, dir)) {
+              unite(cellParent.get(), c, nc);
+            }
+          }
+        }
+      });
+    }
+
+    // Step 4: Cluster id = smallest core point index in the component, the
+    // same id the point-level union-find ends up with
+    std::unique_ptr<std::atomic<size_t>[]> minCore(new std::atomic<size_t>[nCells]);
+    {
+      SCOPED_TIMER("\tlabels");
+      parallelFor(0, nCells, [&](size_t begin, size_t end) {
+        for (size_t c = begin; c < end; ++c) {
+          minCore[c].store(std::numeric_limits<size_t>::max(), std::memory_order_relaxed);
+        }
+      });
+      parallelFor(0, nCells, [&](size_t begin, size_t end) {
+        for (size_t c = begin; c < end; ++c) {
+          if (core.size(c) == 0) {
+            continue;
+          }
+          const size_t first = core.points[core.offsets[c]]; // cells list points in index order
+          auto& slot = minCore[find(cellParent.get(), c)];
+          size_t current = slot.load(std::memory_order_relaxed);
+          while (first < current && !slot.compare_exchange_weak(current, first, std::memory_order_relaxed)) {
+          }
+        }
+      });
+
+      // Core points take their cell's cluster, border points the cluster of
+      // the first core point within eps, everything else is noise
+      auto& labels = result.labels;
+      parallelFor(0, n, [&](size_t begin, size_t end) {
+        std::vector<size_t> neighborCells;
+        for (size_t i = begin; i < end; ++i) {
+          const auto coords = grid.getGridCoords(i);
+          if (isCore[i]) {
+            const size_t root = find(cellParent.get(), grid.getCellIndex(coords));
+            labels[i] = static_cast<int32_t>(minCore[root].load(std::memory_order_relaxed));
+            continue;
+          }
+          labels[i] = DB_NOISE;
+          grid.getNeighborCellIndices(coords, neighborCells);
+          const T* query = &points[i * NDim];
+          for (size_t nc : neighborCells) {
+            bool attached = false;
+            for (size_t k = core.offsets[nc]; k < core.offsets[nc + 1]; ++k) {
+              if (distance.areNeighbors(query, &points[core.points[k] * NDim])) {
+                labels[i] = static_cast<int32_t>(minCore[find(cellParent.get(), nc)].load(std::memory_order_relaxed));
+                attached = true;
+                break;
+              }
+            }
+            if (attached) {
+              break;
+            }
+          }
+        }
+      });
+    }
+  });
+}
+
+#define DBSCAN_INSTANTIATE(T) template void DBSCAN::clusterCellGraph<T>(const T*, size_t, const BasicGrid<T>&, DBSCANResult&) const;
+DBSCAN_FOR_EACH_COORD_TYPE(DBSCAN_INSTANTIATE)
+#undef DBSCAN_INSTANTIATE
+
+} // namespace dbscan
@@ -0,0 +1,406 @@
+#include "DBSCAN/DBSCANDaemon.h"
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <iterator>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace dbscan
+{
+
+namespace
+{
+// A client that connects must say hello within this time
+constexpr std::chrono::seconds kHelloTimeout{1};
+
+bool makeAddress(const std::string& path, sockaddr_un& address)
+{
+  address = {};
+  address.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(address.sun_path)) {
+    return false;
+  }
+  std::memcpy(address.sun_path, path.c_str(), path.size() + 1);
+  return true;
+}
+
+// One message with a file descriptor attached
+bool sendWithFd(int socket, const void* data, size_t bytes, int fd)
+{
+  iovec io{const_cast<void*>(data), bytes};
+  alignas(cmsghdr) std::array<char, CMSG_SPACE(sizeof(int))> control{};
+  msghdr message{};
+  message.msg_iov = &io;
+  message.msg_iovlen = 1;
+  message.msg_control = control.data();
+  message.msg_controllen = control.size();
+  cmsghdr* header = CMSG_FIRSTHDR(&message);
+  header->cmsg_level = SOL_SOCKET;
+  header->cmsg_type = SCM_RIGHTS;
+  header->cmsg_len = CMSG_LEN(sizeof(int));
+  std::memcpy(CMSG_DATA(header), &fd, sizeof(int));
+  return sendmsg(socket, &message, MSG_NOSIGNAL) == static_cast<ssize_t>(bytes);
+}
+
+// Returns the attached descriptor, or -1
+int receiveWithFd(int socket, void* data, size_t bytes)
+{
+  iovec io{data, bytes};
+  alignas(cmsghdr) std::array<char, CMSG_SPACE(sizeof(int))> control{};
+  msghdr message{};
+  message.msg_iov = &io;
+  message.msg_iovlen = 1;
+  message.msg_control = control.data();
+  message.msg_controllen = control.size();
+  if (recvmsg(socket, &message, MSG_CMSG_CLOEXEC) != static_cast<ssize_t>(bytes)) {
+    return -1;
+  }
+  const cmsghdr* header = CMSG_FIRSTHDR(&message);
+  if (header == nullptr || header->cmsg_level != SOL_SOCKET || header->cmsg_type != SCM_RIGHTS) {
+    return -1;
+  }
+  int fd = -1;
+  std::memcpy(&fd, CMSG_DATA(header), sizeof(int));
+  return fd;
+}
+
+// Take over the socket path: a socket left behind by a daemon that died is
+// removed, one a daemon still answers on (or anything else there) is not
+bool claimSocketPath(const std::string& path, const sockaddr_un& address)
+{
+  struct stat info{};
+  if (lstat(path.c_str(), &info) != 0) {
+    return errno == ENOENT;
+  }
+  if (!S_ISSOCK(info.st_mode)) {
+    return false;
+  }
+  const int probe = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+  if (probe < 0) {
+    return false;
+  }
+  const bool answered = connect(probe, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0;
+  const int error = errno;
+  close(probe);
+  return !answered && error == ECONNREFUSED && unlink(path.c_str()) == 0;
+}
+} // namespace
+
+struct DBSCANDaemon::Client {
+  int socket{-1};
+  std::chrono::steady_clock::time_point helloDeadline;
+  void* region{nullptr}; // null until the hello
+  size_t bytes{0};
+  uint32_t nSlots{0};
+  uint32_t capacity{0};
+
+  ~Client()
+  {
+    if (region != nullptr) {
+      munmap(region, bytes);
+    }
+    if (socket >= 0) {
+      close(socket);
+    }
+  }
+};
+
+DBSCANDaemon::DBSCANDaemon(const DBSCANParams& p, std::string socketPath, size_t nWorkers)
+  : mEngine(p), mSocketPath(std::move(socketPath)), mNumWorkers(std::max<size_t>(1, nWorkers))
+{
+  mStopFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+}
+
+DBSCANDaemon::~DBSCANDaemon()
+{
+  if (mStopFd >= 0) {
+    close(mStopFd);
+  }
+}
+
+void DBSCANDaemon::stop()
+{
+  const uint64_t one = 1;
+  [[maybe_unused]] const ssize_t written = write(mStopFd, &one, sizeof(one));
+}
+
+bool DBSCANDaemon::run()
+{
+  // Step 1: Listening socket and event loop
+  sockaddr_un address;
+  if (mStopFd < 0 || !makeAddress(mSocketPath, address)) {
+    return false;
+  }
+  if (!claimSocketPath(mSocketPath, address)) {
+    return false;
+  }
+  mListenFd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+  mEpollFd = epoll_create1(EPOLL_CLOEXEC);
+  if (mListenFd < 0 || mEpollFd < 0 || bind(mListenFd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0 ||
+      chmod(mSocketPath.c_str(), S_IRUSR | S_IWUSR) != 0 || listen(mListenFd, SOMAXCONN) != 0) {
+    for (const int fd : {mListenFd, mEpollFd}) {
+      if (fd >= 0) {
+        close(fd);
+      }
+    }
+    mListenFd = mEpollFd = -1;
+    return false;
+  }
+  for (const int fd : {mListenFd, mStopFd}) {
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    epoll_ctl(mEpollFd, EPOLL_CTL_ADD, fd, &event);
+  }
+
+  mStopping = false;
+  for (size_t w = 0; w < mNumWorkers; ++w) {
+    mWorkers.emplace_back([this] { runWorker(); });
+  }
+
+  // Step 2: Everything that arrived in one wakeup is queued before the
+  // workers are woken, so a burst is ordered by priority as a whole
+  using Clock = std::chrono::steady_clock;
+  auto drop = [&](std::map<int, std::shared_ptr<Client>>::iterator client) {
+    epoll_ctl(mEpollFd, EPOLL_CTL_DEL, client->first, nullptr);
+    return mClients.erase(client); // in-flight jobs keep the region mapped
+  };
+  // Until the first hello is due, or forever
+  auto helloWait = [&] {
+    auto due = Clock::time_point::max();
+    for (const auto& [fd, client] : mClients) {
+      if (client->region == nullptr) {
+        due = std::min(due, client->helloDeadline);
+      }
+    }
+    if (due == Clock::time_point::max()) {
+      return -1;
+    }
+    const auto ms = std::chrono::ceil<std::chrono::milliseconds>(due - Clock::now()).count();
+    return static_cast<int>(std::max<decltype(ms)>(0, ms));
+  };
+  std::array<epoll_event, 64> events;
+  bool stopping = false;
+  while (!stopping) {
+    const int ready = epoll_wait(mEpollFd, events.data(), static_cast<int>(events.size()), helloWait());
+    if (ready < 0 && errno != EINTR) {
+      break;
+    }
+    size_t queued = 0;
+    {
+      std::lock_guard lock(mMutex);
+      queued = mJobs.size();
+    }
+    for (int e = 0; e < ready; ++e) {
+      const int fd = events[static_cast<size_t>(e)].data.fd;
+      if (fd == mStopFd) {
+        stopping = true;
+      } else if (fd == mListenFd) {
+        acceptClient();
+      } else if (const auto client = mClients.find(fd); client != mClients.end()) {
+        bool open = false;
+        if ((events[static_cast<size_t>(e)].events & EPOLLIN) != 0) {
+          open = client->second->region != nullptr ? readRequests(client->second) : receiveHello(*client->second);
+        }
+        if (!open) {
+          drop(client);
+        }
+      }
+    }
+    // Clients that connected but did not say hello in time
+    const auto now = Clock::now();
+    for (auto client = mClients.begin(); client != mClients.end();) {
+      client = client->second->region == nullptr && client->second->helloDeadline <= now ? drop(client) : std::next(client);
+    }
+    std::lock_guard lock(mMutex);
+    if (mJobs.size() > queued) {
+      mCondition.notify_all();
+    }
+  }
+
+  // Step 3: Drain the queue and shut down
+  {
+    std::lock_guard lock(mMutex);
+    mStopping = true;
+  }
+  mCondition.notify_all();
+  for (auto& worker : mWorkers) {
+    worker.join();
+  }
+  mWorkers.clear();
+  mClients.clear();
+  close(mEpollFd);
+  close(mListenFd);
+  mEpollFd = mListenFd = -1;
+  unlink(mSocketPath.c_str());
+  return true;
+}
+
+bool DBSCANDaemon::acceptClient()
+{
+  // Registered right away; the hello arrives as an ordinary read
+  auto client = std::make_shared<Client>();
+  client->socket = accept4(mListenFd, nullptr, nullptr, SOCK_CLOEXEC | SOCK_NONBLOCK);
+  if (client->socket < 0) {
+    return false;
+  }
+  client->helloDeadline = std::chrono::steady_clock::now() + kHelloTimeout;
+  epoll_event event{};
+  event.events = EPOLLIN | EPOLLRDHUP;
+  event.data.fd = client->socket;
+  if (epoll_ctl(mEpollFd, EPOLL_CTL_ADD, client->socket, &event) != 0) {
+    return false;
+  }
+  mClients.emplace(client->socket, std::move(client));
+  return true;
+}
+
+bool DBSCANDaemon::receiveHello(Client& client)
+{
+  // The hello carries the ring header and the region's descriptor
+  DaemonRingHeader hello{};
+  const int regionFd = receiveWithFd(client.socket, &hello, sizeof(hello));
+  if (regionFd < 0) {
+    return false;
+  }
+  struct stat info{};
+  const size_t bytes = daemonRegionBytes(hello.nSlots, hello.capacity);
+  const bool valid = hello.magic == kDaemonMagic && hello.nDim == NDim && hello.nSlots > 0 && hello.capacity > 0 && fstat(regionFd, &info) == 0 &&
+                     static_cast<size_t>(info.st_size) >= bytes;
+  void* region = valid ? mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, regionFd, 0) : MAP_FAILED;
+  close(regionFd);
+  DaemonReply ack{0, 0, 0, 0, 0};
+  if (region == MAP_FAILED) {
+    ack.status = -1;
+    send(client.socket, &ack, sizeof(ack), MSG_NOSIGNAL | MSG_DONTWAIT);
+    return false;
+  }
+  client.region = region;
+  client.bytes = bytes;
+  client.nSlots = hello.nSlots;
+  client.capacity = hello.capacity;
+  return send(client.socket, &ack, sizeof(ack), MSG_NOSIGNAL | MSG_DONTWAIT) == sizeof(ack);
+}
+
+bool DBSCANDaemon::readRequests(const std::shared_ptr<Client>& client)
+{
+  for (;;) {
+    DaemonRequest request{};
+    const ssize_t received = recv(client->socket, &request, sizeof(request), MSG_DONTWAIT);
+    if (received < 0) {
+      return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    }
+    if (received == 0) {
+      return false; // hung up
+    }
+    if (received == sizeof(request)) {
+      std::lock_guard lock(mMutex);
+      mJobs.push({client, request, mSequence++});
+    }
+  }
+}
+
+void DBSCANDaemon::runWorker()
+{
+  for (;;) {
+    Job job;
+    {
+      std::unique_lock lock(mMutex);
+      mCondition.wait(lock, [this] { return mStopping || !mJobs.empty(); });
+      if (mJobs.empty()) {
+        return;
+      }
+      job = mJobs.top();
+      mJobs.pop();
+    }
+    serve(job);
+  }
+}
+
+void DBSCANDaemon::serve(const Job& job)
+{
+  const Client& client = *job.client;
+  const DaemonRequest& request = job.request;
+  DaemonReply reply{request.slot, -1, 0, 0, request.tag};
+  if (request.slot < client.nSlots && request.n <= client.capacity) {
+    // Points are read in place; labels go straight back into the slot
+    const DBSCANResult result = mEngine.cluster(daemonSlotPoints(client.region, client.capacity, request.slot), request.n);
+    std::copy(result.labels.begin(), result.labels.end(), daemonSlotLabels(client.region, client.capacity, request.slot));
+    reply.status = 0;
+    reply.nClusters = result.nClusters;
+    reply.nNoise = result.nNoise;
+  }
+  // Never blocks a worker: a client that does not read its replies (full
+  // socket buffer) is dropped; the event loop sees the hangup
+  if (send(client.socket, &reply, sizeof(reply), MSG_NOSIGNAL | MSG_DONTWAIT) != sizeof(reply)) {
+    shutdown(client.socket, SHUT_RDWR);
+  }
+}
+
+DBSCANDaemonClient::DBSCANDaemonClient(const std::string& socketPath, uint32_t nSlots, uint32_t capacity)
+  : mRegionBytes(daemonRegionBytes(nSlots, capacity)), mCapacity(capacity)
+{
+  // Step 1: The region, in memory only
+  const int regionFd = memfd_create("dbscan-frames", MFD_CLOEXEC);
+  if (regionFd < 0) {
+    return;
+  }
+  if (ftruncate(regionFd, static_cast<off_t>(mRegionBytes)) == 0) {
+    mRegion = mmap(nullptr, mRegionBytes, PROT_READ | PROT_WRITE, MAP_SHARED, regionFd, 0);
+  }
+  if (mRegion == nullptr || mRegion == MAP_FAILED) {
+    mRegion = nullptr;
+    close(regionFd);
+    return;
+  }
+  const DaemonRingHeader header{kDaemonMagic, NDim, nSlots, capacity};
+  std::memcpy(mRegion, &header, sizeof(header));
+
+  // Step 2: Connect and hand over the region
+  sockaddr_un address;
+  mSocket = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+  DaemonReply ack{};
+  const bool ok = mSocket >= 0 && makeAddress(socketPath, address) && connect(mSocket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0 &&
+                  sendWithFd(mSocket, &header, sizeof(header), regionFd) && recv(mSocket, &ack, sizeof(ack), 0) == sizeof(ack) && ack.status == 0;
+  close(regionFd);
+  if (!ok && mSocket >= 0) {
+    close(mSocket);
+    mSocket = -1;
+  }
+}
+
+DBSCANDaemonClient::~DBSCANDaemonClient()
+{
+  if (mSocket >= 0) {
+    close(mSocket);
+  }
+  if (mRegion != nullptr) {
+    munmap(mRegion, mRegionBytes);
+  }
+}
+
+bool DBSCANDaemonClient::submit(uint32_t slot, uint32_t n, int32_t priority, uint64_t tag)
+{
+  const DaemonRequest request{slot, n, priority, 0, tag};
+  return send(mSocket, &request, sizeof(request), MSG_NOSIGNAL) == sizeof(request);
+}
+
+bool DBSCANDaemonClient::wait(DaemonReply& reply)
+{
+  ssize_t received = 0;
+  do {
+    received = recv(mSocket, &reply, sizeof(reply), 0);
+  } while (received < 0 && errno == EINTR);
+  return received == sizeof(reply);
+}
+
+} // namespace dbscan
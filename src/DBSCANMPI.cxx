@@ -0,0 +1,450 @@
+#include "DBSCAN/DBSCANMPI.h"
+#include "DBSCAN/DBSCANUnionFind.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <optional>
+#include <type_traits>
+
+namespace dbscan
+{
+
+namespace
+{
+// Sampled points per rank for the splitting planes
+constexpr size_t kSamplesPerRank = 1024;
+
+// Halo widths are compared in double; widen them a little so a pair within
+// eps in Compute arithmetic is never cut off by rounding
+constexpr double kHaloSlack = 1.001;
+
+using Position = std::array<double, NDim>;
+
+template <typename T>
+Position positionOf(const T* point)
+{
+  Position x;
+  for (size_t d = 0; d < NDim; ++d) {
+    x[d] = static_cast<double>(CoordTraits<T>::load(point[d]));
+  }
+  return x;
+}
+
+// A point on its way to another rank
+template <typename T>
+struct Record {
+  std::array<T, NDim> coords;
+  uint64_t index; // on the sending rank
+};
+
+// k-d tree over the ranks, identical on all of them. Inner nodes split at
+// split along dim, lower coordinates go left; leaves are ranks.
+struct KdNode {
+  int32_t dim{0};
+  double split{0.0};
+  int32_t left{-1};
+  int32_t right{-1};
+  int32_t rank{-1}; // leaves only
+};
+
+struct Sample {
+  Position x;
+  double weight; // points of the sending rank it stands for
+};
+
+int32_t buildTree(std::vector<KdNode>& tree, int32_t lo, int32_t hi, std::span<Sample> samples)
+{
+  const auto node = static_cast<int32_t>(tree.size());
+  tree.emplace_back();
+  if (hi - lo == 1) {
+    tree[static_cast<size_t>(node)].rank = lo;
+    return node;
+  }
+
+  // Split the widest extent at the quantile that gives both halves their
+  // share of ranks
+  const int32_t mid = lo + (hi - lo) / 2;
+  int32_t dim = 0;
+  double widest = -1.0;
+  for (size_t d = 0; d < NDim && !samples.empty(); ++d) {
+    const auto [first, last] = std::minmax_element(samples.begin(), samples.end(), [&](const Sample& a, const Sample& b) { return a.x[d] < b.x[d]; });
+    if (last->x[d] - first->x[d] > widest) {
+      widest = last->x[d] - first->x[d];
+      dim = static_cast<int32_t>(d);
+    }
+  }
+  const auto d = static_cast<size_t>(dim);
+  std::sort(samples.begin(), samples.end(), [&](const Sample& a, const Sample& b) { return a.x[d] < b.x[d]; });
+  double total = 0.0;
+  for (const auto& sample : samples) {
+    total += sample.weight;
+  }
+  const double target = total * (mid - lo) / (hi - lo);
+  size_t cut = 0;
+  for (double sum = 0.0; cut < samples.size() && sum + samples[cut].weight <= target; ++cut) {
+    sum += samples[cut].weight;
+  }
+  // Equal coordinates stay on one side
+  while (cut > 0 && cut < samples.size() && samples[cut - 1].x[d] == samples[cut].x[d]) {
+    --cut;
+  }
+  const double split = cut < samples.size() ? samples[cut].x[d] : (samples.empty() ? 0.0 : samples.back().x[d]);
+
+  const int32_t left = buildTree(tree, lo, mid, samples.first(cut));
+  const int32_t right = buildTree(tree, mid, hi, samples.subspan(cut));
+  tree[static_cast<size_t>(node)] = {dim, split, left, right, -1};
+  return node;
+}
+
+int32_t ownerOf(const std::vector<KdNode>& tree, const Position& x)
+{
+  size_t node = 0;
+  while (tree[node].rank < 0) {
+    node = static_cast<size_t>(x[static_cast<size_t>(tree[node].dim)] < tree[node].split ? tree[node].left : tree[node].right);
+  }
+  return tree[node].rank;
+}
+
+// Ranks whose box is within eps of x
+void haloRanks(const std::vector<KdNode>& tree, size_t node, const Position& x, const Position& eps, std::vector<int32_t>& ranks)
+{
+  const auto& n = tree[node];
+  if (n.rank >= 0) {
+    ranks.push_back(n.rank);
+    return;
+  }
+  const auto d = static_cast<size_t>(n.dim);
+  if (x[d] < n.split + eps[d]) {
+    haloRanks(tree, static_cast<size_t>(n.left), x, eps, ranks);
+  }
+  if (x[d] >= n.split - eps[d]) {
+    haloRanks(tree, static_cast<size_t>(n.right), x, eps, ranks);
+  }
+}
+
+// MPI datatype of one Item, so counts and displacements are in items: int
+// then holds up to 2^31 items per rank rather than 2 GiB
+template <typename Item>
+class RecordType
+{
+ public:
+  RecordType()
+  {
+    MPI_Type_contiguous(static_cast<int>(sizeof(Item)), MPI_BYTE, &mType);
+    MPI_Type_commit(&mType);
+  }
+  ~RecordType() { MPI_Type_free(&mType); }
+  RecordType(const RecordType&) = delete;
+  RecordType& operator=(const RecordType&) = delete;
+
+  operator MPI_Datatype() const { return mType; }
+
+ private:
+  MPI_Datatype mType{MPI_DATATYPE_NULL};
+};
+
+// Personalized all-to-all of trivially copyable items grouped by
+// destination; returns the received items grouped by source, and their
+// counts per source
+template <typename Item>
+std::vector<Item> exchange(MPI_Comm comm, const std::vector<std::vector<Item>>& out, std::vector<int>& recvCounts)
+{
+  static_assert(std::is_trivially_copyable_v<Item>);
+  const RecordType<Item> record;
+  const size_t nRanks = out.size();
+  std::vector<int> sendCounts(nRanks), sendDispl(nRanks), recvDispl(nRanks);
+  std::vector<Item> send;
+  for (size_t r = 0; r < nRanks; ++r) {
+    sendDispl[r] = static_cast<int>(send.size());
+    sendCounts[r] = static_cast<int>(out[r].size());
+    send.insert(send.end(), out[r].begin(), out[r].end());
+  }
+  recvCounts.resize(nRanks);
+  MPI_Alltoall(sendCounts.data(), 1, MPI_INT, recvCounts.data(), 1, MPI_INT, comm);
+  size_t total = 0;
+  for (size_t r = 0; r < nRanks; ++r) {
+    recvDispl[r] = static_cast<int>(total);
+    total += static_cast<size_t>(recvCounts[r]);
+  }
+  std::vector<Item> recv(total);
+  MPI_Alltoallv(send.data(), sendCounts.data(), sendDispl.data(), record, recv.data(), recvCounts.data(), recvDispl.data(), record, comm);
+  return recv;
+}
+
+// The same vector on every rank: the concatenation of all ranks' items
+template <typename Item>
+std::vector<Item> allGather(MPI_Comm comm, const std::vector<Item>& mine)
+{
+  static_assert(std::is_trivially_copyable_v<Item>);
+  const RecordType<Item> record;
+  int nRanks = 0;
+  MPI_Comm_size(comm, &nRanks);
+  const int count = static_cast<int>(mine.size());
+  std::vector<int> counts(static_cast<size_t>(nRanks)), displ(static_cast<size_t>(nRanks));
+  MPI_Allgather(&count, 1, MPI_INT, counts.data(), 1, MPI_INT, comm);
+  int total = 0;
+  for (size_t r = 0; r < counts.size(); ++r) {
+    displ[r] = total;
+    total += counts[r];
+  }
+  std::vector<Item> all(static_cast<size_t>(total));
+  MPI_Allgatherv(mine.data(), count, record, all.data(), counts.data(), displ.data(), record, comm);
+  return all;
+}
+
+DBSCANParams boxParams(DBSCANParams p)
+{
+  p.sortedDim = -1; // boxes arrive in exchange order
+  return p;
+}
+} // namespace
+
+DBSCANMPI::DBSCANMPI(const DBSCANParams& p, MPI_Comm comm) : mParams(p), mDBSCAN(boxParams(p)), mComm(comm)
+{
+  mTaskArena.initialize(mParams.nThreads);
+}
+
+template <typename T>
+DBSCANMPIResult DBSCANMPI::cluster(const T* points, size_t n) const
+{
+  int rankInt = 0;
+  int nRanksInt = 0;
+  MPI_Comm_rank(mComm, &rankInt);
+  MPI_Comm_size(mComm, &nRanksInt);
+  const auto rank = static_cast<int32_t>(rankInt);
+  const auto nRanks = static_cast<size_t>(nRanksInt);
+
+  DBSCANMPIResult result;
+  result.labels.assign(n, DB_NOISE);
+
+  // Step 1: Boxes from a sample of every rank
+  std::vector<KdNode> tree;
+  {
+    SCOPED_TIMER("\tDecomposition");
+    const size_t nSamples = std::min(n, kSamplesPerRank);
+    std::vector<Sample> mine(nSamples);
+    for (size_t s = 0; s < nSamples; ++s) {
+      mine[s] = {positionOf(&points[(s * n / nSamples) * NDim]), static_cast<double>(n) / static_cast<double>(nSamples)};
+    }
+    auto samples = allGather(mComm, mine);
+    buildTree(tree, 0, static_cast<int32_t>(nRanks), samples);
+  }
+
+  // Step 2: Points to the owners of their boxes
+  std::vector<std::vector<Record<T>>> toOwner(nRanks);
+  std::vector<int> fromCounts;
+  std::vector<Record<T>> owned;
+  {
+    SCOPED_TIMER("\tDistribute");
+    for (size_t i = 0; i < n; ++i) {
+      Record<T> record{};
+      std::copy_n(&points[i * NDim], NDim, record.coords.begin());
+      record.index = i;
+      toOwner[static_cast<size_t>(ownerOf(tree, positionOf(&points[i * NDim])))].push_back(record);
+    }
+    owned = exchange(mComm, toOwner, fromCounts);
+  }
+  const size_t nOwned = owned.size();
+
+  // Step 3: Halo copies to the ranks whose box is within eps
+  Position eps;
+  for (size_t d = 0; d < NDim; ++d) {
+    eps[d] = static_cast<double>(CoordTraits<T>::toEps(mParams.eps[d])) * kHaloSlack;
+  }
+  std::vector<std::vector<Record<T>>> toHalo(nRanks);
+  std::vector<int> haloCounts;
+  std::vector<Record<T>> halo;
+  std::vector<uint8_t> sent(nOwned, 0); // owned points some other rank sees
+  {
+    SCOPED_TIMER("\tHalo exchange");
+    std::vector<int32_t> ranks;
+    for (size_t k = 0; k < nOwned; ++k) {
+      ranks.clear();
+      haloRanks(tree, 0, positionOf(owned[k].coords.data()), eps, ranks);
+      for (const int32_t r : ranks) {
+        if (r != rank) {
+          toHalo[static_cast<size_t>(r)].push_back({owned[k].coords, k});
+          sent[k] = 1;
+        }
+      }
+    }
+    halo = exchange(mComm, toHalo, haloCounts);
+  }
+  const size_t nHalo = halo.size();
+  const size_t nLocal = nOwned + nHalo;
+
+  // Step 4: Cluster the box with its halo
+  std::vector<T> coords(nLocal * NDim);
+  for (size_t k = 0; k < nOwned; ++k) {
+    std::copy_n(owned[k].coords.begin(), NDim, &coords[k * NDim]);
+  }
+  for (size_t h = 0; h < nHalo; ++h) {
+    std::copy_n(halo[h].coords.begin(), NDim, &coords[(nOwned + h) * NDim]);
+  }
+  const DBSCANResult local = mDBSCAN.cluster(coords.data(), nLocal);
+
+  // Step 5: Exact core flags of the owned points near other boxes; all their
+  // neighbors are local, owned or halo
+  const BasicDistance<T> distance(mParams.eps);
+  std::optional<BasicGrid<T>> grid;
+  std::vector<uint8_t> core(nOwned, 0);
+  mTaskArena.execute([&] {
+    SCOPED_TIMER("\tHalo core flags");
+    grid.emplace(coords.data(), nLocal, mParams.eps);
+    grid->initGrid();
+    parallelFor(0, nOwned, [&](size_t begin, size_t end) {
+      std::vector<const GridCell*> cells;
+      for (size_t k = begin; k < end; ++k) {
+        if (!sent[k]) {
+          continue;
+        }
+        int32_t count = 0;
+        grid->getNeighborCells(grid->getGridCoords(k), cells);
+        for (const GridCell* cell : cells) {
+          for (const size_t idx : *cell) {
+            count += idx != k && distance.areNeighbors(&coords[k * NDim], &coords[idx * NDim]) ? 1 : 0;
+          }
+        }
+        core[k] = count >= mParams.minPts ? 1 : 0;
+      }
+    });
+  });
+
+  // Step 6: Owners report the cluster of every core halo copy they sent (-1
+  // for non-core ones), in the order of the halo exchange
+  std::vector<int64_t> haloIds;
+  {
+    SCOPED_TIMER("\tHalo reports");
+    std::vector<std::vector<int64_t>> reports(nRanks);
+    for (size_t r = 0; r < nRanks; ++r) {
+      for (const auto& record : toHalo[r]) {
+        reports[r].push_back(core[record.index] ? globalClusterId(rank, local.labels[record.index]) : -1);
+      }
+    }
+    std::vector<int> reportCounts;
+    haloIds = exchange(mComm, reports, reportCounts);
+  }
+
+  // Step 7: Links between local clusters and those of core halo points;
+  // owned noise next to a core halo point becomes its border point
+  std::vector<std::array<int64_t, 2>> edges; // local cluster, halo cluster
+  std::vector<int64_t> border(nOwned, -1);
+  mTaskArena.execute([&] {
+    SCOPED_TIMER("\tCross-box links");
+    std::vector<std::vector<std::array<int64_t, 2>>> blockEdges(nHalo);
+    parallelFor(0, nHalo, [&](size_t begin, size_t end) {
+      std::vector<const GridCell*> cells;
+      for (size_t h = begin; h < end; ++h) {
+        const int64_t id = haloIds[h];
+        const size_t idx = nOwned + h;
+        if (id < 0) {
+          continue;
+        }
+        auto& out = blockEdges[h];
+        if (local.labels[idx] >= 0) {
+          out.push_back({globalClusterId(rank, local.labels[idx]), id});
+        }
+        grid->getNeighborCells(grid->getGridCoords(idx), cells);
+        for (const GridCell* cell : cells) {
+          for (const size_t k : *cell) {
+            if (k >= nOwned || !distance.areNeighbors(&coords[idx * NDim], &coords[k * NDim])) {
+              continue;
+            }
+            if (core[k]) {
+              out.push_back({globalClusterId(rank, local.labels[k]), id});
+            } else if (local.labels[k] < 0) {
+              std::atomic_ref<int64_t>(border[k]).store(id, std::memory_order_relaxed); // any core neighbor will do
+            }
+          }
+        }
+        std::sort(out.begin(), out.end());
+        out.erase(std::unique(out.begin(), out.end()), out.end());
+      }
+    });
+    for (const auto& out : blockEdges) {
+      edges.insert(edges.end(), out.begin(), out.end());
+    }
+    std::sort(edges.begin(), edges.end());
+    edges.erase(std::unique(edges.begin(), edges.end()), edges.end());
+  });
+
+  // Step 8: Every rank unites all links; a cluster takes its smallest id
+  std::vector<int64_t> keys;
+  std::unique_ptr<std::atomic<size_t>[]> parent;
+  {
+    SCOPED_TIMER("\tGlobal union-find");
+    const auto all = allGather(mComm, edges);
+    for (const auto& [a, b] : all) {
+      keys.push_back(a);
+      keys.push_back(b);
+    }
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    parent = std::make_unique<std::atomic<size_t>[]>(keys.size());
+    for (size_t k = 0; k < keys.size(); ++k) {
+      parent[k].store(k, std::memory_order_relaxed);
+    }
+    auto indexOf = [&](int64_t key) { return static_cast<size_t>(std::lower_bound(keys.begin(), keys.end(), key) - keys.begin()); };
+    for (const auto& [a, b] : all) {
+      unite(parent.get(), indexOf(a), indexOf(b));
+    }
+  }
+  auto globalOf = [&](int64_t key) {
+    const auto it = std::lower_bound(keys.begin(), keys.end(), key);
+    return it != keys.end() && *it == key ? keys[find(parent.get(), static_cast<size_t>(it - keys.begin()))] : key;
+  };
+
+  // Step 9: Labels back to the ranks the points came from
+  std::vector<std::vector<int64_t>> labelsBack(nRanks);
+  int64_t nNoise = 0;
+  std::vector<int64_t> localOnly; // clusters that never crossed a box
+  {
+    SCOPED_TIMER("\tReturn labels");
+    size_t k = 0;
+    for (size_t r = 0; r < nRanks; ++r) {
+      for (int c = 0; c < fromCounts[r]; ++c, ++k) {
+        int64_t label = DB_NOISE;
+        if (local.labels[k] >= 0) {
+          const int64_t key = globalClusterId(rank, local.labels[k]);
+          label = globalOf(key);
+          if (!std::binary_search(keys.begin(), keys.end(), key)) {
+            localOnly.push_back(key);
+          }
+        } else if (border[k] >= 0) {
+          label = globalOf(border[k]);
+        } else {
+          ++nNoise;
+        }
+        labelsBack[r].push_back(label);
+      }
+    }
+    std::vector<int> backCounts;
+    const auto back = exchange(mComm, labelsBack, backCounts);
+    size_t j = 0;
+    for (size_t r = 0; r < nRanks; ++r) {
+      for (const auto& record : toOwner[r]) {
+        result.labels[record.index] = back[j++];
+      }
+    }
+  }
+
+  // Step 10: Totals; linked clusters are counted by their canonical id, the
+  // same on every rank
+  std::sort(localOnly.begin(), localOnly.end());
+  auto nLocalOnly = static_cast<int64_t>(std::unique(localOnly.begin(), localOnly.end()) - localOnly.begin());
+  int64_t nLinked = 0;
+  for (size_t k = 0; k < keys.size(); ++k) {
+    nLinked += find(parent.get(), k) == k ? 1 : 0;
+  }
+  MPI_Allreduce(&nLocalOnly, &result.nClusters, 1, MPI_INT64_T, MPI_SUM, mComm);
+  MPI_Allreduce(&nNoise, &result.nNoise, 1, MPI_INT64_T, MPI_SUM, mComm);
+  result.nClusters += nLinked;
+  return result;
+}
+
+#define DBSCAN_INSTANTIATE(T) template DBSCANMPIResult DBSCANMPI::cluster<T>(const T*, size_t) const;
+DBSCAN_FOR_EACH_COORD_TYPE(DBSCAN_INSTANTIATE)
+#undef DBSCAN_INSTANTIATE
+
+} // namespace dbscan
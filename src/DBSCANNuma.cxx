@@ -0,0 +1,219 @@
+#include "DBSCAN/DBSCAN.h"
+#include "DBSCAN/DBSCANStitch.h"
+#include <algorithm>
+#include <limits>
+#include <thread>
+
+namespace dbscan
+{
+
+namespace
+{
+// Sampled coordinates for the cut positions
+constexpr size_t kPartitionSamples = 1 << 16;
+
+// Slabs must be wider than eps for stitch(); compared in double, so keep a
+// margin against rounding
+constexpr double kSlabSlack = 1.001;
+
+// Smallest block of points bucketed by one task
+constexpr size_t kBucketBlock = 16384;
+
+// Points, labels and boundaries of one slab
+template <typename T>
+struct Slab {
+  std::vector<size_t> ids; // input indices, ascending
+  std::vector<T> coords;
+  DBSCANResult result;
+};
+} // namespace
+
+void DBSCAN::createPartitions()
+{
+  const auto nodes = numaNodes();
+  const auto nSlabs = static_cast<size_t>(mParams.numaPartitions < 0 ? static_cast<int32_t>(nodes.size()) : mParams.numaPartitions);
+  if (nSlabs < 2) {
+    return;
+  }
+  // Automatic thread counts are per node; several slabs on one node share it
+  const size_t perNode = (nSlabs + nodes.size() - 1) / nodes.size();
+  for (size_t s = 0; s < nSlabs; ++s) {
+    DBSCANParams p = mParams;
+    p.numaPartitions = 0;
+    p.numaNode = nodes[s % nodes.size()];
+    p.cpus.clear(); // the node decides
+    if (mParams.nThreads > 0) {
+      p.nThreads = std::max<int32_t>(1, mParams.nThreads / static_cast<int32_t>(nSlabs));
+    } else if (perNode > 1) {
+      p.nThreads = static_cast<int32_t>(std::max<size_t>(1, std::thread::hardware_concurrency() / nSlabs));
+    }
+    mPartitions.push_back(std::make_unique<DBSCAN>(p));
+  }
+}
+
+template <typename T>
+bool DBSCAN::clusterPartitioned(const T* points, size_t n, const DBSCANCallOptions& options, DBSCANResult& result) const
+{
+  auto coordinate = [&](size_t i, size_t d) { return static_cast<double>(CoordTraits<T>::load(points[(i * NDim) + d])); };
+
+  // Step 1: Cuts at quantiles of a sample, across its widest dimension
+  std::vector<double> cuts;
+  size_t dim = 0;
+  {
+    SCOPED_TIMER("\tNUMA cuts");
+    const size_t nSamples = std::min(n, kPartitionSamples);
+    std::vector<double> sample(nSamples);
+    double widest = -1.0;
+    for (size_t d = 0; d < NDim; ++d) {
+      for (size_t s = 0; s < nSamples; ++s) {
+        sample[s] = coordinate(s * n / nSamples, d);
+      }
+      const auto [low, high] = std::minmax_element(sample.begin(), sample.end());
+      if (*high - *low > widest) {
+        widest = *high - *low;
+        dim = d;
+      }
+    }
+    for (size_t s = 0; s < nSamples; ++s) {
+      sample[s] = coordinate(s * n / nSamples, dim);
+    }
+    std::sort(sample.begin(), sample.end());
+    const double eps = static_cast<double>(CoordTraits<T>::toEps(mParams.eps[dim])) * kSlabSlack;
+    for (size_t s = 1; s < mPartitions.size(); ++s) {
+      const double cut = sample[s * nSamples / mPartitions.size()];
+      if (cut > sample.front() && (cuts.empty() || cut - cuts.back() > eps)) {
+        cuts.push_back(cut);
+      }
+    }
+  }
+  if (cuts.empty()) {
+    return false;
+  }
+  const size_t nSlabs = cuts.size() + 1;
+
+  // Step 2: Bucket the points by slab in one pass: per-block counts, then a
+  // stable scatter of the indices, so slab s owns order[start[s], start[s + 1])
+  std::vector<size_t> order(n), start(nSlabs + 1);
+  {
+    SCOPED_TIMER("\tNUMA buckets");
+    auto slabOf = [&](size_t i) { return static_cast<size_t>(std::upper_bound(cuts.begin(), cuts.end(), coordinate(i, dim)) - cuts.begin()); };
+    mTaskArena.execute([&] {
+      const size_t nBlocks = std::max<size_t>(1, std::min(detail::hardwareThreads() * 4, n / kBucketBlock));
+      std::vector<size_t> offsets(nBlocks * nSlabs);
+      auto blockRange = [&](size_t b) { return std::pair{b * n / nBlocks, (b + 1) * n / nBlocks}; };
+      parallelFor(0, nBlocks, [&](size_t bb, size_t be) {
+        for (size_t b = bb; b < be; ++b) {
+          const auto [begin, end] = blockRange(b);
+          for (size_t i = begin; i < end; ++i) {
+            ++offsets[(b * nSlabs) + slabOf(i)];
+          }
+        } }, 1);
+      for (size_t sl = 0; sl < nSlabs; ++sl) {
+        start[sl + 1] = start[sl];
+        for (size_t b = 0; b < nBlocks; ++b) {
+          const size_t count = offsets[(b * nSlabs) + sl];
+          offsets[(b * nSlabs) + sl] = start[sl + 1];
+          start[sl + 1] += count;
+        }
+      }
+      parallelFor(0, nBlocks, [&](size_t bb, size_t be) {
+        for (size_t b = bb; b < be; ++b) {
+          const auto [begin, end] = blockRange(b);
+          for (size_t i = begin; i < end; ++i) {
+            order[offsets[(b * nSlabs) + slabOf(i)]++] = i;
+          }
+        } }, 1);
+    });
+  }
+
+  // Step 3: Every slab gathers its points, clusters them and describes its
+  // boundaries on its own node, so its buffers and grid are first touched there
+  std::vector<Slab<T>> slabs(nSlabs);
+  DBSCANCallOptions slabOptions; // progress is reported for the slabs as a whole
+  slabOptions.cancel = options.cancel;
+  slabOptions.deadline = options.deadline;
+  std::vector<BoundaryDescriptor<T>> descriptors(2 * cuts.size()); // lower and upper side of each cut
+  auto runSlab = [&](size_t s) {
+    const DBSCAN& engine = *mPartitions[s];
+    auto& slab = slabs[s];
+    const size_t m = start[s + 1] - start[s];
+    engine.mTaskArena.execute([&] {
+      slab.ids.resize(m);
+      slab.coords.resize(m * NDim);
+      parallelFor(0, m, [&](size_t begin, size_t end) {
+        for (size_t k = begin; k < end; ++k) {
+          const size_t i = order[start[s] + k];
+          slab.ids[k] = i;
+          std::copy_n(&points[i * NDim], NDim, &slab.coords[k * NDim]);
+        }
+      });
+    });
+    slab.result = engine.cluster(slab.coords.data(), slab.ids.size(), slabOptions);
+    if (slab.result.status != DBSCANStatus::Complete) {
+      return;
+    }
+    const auto chunk = static_cast<int32_t>(s);
+    if (s > 0) {
+      descriptors[(2 * s) - 1] = engine.exportBoundary(slab.coords.data(), slab.ids.size(), slab.result, chunk, StitchCut{static_cast<int32_t>(dim), cuts[s - 1]});
+    }
+    if (s < cuts.size()) {
+      descriptors[2 * s] = engine.exportBoundary(slab.coords.data(), slab.ids.size(), slab.result, chunk, StitchCut{static_cast<int32_t>(dim), cuts[s]});
+    }
+  };
+  {
+    SCOPED_TIMER("\tNUMA slabs");
+    const detail::ControlScope unchecked(nullptr); // the slabs poll their own options; nothing may throw before the joins
+    std::vector<std::thread> threads;
+    for (size_t s = 1; s < nSlabs; ++s) {
+      threads.emplace_back(runSlab, s);
+    }
+    runSlab(0);
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+  if (std::any_of(slabs.begin(), slabs.end(), [](const Slab<T>& slab) { return slab.result.status != DBSCANStatus::Complete; })) {
+    throw detail::Interrupted{};
+  }
+
+  // Step 4: Join the slabs; a cluster is labelled by the input index of the
+  // root it keeps
+  StitchResult stitched;
+  {
+    SCOPED_TIMER("\tNUMA stitch");
+    stitched = stitch<T>(descriptors, mParams);
+  }
+  {
+    SCOPED_TIMER("\tNUMA labels");
+    const detail::ControlScope unchecked(nullptr);
+    std::vector<std::thread> threads;
+    auto relabel = [&](size_t s) {
+      const auto& slab = slabs[s];
+      const auto chunk = static_cast<int32_t>(s);
+      const auto remap = std::find_if(stitched.chunks.begin(), stitched.chunks.end(), [&](const StitchRemap& r) { return r.chunk == chunk; });
+      mPartitions[s]->mTaskArena.execute([&] {
+        parallelFor(0, slab.ids.size(), [&](size_t begin, size_t end) {
+          for (size_t k = begin; k < end; ++k) {
+            const int32_t label = slab.result.labels[k];
+            const int64_t id = remap != stitched.chunks.end() ? remap->globalId(k, label) : label < 0 ? label : globalClusterId(chunk, label);
+            result.labels[slab.ids[k]] = id < 0 ? static_cast<int32_t>(id) : static_cast<int32_t>(slabs[static_cast<size_t>(id >> 32)].ids[static_cast<size_t>(id & 0xffffffff)]);
+          }
+        });
+      });
+    };
+    for (size_t s = 1; s < nSlabs; ++s) {
+      threads.emplace_back(relabel, s);
+    }
+    relabel(0);
+    for (auto& thread : threads) {
+      thread.join();
+    }
+  }
+  return true;
+}
+
+#define DBSCAN_INSTANTIATE(T) template bool DBSCAN::clusterPartitioned<T>(const T*, size_t, const DBSCANCallOptions&, DBSCANResult&) const;
+DBSCAN_FOR_EACH_COORD_TYPE(DBSCAN_INSTANTIATE)
+#undef DBSCAN_INSTANTIATE
+
+} // namespace dbscan
@@ -0,0 +1,167 @@
+#include "DBSCAN/DBSCANPipeline.h"
+#include "DBSCAN/DBSCANGrid.h"
+#include <chrono>
+#include <optional>
+
+namespace dbscan
+{
+
+struct DBSCANPipeline::Frame {
+  std::vector<float> points;
+  size_t n{0};
+  std::optional<Grid> grid;
+  std::unique_ptr<DBSCANWorkspace> workspace;
+  int32_t threads{0}; // the tuner's choice for n, kept through every stage
+  double seconds{0};  // time spent in the stages so far
+  DBSCANResult result;
+  std::promise<DBSCANResult> promise;
+};
+
+void DBSCANPipeline::FrameQueue::push(std::unique_ptr<Frame> frame)
+{
+  {
+    std::lock_guard lock(mMutex);
+    mFrames.push_back(std::move(frame));
+  }
+  mCondition.notify_one();
+}
+
+std::unique_ptr<DBSCANPipeline::Frame> DBSCANPipeline::FrameQueue::pop()
+{
+  std::unique_lock lock(mMutex);
+  mCondition.wait(lock, [this] { return mClosed || !mFrames.empty(); });
+  if (mFrames.empty()) {
+    return nullptr;
+  }
+  auto frame = std::move(mFrames.front());
+  mFrames.pop_front();
+  return frame;
+}
+
+void DBSCANPipeline::FrameQueue::close()
+{
+  {
+    std::lock_guard lock(mMutex);
+    mClosed = true;
+  }
+  mCondition.notify_all();
+}
+
+DBSCANPipeline::DBSCANPipeline(const DBSCANParams& p, size_t maxInFlight)
+  : mEngine(p), mStaged(NDim > 1 && p.engine == Engine::PointGraph && p.numaPartitions == 0), mSlots(static_cast<std::ptrdiff_t>(std::max<size_t>(1, maxInFlight))), mWorkspaces(maxInFlight)
+{
+  for (size_t stage = 0; stage < N_STAGES; ++stage) {
+    mThreads.emplace_back([this, stage] { runStage(static_cast<Stage>(stage)); });
+  }
+}
+
+DBSCANPipeline::~DBSCANPipeline()
+{
+  // Closing the first queue drains the pipeline front to back
+  mQueues[STAGE_GRID].close();
+  for (auto& thread : mThreads) {
+    thread.join();
+  }
+}
+
+std::future<DBSCANResult> DBSCANPipeline::submit(std::vector<float> points)
+{
+  mSlots.acquire();
+
+  auto frame = std::make_unique<Frame>();
+  frame->n = points.size() / NDim;
+  frame->points = std::move(points);
+  frame->workspace = mWorkspaces.acquire();
+  auto future = frame->promise.get_future();
+  mQueues[STAGE_GRID].push(std::move(frame));
+  return future;
+}
+
+void DBSCANPipeline::runStage(Stage stage)
+{
+  while (auto frame = mQueues[stage].pop()) {
+    try {
+      processStage(stage, *frame);
+    } catch (...) {
+      frame->promise.set_exception(std::current_exception());
+      finishFrame(std::move(frame));
+      continue;
+    }
+
+    if (stage + 1 < N_STAGES) {
+      mQueues[stage + 1].push(std::move(frame));
+    } else {
+      frame->promise.set_value(std::move(frame->result));
+      finishFrame(std::move(frame));
+    }
+  }
+  // Propagate shutdown once this stage has drained
+  if (stage + 1 < N_STAGES) {
+    mQueues[stage + 1].close();
+  }
+}
+
+void DBSCANPipeline::processStage(Stage stage, Frame& frame)
+{
+  const size_t n = frame.n;
+  if (!mStaged) {
+    if (stage == STAGE_GRID) {
+      frame.result = mEngine.cluster(frame.points.data(), n);
+    }
+    return;
+  }
+
+  // The frame's thread count, as cluster() would run it; the tuner learns
+  // from the time of all stages together
+  if (stage == STAGE_GRID && n > 0) {
+    frame.threads = mEngine.mTuner.choose(n);
+  }
+  const TaskArena::Degree degree(frame.threads);
+  const auto start = std::chrono::steady_clock::now();
+  switch (stage) {
+    case STAGE_GRID:
+      frame.result.labels.assign(n, DB_UNVISITED);
+      if (n > 0) {
+        frame.workspace->prepare(n);
+        mEngine.mTaskArena.execute([&] {
+          frame.grid.emplace(frame.points.data(), n, mEngine.mParams.eps);
+          frame.grid->initGrid();
+          if (mEngine.mParams.compactCoords) {
+            frame.grid->buildCompactCoords();
+          }
+        });
+      }
+      break;
+    case STAGE_NEIGHBORS:
+      if (n > 0) {
+        mEngine.findNeighbors(frame.points.data(), n, *frame.grid, *frame.workspace);
+      }
+      frame.grid.reset();
+      break;
+    case STAGE_UNION:
+      if (n > 0) {
+        mEngine.linkCorePoints(n, *frame.workspace);
+      }
+      break;
+    case STAGE_RELABEL:
+      if (n > 0) {
+        mEngine.assignLabels(n, *frame.workspace, frame.result.labels);
+        mEngine.countClusters(frame.result);
+      }
+      break;
+    default:
+      break;
+  }
+  frame.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  if (stage == STAGE_RELABEL) {
+    mEngine.mTuner.record(n, frame.threads, frame.seconds);
+  }
+}
+
+void DBSCANPipeline::finishFrame(std::unique_ptr<Frame> frame)
+{
+  mWorkspaces.release(std::move(frame->workspace));
+  mSlots.release();
+}
+
+} // namespace dbscan
@@ -0,0 +1,270 @@
+#include "DBSCAN/DBSCAN.h"
+#include "DBSCAN/DBSCANUnionFind.h"
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+namespace dbscan
+{
+
+namespace
+{
+// Core flags, computed on first use
+enum CoreState : uint8_t {
+  kUnknown = 0,
+  kCore = 1,
+  kNotCore = 2,
+};
+
+// Per-block results appended to shared lists
+struct Collector {
+  std::mutex mutex;
+  std::vector<size_t> items;
+
+  void append(const std::vector<size_t>& local)
+  {
+    if (!local.empty()) {
+      const std::lock_guard lock(mutex);
+      items.insert(items.end(), local.begin(), local.end());
+    }
+  }
+};
+} // namespace
+
+template <typename T>
+DBSCANResult DBSCAN::clusterRegion(const T* points, size_t n, const std::array<T, NDim>& lower, const std::array<T, NDim>& upper,
+                                   const DBSCANCallOptions& options) const
+{
+  using Traits = CoordTraits<T>;
+  DBSCANResult result;
+  result.labels.resize(n, DB_UNVISITED);
+  if (n == 0) {
+    return result;
+  }
+  const TaskArena::Call call(mTaskArena, mParams.spinMicros);
+  runControlled(n, options, result, [&] {
+    const BasicDistance<T> distance(mParams.eps);
+    BasicGrid<T> grid(points, n, mParams.eps);
+    {
+      SCOPED_TIMER("\tinit grid");
+      grid.initGrid();
+    }
+    const auto minPts = static_cast<size_t>(std::max(0, mParams.minPts));
+    auto& labels = result.labels;
+    std::vector<uint8_t> state(n, kUnknown);
+
+    auto forEachNeighbor = [&](size_t i, std::vector<const GridCell*>& cells, auto&& f) {
+      grid.getNeighborCells(grid.getGridCoords(i), cells);
+      for (const GridCell* cell : cells) {
+        for (auto idx : *cell) {
+          if (idx != i && distance.areNeighbors(&points[i * NDim], &points[idx * NDim])) {
+            f(idx);
+          }
+        }
+      }
+    };
+    // Same test as the engines: a cell holding more than minPts points is
+    // core throughout, otherwise count up to minPts neighbors
+    auto isCore = [&](size_t i, std::vector<const GridCell*>& cells) {
+      std::atomic_ref<uint8_t> flag(state[i]);
+      const uint8_t known = flag.load(std::memory_order_relaxed);
+      if (known != kUnknown) {
+        return known == kCore;
+      }
+      bool core = grid.getCell(grid.getGridCoords(i))->size() > minPts;
+      if (!core) {
+        grid.getNeighborCells(grid.getGridCoords(i), cells);
+        size_t count = 0;
+        for (const GridCell* cell : cells) {
+          for (auto idx : *cell) {
+            if (idx != i && distance.areNeighbors(&points[i * NDim], &points[idx * NDim])) {
+              ++count;
+            }
+          }
+          if (count >= minPts) {
+            break;
+          }
+        }
+        core = count >= minPts;
+      }
+      flag.store(core ? kCore : kNotCore, std::memory_order_relaxed); // racing writers agree
+      return core;
+    };
+    auto inBox = [&](size_t i) {
+      for (size_t d = 0; d < NDim; ++d) {
+        const auto x = Traits::load(points[(i * NDim) + d]);
+        if (x < Traits::load(lower[d]) || x > Traits::load(upper[d])) {
+          return false;
+        }
+      }
+      return true;
+    };
+
+    mTaskArena.execute([&] {
+      // Step 1: Points in the box, from the cells it overlaps
+      Collector box;
+      {
+        SCOPED_TIMER("\tregion points");
+        const GridCoord first = grid.getGridCoordsOf(lower.data());
+        const GridCoord last = grid.getGridCoordsOf(upper.data());
+        size_t nCells = 1;
+        for (size_t d = 0; d < NDim; ++d) {
+          nCells *= static_cast<size_t>(std::max(0, last[d] - first[d] + 1));
+        }
+        parallelFor(0, nCells, [&](size_t begin, size_t end) {
+          std::vector<size_t> local;
+          for (size_t c = begin; c < end; ++c) {
+            GridCoord coords;
+            size_t rest = c;
+            for (size_t d = 0; d < NDim; ++d) {
+              const auto span = static_cast<size_t>(last[d] - first[d] + 1);
+              coords[d] = first[d] + static_cast<int32_t>(rest % span);
+              rest /= span;
+            }
+            for (auto idx : *grid.getCell(coords)) {
+              if (inBox(idx)) {
+                local.push_back(idx);
+              }
+            }
+          }
+          box.append(local);
+        });
+      }
+
+      // Step 2: Core points the clusters touching the box grow from: the
+      // box's own, and the core neighbors of its other points
+      Collector seeds;
+      {
+        SCOPED_TIMER("\tseeds");
+        parallelFor(0, box.items.size(), [&](size_t begin, size_t end) {
+          std::vector<size_t> local;
+          std::vector<const GridCell*> cells, inner;
+          for (size_t k = begin; k < end; ++k) {
+            const size_t i = box.items[k];
+            if (isCore(i, cells)) {
+              local.push_back(i);
+              continue;
+            }
+            forEachNeighbor(i, cells, [&](size_t q) {
+              if (isCore(q, inner)) {
+                local.push_back(q);
+              }
+            });
+          }
+          seeds.append(local);
+        });
+      }
+
+      // Step 3: Breadth-first expansion over core points, level by level.
+      // A point is claimed by writing the index of the seed that reached it
+      // into its label; seeds meeting on a core point are united.
+      const size_t nSeeds = seeds.items.size();
+      auto seedParent = std::make_unique<std::atomic<size_t>[]>(nSeeds);
+      Collector core, border;
+      {
+        SCOPED_TIMER("\texpansion");
+        std::vector<size_t> frontier;
+        for (size_t s = 0; s < nSeeds; ++s) {
+          seedParent[s].store(s, std::memory_order_relaxed);
+          const size_t i = seeds.items[s];
+          std::atomic_ref<int32_t> label(labels[i]);
+          int32_t expected = DB_UNVISITED;
+          if (label.compare_exchange_strong(expected, static_cast<int32_t>(s), std::memory_order_relaxed)) {
+            frontier.push_back(i);
+          } else {
+            unite(seedParent.get(), s, static_cast<size_t>(expected));
+          }
+        }
+        core.items = frontier;
+        Collector next;
+        while (!frontier.empty()) {
+          next.items.clear();
+          parallelFor(0, frontier.size(), [&](size_t begin, size_t end) {
+            std::vector<size_t> reached, attached;
+            std::vector<const GridCell*> cells, inner;
+            for (size_t k = begin; k < end; ++k) {
+              const size_t c = frontier[k];
+              const int32_t seed = std::atomic_ref<int32_t>(labels[c]).load(std::memory_order_relaxed);
+              forEachNeighbor(c, cells, [&](size_t q) {
+                const bool qCore = isCore(q, inner);
+                std::atomic_ref<int32_t> label(labels[q]);
+                int32_t expected = DB_UNVISITED;
+                if (label.compare_exchange_strong(expected, seed, std::memory_order_relaxed)) {
+                  (qCore ? reached : attached).push_back(q);
+                } else if (qCore && expected != seed) {
+                  unite(seedParent.get(), static_cast<size_t>(seed), static_cast<size_t>(expected));
+                }
+              });
+            }
+            next.append(reached);
+            border.append(attached);
+          });
+          core.items.insert(core.items.end(), next.items.begin(), next.items.end());
+          frontier.swap(next.items);
+        }
+      }
+
+      // Step 4: Cluster id = smallest core point index in the component, as
+      // in cluster(); border points take the cluster that reached them
+      // first, points of the box left over are noise
+      {
+        SCOPED_TIMER("\tregion labels");
+        std::unique_ptr<std::atomic<size_t>[]> minCore(new std::atomic<size_t>[nSeeds]);
+        parallelFor(0, nSeeds, [&](size_t begin, size_t end) {
+          for (size_t s = begin; s < end; ++s) {
+            minCore[s].store(std::numeric_limits<size_t>::max(), std::memory_order_relaxed);
+          }
+        });
+        parallelFor(0, core.items.size(), [&](size_t begin, size_t end) {
+          for (size_t k = begin; k < end; ++k) {
+            const size_t i = core.items[k];
+            auto& slot = minCore[find(seedParent.get(), static_cast<size_t>(labels[i]))];
+            size_t current = slot.load(std::memory_order_relaxed);
+            while (i < current && !slot.compare_exchange_weak(current, i, std::memory_order_relaxed)) {
+            }
+          }
+        });
+        auto relabel = [&](const std::vector<size_t>& items) {
+          return parallelReduce(
+            0, items.size(), int32_t{-1},
+            [&](size_t begin, size_t end, int32_t acc) {
+              for (size_t k = begin; k < end; ++k) {
+                const size_t i = items[k];
+                labels[i] = static_cast<int32_t>(minCore[find(seedParent.get(), static_cast<size_t>(labels[i]))].load(std::memory_order_relaxed));
+                acc = std::max(acc, labels[i]);
+              }
+              return acc;
+            },
+            [](int32_t a, int32_t b) { return std::max(a, b); });
+        };
+        const int32_t maxBorder = relabel(border.items);
+        const int32_t maxCore = relabel(core.items);
+        result.nClusters = std::max(maxBorder, maxCore) + 1;
+        result.nNoise = parallelReduce(
+          0, box.items.size(), int32_t{0},
+          [&](size_t begin, size_t end, int32_t acc) {
+            for (size_t k = begin; k < end; ++k) {
+              int32_t& label = labels[box.items[k]];
+              if (label == DB_UNVISITED) {
+                label = DB_NOISE;
+                ++acc;
+              }
+            }
+            return acc;
+          },
+          [](int32_t a, int32_t b) { return a + b; });
+      }
+    });
+  });
+  return result;
+}
+
+#define DBSCAN_INSTANTIATE(T) \
+  template DBSCANResult DBSCAN::clusterRegion<T>(const T*, size_t, const std::array<T, NDim>&, const std::array<T, NDim>&, const DBSCANCallOptions&) const;
+DBSCAN_FOR_EACH_COORD_TYPE(DBSCAN_INSTANTIATE)
+#undef DBSCAN_INSTANTIATE
+
+} // namespace dbscan
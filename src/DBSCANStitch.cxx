@@ -0,0 +1,255 @@
+#include "DBSCAN/DBSCAN.h"
+#include "DBSCAN/DBSCANStitch.h"
+#include "DBSCAN/DBSCANUnionFind.h"
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <optional>
+#include <tuple>
+
+namespace dbscan
+{
+
+namespace
+{
+// Band widths are compared in double; widen them a little so a pair within
+// eps in Compute arithmetic is never cut off by rounding
+constexpr double kBandSlack = 1.001;
+
+template <typename T>
+double cutDistance(const T* point, const StitchCut& cut)
+{
+  return std::abs(static_cast<double>(CoordTraits<T>::load(point[cut.dim])) - cut.position);
+}
+
+template <typename T>
+double cutEps(const DBSCANParams& p, const StitchCut& cut)
+{
+  return static_cast<double>(CoordTraits<T>::toEps(p.eps[static_cast<size_t>(cut.dim)])) * kBandSlack;
+}
+} // namespace
+
+template <typename T>
+BoundaryDescriptor<T> DBSCAN::exportBoundary(const T* points, size_t n, const DBSCANResult& result, int32_t chunk, const StitchCut& cut) const
+{
+  const double eps = cutEps<T>(mParams, cut);
+  BoundaryDescriptor<T> descriptor{chunk, cut, {}, {}, {}, {}};
+  mTaskArena.execute([&] {
+    // Step 1: Points within 3 eps: the 2 eps band and everything its
+    // neighbor counts need
+    std::vector<size_t> slot(n);
+    parallelFor(0, n, [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; ++i) {
+        slot[i] = cutDistance(&points[i * NDim], cut) <= 3 * eps ? 1 : 0;
+      }
+    });
+    const size_t nNear = parallelExclusiveScan(slot.data(), slot.data(), n);
+    std::vector<size_t> near(nNear);
+    std::vector<T> coords(nNear * NDim);
+    parallelFor(0, n, [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; ++i) {
+        if ((i + 1 < n ? slot[i + 1] : nNear) != slot[i]) { // flag of i, from the scan
+          near[slot[i]] = i;
+          std::copy_n(&points[i * NDim], NDim, &coords[slot[i] * NDim]);
+        }
+      }
+    });
+
+    // Step 2: Local neighbor counts of the band points
+    BasicGrid<T> grid(coords.data(), nNear, mParams.eps);
+    grid.initGrid();
+    const BasicDistance<T> distance(mParams.eps);
+    std::vector<int32_t> counts(nNear, -1);
+    parallelFor(0, nNear, [&](size_t begin, size_t end) {
+      std::vector<const GridCell*> cells;
+      for (size_t k = begin; k < end; ++k) {
+        const T* query = &coords[k * NDim];
+        if (cutDistance(query, cut) > 2 * eps) {
+          continue;
+        }
+        int32_t count = 0;
+        grid.getNeighborCells(grid.getGridCoords(k), cells);
+        for (const GridCell* cell : cells) {
+          for (const size_t idx : *cell) {
+            count += idx != k && distance.areNeighbors(query, &coords[idx * NDim]) ? 1 : 0;
+          }
+        }
+        counts[k] = count;
+      }
+    });
+
+    for (size_t k = 0; k < nNear; ++k) {
+      if (counts[k] >= 0) {
+        descriptor.ids.push_back(near[k]);
+        descriptor.points.insert(descriptor.points.end(), &coords[k * NDim], &coords[(k + 1) * NDim]);
+        descriptor.labels.push_back(result.labels[near[k]]);
+        descriptor.counts.push_back(counts[k]);
+      }
+    }
+  });
+  return descriptor;
+}
+
+template <typename T>
+StitchResult stitch(std::span<const BoundaryDescriptor<T>> descriptors, const DBSCANParams& p)
+{
+  const BasicDistance<T> distance(p.eps);
+
+  // Points seen from several cuts (narrow chunks) are one node
+  struct Node {
+    int32_t chunk;
+    size_t id;
+    int32_t label;
+    int32_t count;    // local neighbors
+    int32_t cross{0}; // neighbors in other chunks
+  };
+  std::vector<std::tuple<int32_t, size_t, size_t, size_t>> entries; // chunk, id, descriptor, position
+  for (size_t d = 0; d < descriptors.size(); ++d) {
+    for (size_t k = 0; k < descriptors[d].ids.size(); ++k) {
+      entries.emplace_back(descriptors[d].chunk, descriptors[d].ids[k], d, k);
+    }
+  }
+  std::sort(entries.begin(), entries.end());
+  std::vector<Node> nodes;
+  std::vector<std::vector<size_t>> nodeOf(descriptors.size());
+  for (size_t d = 0; d < descriptors.size(); ++d) {
+    nodeOf[d].resize(descriptors[d].ids.size());
+  }
+  for (const auto& [chunk, id, d, k] : entries) {
+    if (nodes.empty() || nodes.back().chunk != chunk || nodes.back().id != id) {
+      nodes.push_back({chunk, id, descriptors[d].labels[k], descriptors[d].counts[k]});
+    }
+    nodeOf[d][k] = nodes.size() - 1;
+  }
+
+  // Descriptors sharing a cut are joined over one grid
+  struct Cut {
+    std::vector<T> coords;
+    std::vector<size_t> nodes;
+    std::optional<BasicGrid<T>> grid;
+  };
+  std::vector<size_t> order(descriptors.size());
+  for (size_t d = 0; d < order.size(); ++d) {
+    order[d] = d;
+  }
+  auto cutKey = [&](size_t d) { return std::make_pair(descriptors[d].cut.dim, descriptors[d].cut.position); };
+  std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return cutKey(a) < cutKey(b); });
+  std::vector<Cut> cuts;
+  for (size_t o = 0; o < order.size(); ++o) {
+    if (o == 0 || cutKey(order[o]) != cutKey(order[o - 1])) {
+      cuts.emplace_back();
+    }
+    const auto& descriptor = descriptors[order[o]];
+    cuts.back().coords.insert(cuts.back().coords.end(), descriptor.points.begin(), descriptor.points.end());
+    cuts.back().nodes.insert(cuts.back().nodes.end(), nodeOf[order[o]].begin(), nodeOf[order[o]].end());
+  }
+
+  TaskArena arena;
+  arena.initialize(p.nThreads);
+  StitchResult result;
+  arena.execute([&] {
+    // Step 1: Neighbors across the cuts complete the counts
+    for (auto& cut : cuts) {
+      cut.grid.emplace(cut.coords.data(), cut.nodes.size(), p.eps);
+      cut.grid->initGrid();
+      parallelFor(0, cut.nodes.size(), [&](size_t begin, size_t end) {
+        std::vector<const GridCell*> cells;
+        for (size_t k = begin; k < end; ++k) {
+          auto& node = nodes[cut.nodes[k]];
+          cut.grid->getNeighborCells(cut.grid->getGridCoords(k), cells);
+          for (const GridCell* cell : cells) {
+            for (const size_t idx : *cell) {
+              node.cross += nodes[cut.nodes[idx]].chunk != node.chunk && distance.areNeighbors(&cut.coords[k * NDim], &cut.coords[idx * NDim]) ? 1 : 0;
+            }
+          }
+        }
+      });
+    }
+
+    // Step 2: Clusters of the core nodes: their local cluster, or the point
+    // itself when it only became core through the other side
+    auto isCore = [&](const Node& node) { return node.count + node.cross >= p.minPts; };
+    auto keyOf = [&](const Node& node) {
+      return globalClusterId(node.chunk, node.count >= p.minPts ? node.label : static_cast<int32_t>(node.id));
+    };
+    std::vector<int64_t> keys;
+    for (const auto& node : nodes) {
+      if (isCore(node)) {
+        keys.push_back(keyOf(node));
+      }
+    }
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    auto keyIndex = [&](const Node& node) {
+      return static_cast<size_t>(std::lower_bound(keys.begin(), keys.end(), keyOf(node)) - keys.begin());
+    };
+    auto parent = std::make_unique<std::atomic<size_t>[]>(keys.size());
+    for (size_t k = 0; k < keys.size(); ++k) {
+      parent[k].store(k, std::memory_order_relaxed);
+    }
+
+    // Step 3: Unite over core-core pairs across a cut, and within a chunk
+    // where a new core point is involved; attach noise that gained a core
+    // neighbor (smaller key index wins, so a cluster keeps its smallest id)
+    std::vector<size_t> attachTo(nodes.size(), nodes.size());
+    for (const auto& cut : cuts) {
+      parallelFor(0, cut.nodes.size(), [&](size_t begin, size_t end) {
+        std::vector<const GridCell*> cells;
+        for (size_t k = begin; k < end; ++k) {
+          const size_t a = cut.nodes[k];
+          const bool core = isCore(nodes[a]);
+          if (!core && nodes[a].label >= 0) {
+            continue; // border points keep their cluster
+          }
+          cut.grid->getNeighborCells(cut.grid->getGridCoords(k), cells);
+          for (const GridCell* cell : cells) {
+            for (const size_t idx : *cell) {
+              const size_t b = cut.nodes[idx];
+              if (b == a || !isCore(nodes[b]) || !distance.areNeighbors(&cut.coords[k * NDim], &cut.coords[idx * NDim])) {
+                continue;
+              }
+              if (!core) {
+                attachTo[a] = b;
+              } else if (nodes[a].chunk != nodes[b].chunk || nodes[a].count < p.minPts || nodes[b].count < p.minPts) {
+                unite(parent.get(), keyIndex(nodes[a]), keyIndex(nodes[b]));
+              }
+            }
+          }
+        }
+      });
+    }
+
+    // Step 4: Remap tables per chunk
+    auto globalOf = [&](const Node& node) { return keys[find(parent.get(), keyIndex(node))]; };
+    for (size_t a = 0; a < nodes.size(); ++a) {
+      const auto& node = nodes[a];
+      if (result.chunks.empty() || result.chunks.back().chunk != node.chunk) {
+        result.chunks.push_back({node.chunk, {}, {}});
+      }
+      auto& remap = result.chunks.back();
+      if (node.count >= p.minPts) {
+        const int64_t global = globalOf(node);
+        if (global != keyOf(node)) {
+          remap.clusters.emplace_back(node.label, global);
+        }
+      } else if (isCore(node)) {
+        remap.points.emplace_back(node.id, globalOf(node));
+      } else if (attachTo[a] < nodes.size()) {
+        remap.points.emplace_back(node.id, globalOf(nodes[attachTo[a]]));
+      }
+    }
+    for (auto& remap : result.chunks) {
+      std::sort(remap.clusters.begin(), remap.clusters.end());
+      remap.clusters.erase(std::unique(remap.clusters.begin(), remap.clusters.end()), remap.clusters.end());
+    }
+  });
+  return result;
+}
+
+#define DBSCAN_INSTANTIATE(T)                                                                                                                   \
+  template BoundaryDescriptor<T> DBSCAN::exportBoundary<T>(const T*, size_t, const DBSCANResult&, int32_t, const StitchCut&) const; \
+  template StitchResult stitch<T>(std::span<const BoundaryDescriptor<T>>, const DBSCANParams&);
+DBSCAN_FOR_EACH_COORD_TYPE(DBSCAN_INSTANTIATE)
+#undef DBSCAN_INSTANTIATE
+
+} // namespace dbscan
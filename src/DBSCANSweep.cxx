@@ -0,0 +1,566 @@
+#include "DBSCAN/DBSCAN.h"
+#include "DBSCAN/DBSCANCommon.h"
+#include "DBSCAN/DBSCANCoord.h"
+#include "DBSCAN/DBSCANDistance.h"
+#include "DBSCAN/DBSCANParallel.h"
+#include "DBSCAN/DBSCANUnionFind.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace dbscan
+{
+
+namespace
+{
+// Whether the points ascend along dimension d, i.e. a sortedDim hint holds;
+// call from within the task arena
+template <typename T>
+bool sortedAlong(const T* points, size_t n, size_t d)
+{
+  using Traits = CoordTraits<T>;
+  return parallelReduce(
+    1, n, true,
+    [&](size_t begin, size_t end, bool sorted) {
+      for (size_t i = begin; sorted && i < end; ++i) {
+        sorted = !(Traits::load(points[(i * NDim) + d]) < Traits::load(points[((i - 1) * NDim) + d]));
+      }
+      return sorted;
+    },
+    [](bool a, bool b) { return a && b; }, 4096);
+}
+
+// Grid over the active window of the sweep: cells are eps wide in every
+// dimension, the sweep axis included, so the window is three slabs of
+// cells (the one being processed and one on either side). Slabs enter in
+// sweep order and the oldest one leaves, so the grid only ever holds the
+// points of the window. Cells are hashed by their full coordinates into an
+// open-addressing table kept from slab to slab: a slab's cells are erased
+// when it leaves and inserted when it enters, the sweep axis keeping the
+// keys of different slabs apart. Float keys count cells from an origin (the
+// first swept point) in double, like the main grid counts from its lower
+// bounds: far from zero a key of the absolute coordinate would lose the
+// integer precision the neighbor search and the dense-cell shortcut rely on.
+template <typename T>
+class RollingGrid
+{
+  using Traits = CoordTraits<T>;
+  using Compute = typename Traits::Compute;
+
+ public:
+  using Key = std::array<int64_t, NDim>;
+  using Cell = std::span<const size_t>; // sweep positions
+
+  // origin: any point, nullptr for none; grids whose keys are compared
+  // must share it
+  RollingGrid(const std::array<float, NDim>& eps, const T* origin)
+  {
+#pragma unroll(NDim)
+    for (size_t d = 0; d < NDim; ++d) {
+      mCellSizes[d] = Traits::toCellSize(eps[d]);
+      mOrigin[d] = origin != nullptr ? static_cast<double>(Traits::load(origin[d])) : 0.0;
+    }
+    resize(16);
+  }
+
+  [[nodiscard]] int64_t getCoord(const T* point, size_t d) const
+  {
+    const Compute v = Traits::load(point[d]);
+    if constexpr (Traits::kIntegral) {
+      return static_cast<int64_t>((v / mCellSizes[d]) - (v % mCellSizes[d] < 0 ? 1 : 0)); // floor division
+    } else {
+      return static_cast<int64_t>(std::floor((static_cast<double>(v) - mOrigin[d]) / static_cast<double>(mCellSizes[d])));
+    }
+  }
+
+  [[nodiscard]] Key getKey(const T* point) const
+  {
+    Key key;
+#pragma unroll(NDim)
+    for (size_t d = 0; d < NDim; ++d) {
+      key[d] = getCoord(point, d);
+    }
+    return key;
+  }
+
+  // Enter the slab of sweep positions [begin, end) (empty for none), evicting
+  // the slab entered three calls ago; the previous slab becomes current
+  template <typename PointAt>
+  void pushSlab(size_t begin, size_t end, const PointAt& pointAt)
+  {
+    Slab& slab = mSlabs[mNewest = (mNewest + 1) % 3];
+    for (const auto& entry : slab.cells) {
+      erase(entry.first);
+    }
+    mNCells -= slab.cells.size();
+    slab.cells.clear();
+    slab.entries.clear();
+    for (size_t p = begin; p < end; ++p) {
+      slab.entries.emplace_back(getKey(pointAt(p)), p);
+    }
+    std::sort(slab.entries.begin(), slab.entries.end());
+    slab.positions.resize(slab.entries.size());
+    for (size_t k = 0; k < slab.entries.size(); ++k) {
+      slab.positions[k] = slab.entries[k].second;
+    }
+    for (size_t b = 0; b < slab.entries.size();) {
+      size_t e = b + 1;
+      while (e < slab.entries.size() && slab.entries[e].first == slab.entries[b].first) {
+        ++e;
+      }
+      slab.cells.emplace_back(slab.entries[b].first, Cell(slab.positions.data() + b, e - b));
+      b = e;
+    }
+
+    // At most half full: grow, re-inserting the two slabs already in
+    if (2 * (mNCells + slab.cells.size()) > mTable.size()) {
+      resize(std::bit_ceil(4 * (mNCells + slab.cells.size())));
+      for (const auto& other : mSlabs) {
+        if (&other != &slab) {
+          for (const auto& [key, cell] : other.cells) {
+            insert(key, cell);
+          }
+        }
+      }
+    }
+    for (const auto& [key, cell] : slab.cells) {
+      insert(key, cell);
+    }
+    mNCells += slab.cells.size();
+  }
+
+  [[nodiscard]] Cell getCell(const Key& key) const
+  {
+    for (size_t h = hash(key);; h = (h + 1) & (mTable.size() - 1)) {
+      if (mTable[h].cell.empty() || mTable[h].key == key) {
+        return mTable[h].cell;
+      }
+    }
+  }
+
+  // Cells of the current slab, in key order
+  [[nodiscard]] const std::vector<std::pair<Key, Cell>>& getCurrentCells() const
+  {
+    return mSlabs[(mNewest + 2) % 3].cells;
+  }
+
+  // visit(key, cell) for the non-empty cells among the 3^NDim around key
+  // (key itself included) until it returns false
+  template <typename Visit>
+  void forEachNear(const Key& key, const Visit& visit) const
+  {
+    size_t nOffsets = 1;
+    for (size_t d = 0; d < NDim; ++d) {
+      nOffsets *= 3;
+    }
+    for (size_t o = 0; o < nOffsets; ++o) {
+      Key nbr = key;
+      size_t code = o;
+#pragma unroll(NDim)
+      for (size_t d = 0; d < NDim; ++d) {
+        nbr[d] += static_cast<int64_t>(code % 3) - 1;
+        code /= 3;
+      }
+      const Cell cell = getCell(nbr);
+      if (!cell.empty() && !visit(nbr, cell)) {
+        return;
+      }
+    }
+  }
+
+ private:
+  [[nodiscard]] size_t hash(const Key& key) const
+  {
+    uint64_t h = 0;
+    for (const int64_t v : key) {
+      h = (h ^ static_cast<uint64_t>(v)) * 0x9E3779B97F4A7C15ULL;
+    }
+    return static_cast<size_t>(h >> mShift); // top bits, the best mixed ones
+  }
+
+  void resize(size_t size)
+  {
+    mTable.assign(size, Slot{});
+    mShift = 64 - std::countr_zero(mTable.size());
+  }
+
+  void insert(const Key& key, Cell cell)
+  {
+    size_t h = hash(key);
+    while (!mTable[h].cell.empty()) {
+      h = (h + 1) & (mTable.size() - 1);
+    }
+    mTable[h] = {key, cell};
+  }
+
+  // Backward-shift deletion: later entries of the probe run move up into
+  // the hole unless their home slot lies after it, so no tombstones build up
+  void erase(const Key& key)
+  {
+    const size_t mask = mTable.size() - 1;
+    size_t hole = hash(key);
+    while (mTable[hole].key != key) {
+      hole = (hole + 1) & mask;
+    }
+    for (size_t next = (hole + 1) & mask; !mTable[next].cell.empty(); next = (next + 1) & mask) {
+      const size_t home = hash(mTable[next].key);
+      if (((next - home) & mask) >= ((next - hole) & mask)) {
+        mTable[hole] = mTable[next];
+        hole = next;
+      }
+    }
+    mTable[hole] = Slot{};
+  }
+
+  struct Slot {
+    Key key;
+    Cell cell; // empty: free slot
+  };
+  struct Slab {
+    std::vector<std::pair<Key, size_t>> entries; // (cell, position), sorted
+    std::vector<size_t> positions;               // grouped by cell
+    std::vector<std::pair<Key, Cell>> cells;
+  };
+
+  std::array<Compute, NDim> mCellSizes;
+  std::array<double, NDim> mOrigin; // unused for integer keys
+  std::array<Slab, 3> mSlabs; // ring, buffers reused from slab to slab
+  size_t mNewest{0};
+  std::vector<Slot> mTable; // open addressing over the cells of all three slabs
+  size_t mNCells{0};
+  int32_t mShift{64};
+};
+} // namespace
+
+// 1-D engine: no grid. After sorting, the eps-neighborhood of every point is
+// a contiguous window of the sorted order, found with two pointers; core
+// points within eps of each other are adjacent in the sorted core sequence,
+// so clusters are runs of core points without a gap larger than eps.
+template <typename T>
+void DBSCAN::clusterSweep(const T* points, size_t n, DBSCANResult& result) const
+{
+  using Traits = CoordTraits<T>;
+  using Compute = typename Traits::Compute;
+  const Compute eps = Traits::toEps(mParams.eps[0]);
+  const auto minPts = static_cast<size_t>(std::max(0, mParams.minPts));
+  auto within = [eps](Compute a, Compute b) { return std::abs(a - b) <= eps; }; // same test as BasicDistance
+
+  mTaskArena.execute([&] {
+    // Step 1: Sort (key, index); ties by index keep the result deterministic.
+    // Input already sorted (sortedDim == 0, checked) is taken as is.
+    std::vector<std::pair<Compute, size_t>> sorted(n);
+    {
+      SCOPED_TIMER("\tsort");
+      parallelFor(0, n, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          sorted[i] = {Traits::load(points[i * NDim]), i};
+        }
+      });
+      if (mParams.sortedDim != 0 || !sortedAlong(points, n, 0)) {
+        parallelSort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) { return a < b; });
+      }
+    }
+
+    // Step 2: Neighborhood windows [lo, hi) and core flags. Each block finds
+    // its first window by binary search, then both pointers only move right.
+    std::vector<size_t> lo(n), hi(n);
+    std::vector<size_t> coreRank(n + 1); // core flag, then exclusive scan of it
+    {
+      SCOPED_TIMER("\twindows");
+      parallelFor(0, n, [&](size_t begin, size_t end) {
+        const Compute first = sorted[begin].first;
+        size_t l = static_cast<size_t>(std::partition_point(sorted.begin(), sorted.begin() + static_cast<std::ptrdiff_t>(begin),
+                                                            [&](const auto& e) { return !within(first, e.first); }) -
+                                       sorted.begin());
+        size_t h = begin;
+        for (size_t p = begin; p < end; ++p) {
+          const Compute v = sorted[p].first;
+          while (!within(v, sorted[l].first)) {
+            ++l;
+          }
+          h = std::max(h, p);
+          while (h < n && within(v, sorted[h].first)) {
+            ++h;
+          }
+          lo[p] = l;
+          hi[p] = h;
+          coreRank[p] = h - l - 1 >= minPts ? 1 : 0;
+        }
+      });
+    }
+
+    // Step 3: Core runs. Rank the core points; a run ends wherever the gap to
+    // the next core point exceeds eps, so the exclusive scan of those breaks
+    // is the run id of every core rank.
+    std::vector<size_t> corePos, run;
+    size_t nRuns = 0;
+    {
+      SCOPED_TIMER("\tcore runs");
+      const size_t nCore = parallelExclusiveScan(coreRank.data(), coreRank.data(), n);
+      coreRank[n] = nCore;
+      corePos.resize(nCore);
+      parallelFor(0, n, [&](size_t begin, size_t end) {
+        for (size_t p = begin; p < end; ++p) {
+          if (coreRank[p + 1] != coreRank[p]) {
+            corePos[coreRank[p]] = p;
+          }
+        }
+      });
+      run.resize(nCore);
+      parallelFor(0, nCore, [&](size_t begin, size_t end) {
+        for (size_t r = begin; r < end; ++r) {
+          run[r] = r + 1 < nCore && !within(sorted[corePos[r]].first, sorted[corePos[r + 1]].first) ? 1 : 0;
+        }
+      });
+      nRuns = nCore > 0 ? parallelExclusiveScan(run.data(), run.data(), nCore) + 1 : 0;
+    }
+
+    // Step 4: Cluster id = smallest core point index in the run, the same id
+    // the other engines produce; border points take the run of the first core
+    // point in their window
+    SCOPED_TIMER("\tlabels");
+    std::unique_ptr<std::atomic<size_t>[]> minCore(new std::atomic<size_t>[nRuns]);
+    parallelFor(0, nRuns, [&](size_t begin, size_t end) {
+      for (size_t s = begin; s < end; ++s) {
+        minCore[s].store(std::numeric_limits<size_t>::max(), std::memory_order_relaxed);
+      }
+    });
+    parallelFor(0, corePos.size(), [&](size_t begin, size_t end) {
+      for (size_t r = begin; r < end; ++r) {
+        auto& slot = minCore[run[r]];
+        const size_t idx = sorted[corePos[r]].second;
+        size_t current = slot.load(std::memory_order_relaxed);
+        while (idx < current && !slot.compare_exchange_weak(current, idx, std::memory_order_relaxed)) {
+        }
+      }
+    });
+    auto& labels = result.labels;
+    parallelFor(0, n, [&](size_t begin, size_t end) {
+      for (size_t p = begin; p < end; ++p) {
+        const size_t idx = sorted[p].second;
+        if (coreRank[hi[p]] == coreRank[lo[p]]) {
+          labels[idx] = DB_NOISE; // no core point in the window, not even itself
+          continue;
+        }
+        const size_t r = coreRank[p + 1] != coreRank[p] ? coreRank[p] : coreRank[lo[p]];
+        labels[idx] = static_cast<int32_t>(minCore[run[r]].load(std::memory_order_relaxed));
+      }
+    });
+  });
+}
+
+// Sweep engine for input sorted along one dimension (time-ordered streams).
+// The eps-neighborhood of a point lies within one slab (eps along the axis)
+// either side of its own, so a grid over the three slabs around the sweep
+// answers every query: no global grid, bounds pass or sort. Without a
+// sortedDim hint, or if the input turns out not to be sorted along it, the
+// input is sorted along that axis first (a permutation, the points stay in
+// place).
+//
+// Chunks of whole slabs sweep independently, each entering the slab before
+// its first one as halo. As in the CellGraph engine, points sharing a cell
+// are within eps of each other: a cell holding more than minPts points is
+// core throughout, its core points form one component, and two neighboring
+// cells are linked by the first core pair within eps.
+template <typename T>
+void DBSCAN::linkSweep(const T* points, size_t n, DBSCANWorkspace& workspace) const
+{
+  using Traits = CoordTraits<T>;
+  using Compute = typename Traits::Compute;
+  using Key = typename RollingGrid<T>::Key;
+  bool hinted = mParams.sortedDim >= 0 && mParams.sortedDim < NDim;
+  const size_t axis = hinted ? static_cast<size_t>(mParams.sortedDim) : 0;
+  const BasicDistance<T> distance(mParams.eps);
+  const auto minPts = static_cast<size_t>(std::max(0, mParams.minPts));
+  auto* parent = workspace.parent.get();
+  auto& isCore = workspace.isCore;
+
+  mTaskArena.execute([&] {
+    std::vector<size_t> order; // position -> point index, empty when the input is sorted
+    if (hinted) {
+      // A wrong hint would lose neighbors silently; sort instead
+      SCOPED_TIMER("\tcheck order");
+      hinted = sortedAlong(points, n, axis);
+    }
+    if (!hinted) {
+      SCOPED_TIMER("\tsort");
+      order.resize(n);
+      parallelFor(0, n, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          order[i] = i;
+        }
+      });
+      parallelSort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        const Compute ka = Traits::load(points[(a * NDim) + axis]), kb = Traits::load(points[(b * NDim) + axis]);
+        return ka < kb || (!(kb < ka) && a < b);
+      });
+    }
+    auto indexAt = [&](size_t pos) { return order.empty() ? pos : order[pos]; };
+    auto pointAt = [&](size_t pos) { return &points[indexAt(pos) * NDim]; };
+    const T* origin = n > 0 ? pointAt(0) : nullptr;
+    const RollingGrid<T> slabs(mParams.eps, origin);
+    auto slabAt = [&](size_t pos) { return slabs.getCoord(pointAt(pos), axis); };
+    auto slabEnd = [&](size_t pos) {
+      const int64_t slab = slabAt(pos);
+      while (++pos < n && slabAt(pos) == slab) {
+      }
+      return pos;
+    };
+    auto slabBegin = [&](size_t pos) {
+      while (pos > 0 && pos < n && slabAt(pos - 1) == slabAt(pos)) {
+        ++pos;
+      }
+      return pos;
+    };
+
+    // visit(begin, end, grid) for the slabs starting in [begin, end), the
+    // grid holding the slab and its neighbors on either side
+    auto sweep = [&](size_t begin, size_t end, const auto& visit) {
+      begin = slabBegin(begin);
+      end = slabBegin(end);
+      if (begin >= end) {
+        return;
+      }
+      RollingGrid<T> grid(mParams.eps, origin);
+      size_t halo = begin; // first position of the slab before
+      if (begin > 0) {
+        const int64_t slab = slabAt(begin - 1);
+        size_t lo = 0, hi = begin;
+        while (lo < hi) {
+          const size_t mid = lo + ((hi - lo) / 2);
+          if (slabAt(mid) < slab) {
+            lo = mid + 1;
+          } else {
+            hi = mid;
+          }
+        }
+        halo = lo;
+      }
+      grid.pushSlab(halo, begin, pointAt);
+      size_t cur = begin, curEnd = slabEnd(begin);
+      grid.pushSlab(cur, curEnd, pointAt);
+      while (cur < end) {
+        const size_t next = curEnd, nextEnd = next < n ? slabEnd(next) : n;
+        grid.pushSlab(next, nextEnd, pointAt);
+        visit(cur, curEnd, grid);
+        cur = next;
+        curEnd = nextEnd;
+      }
+    };
+    const size_t chunk = std::max<size_t>(16384, n / (detail::hardwareThreads() * 4));
+    const size_t nChunks = (n + chunk - 1) / chunk;
+    auto forEachChunk = [&](const auto& visit) {
+      parallelFor(0, nChunks, [&](size_t cb, size_t ce) {
+        for (size_t c = cb; c < ce; ++c) {
+          sweep(c * chunk, std::min(n, (c + 1) * chunk), visit);
+        }
+      });
+    };
+
+    // Sweep 1: core flags, counting stops at minPts
+    {
+      SCOPED_TIMER("\tcore points");
+      forEachChunk([&](size_t begin, size_t end, const RollingGrid<T>& grid) {
+        for (size_t p = begin; p < end; ++p) {
+          const size_t i = indexAt(p);
+          const T* query = pointAt(p);
+          const Key key = grid.getKey(query);
+          size_t count = 0;
+          if (grid.getCell(key).size() > minPts) {
+            count = minPts;
+          } else {
+            grid.forEachNear(key, [&](const Key&, typename RollingGrid<T>::Cell cell) {
+              for (const size_t q : cell) {
+                if (q != p && distance.areNeighbors(query, pointAt(q))) {
+                  ++count;
+                }
+              }
+              return count < minPts;
+            });
+          }
+          parent[i].store(i, std::memory_order_relaxed);
+          isCore[i] = count >= minPts;
+        }
+      });
+    }
+
+    // Sweep 2: link every cell of the slab. A pair of neighboring cells is
+    // handled from the one with the smaller key, so each pair once.
+    {
+      SCOPED_TIMER("\tunion");
+      forEachChunk([&](size_t, size_t, const RollingGrid<T>& grid) {
+        std::vector<size_t> own, other;
+        auto gatherCore = [&](typename RollingGrid<T>::Cell cell, std::vector<size_t>& out) {
+          out.clear();
+          for (const size_t q : cell) {
+            if (isCore[indexAt(q)]) {
+              out.push_back(q);
+            }
+          }
+        };
+        for (const auto& [key, cell] : grid.getCurrentCells()) {
+          gatherCore(cell, own);
+          if (own.empty()) {
+            // No core point here: border points attach to the first core neighbor
+            for (const size_t p : cell) {
+              const T* query = pointAt(p);
+              grid.forEachNear(key, [&](const Key&, typename RollingGrid<T>::Cell near) {
+                for (const size_t q : near) {
+                  if (isCore[indexAt(q)] && distance.areNeighbors(query, pointAt(q))) {
+                    parent[indexAt(p)].store(indexAt(q), std::memory_order_relaxed);
+                    return false;
+                  }
+                }
+                return true;
+              });
+            }
+            continue;
+          }
+          const size_t root = indexAt(own.front());
+          for (size_t k = 1; k < own.size(); ++k) {
+            unite(parent, root, indexAt(own[k]));
+          }
+          for (const size_t p : cell) {
+            if (!isCore[indexAt(p)]) {
+              parent[indexAt(p)].store(root, std::memory_order_relaxed);
+            }
+          }
+          grid.forEachNear(key, [&](const Key& nbr, typename RollingGrid<T>::Cell near) {
+            if (!(key < nbr)) {
+              return true;
+            }
+            gatherCore(near, other);
+            if (other.empty() || find(parent, root) == find(parent, indexAt(other.front()))) {
+              return true;
+            }
+            for (const size_t a : own) {
+              const T* query = pointAt(a);
+              for (const size_t b : other) {
+                if (distance.areNeighbors(query, pointAt(b))) {
+                  unite(parent, root, indexAt(b));
+                  return true;
+                }
+              }
+            }
+            return true;
+          });
+        }
+      });
+    }
+  });
+}
+
+#define DBSCAN_INSTANTIATE(T)                                                                \
+  template void DBSCAN::clusterSweep<T>(const T*, size_t, DBSCANResult&) const; \
+  template void DBSCAN::linkSweep<T>(const T*, size_t, DBSCANWorkspace&) const;
+DBSCAN_FOR_EACH_COORD_TYPE(DBSCAN_INSTANTIATE)
+#undef DBSCAN_INSTANTIATE
+
+} // namespace dbscan
@@ -0,0 +1,223 @@
+#include "DBSCAN/DBSCANTracker.h"
+#include "DBSCAN/DBSCANCoord.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <utility>
+
+namespace dbscan
+{
+
+DBSCANTracker::DBSCANTracker(const DBSCANTrackerParams& p) : mParams(p)
+{
+  mTaskArena.initialize(mParams.nThreads);
+}
+
+void DBSCANTracker::reset()
+{
+  mPrevious.clear();
+  mPreviousIds.clear();
+}
+
+template <typename T>
+TrackedFrame DBSCANTracker::update(const T* points, size_t n, const DBSCANResult& result)
+{
+  using Traits = CoordTraits<T>;
+  using Compute = typename Traits::Compute;
+  const auto& labels = result.labels;
+  const auto nLabels = static_cast<size_t>(std::max(0, result.nClusters));
+
+  std::array<Compute, NDim> cellSizes;
+  std::array<bool, NDim> used;
+#pragma unroll(NDim)
+  for (size_t d = 0; d < NDim; ++d) {
+    used[d] = mParams.cellSizes[d] > 0;
+    cellSizes[d] = used[d] ? Traits::toCellSize(mParams.cellSizes[d]) : Compute{1};
+  }
+  auto cellOf = [&](size_t i) {
+    CellKey key{};
+#pragma unroll(NDim)
+    for (size_t d = 0; d < NDim; ++d) {
+      if (!used[d]) {
+        continue;
+      }
+      const Compute v = Traits::load(points[(i * NDim) + d]);
+      if constexpr (Traits::kIntegral) {
+        key[d] = static_cast<int64_t>((v / cellSizes[d]) - (v % cellSizes[d] < 0 ? 1 : 0)); // floor division
+      } else {
+        key[d] = static_cast<int64_t>(std::floor(v / cellSizes[d]));
+      }
+    }
+    return key;
+  };
+
+  TrackedFrame frame;
+  frame.ids.resize(n);
+  mTaskArena.execute([&] {
+    // Step 1: Dense cluster indices; labels are root point indices, sparse in [0, nClusters)
+    std::vector<int32_t> present(nLabels, 0), dense(nLabels);
+    std::vector<size_t> slot(n);
+    size_t nOccupied = 0;
+    {
+      SCOPED_TIMER("\tdense clusters");
+      parallelFor(0, n, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          if (labels[i] >= 0) {
+            std::atomic_ref<int32_t>(present[static_cast<size_t>(labels[i])]).store(1, std::memory_order_relaxed);
+          }
+          slot[i] = labels[i] >= 0 ? 1 : 0;
+        }
+      });
+      frame.nClusters = parallelExclusiveScan(present.data(), dense.data(), nLabels);
+      nOccupied = parallelExclusiveScan(slot.data(), slot.data(), n);
+    }
+
+    // Step 2: Occupied (cell, cluster) pairs, sorted and unique
+    std::vector<Occupancy> current(nOccupied);
+    {
+      SCOPED_TIMER("\toccupied cells");
+      parallelFor(0, n, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          if (labels[i] >= 0) {
+            current[slot[i]] = {cellOf(i), dense[static_cast<size_t>(labels[i])]};
+          }
+        }
+      });
+      parallelSort(current.begin(), current.end(), [](const Occupancy& a, const Occupancy& b) { return a < b; });
+      current.erase(std::unique(current.begin(), current.end()), current.end());
+    }
+
+    // Step 3: Contingency table against the previous frame, then matching
+    std::vector<int32_t> ids;
+    {
+      SCOPED_TIMER("\tmatching");
+      const auto links = countLinks(current);
+      match(static_cast<size_t>(frame.nClusters), links, ids, frame.events);
+    }
+
+    parallelFor(0, n, [&](size_t begin, size_t end) {
+      for (size_t i = begin; i < end; ++i) {
+        // negative labels (noise, points not clustered) pass through
+        frame.ids[i] = labels[i] < 0 ? labels[i] : ids[static_cast<size_t>(dense[static_cast<size_t>(labels[i])])];
+      }
+    });
+    mPrevious = std::move(current);
+    mPreviousIds = std::move(ids);
+  });
+  return frame;
+}
+
+std::vector<DBSCANTracker::Link> DBSCANTracker::countLinks(const std::vector<Occupancy>& current)
+{
+  // Merge-join both sorted occupancy lists on the cell, in chunks aligned to
+  // cell boundaries; every (previous, current) pair sharing a cell is one
+  // entry, packed into 64 bits so sorting them counts the shared cells
+  const size_t size = current.size();
+  const size_t nChunks = std::max<size_t>(1, std::min(detail::hardwareThreads() * 4, size / 4096));
+  std::vector<std::vector<uint64_t>> chunkPairs(nChunks);
+  auto cellStart = [&](size_t k) {
+    while (k > 0 && k < size && current[k].cell == current[k - 1].cell) {
+      ++k;
+    }
+    return k;
+  };
+  parallelFor(0, nChunks, [&](size_t cb, size_t ce) {
+    for (size_t c = cb; c < ce; ++c) {
+      const size_t end = cellStart((c + 1) * size / nChunks);
+      size_t k = cellStart(c * size / nChunks);
+      if (k >= end) {
+        continue;
+      }
+      auto prev = std::lower_bound(mPrevious.begin(), mPrevious.end(), Occupancy{current[k].cell, -1});
+      auto& pairs = chunkPairs[c];
+      while (k < end && prev != mPrevious.end()) {
+        if (prev->cell < current[k].cell) {
+          ++prev;
+          continue;
+        }
+        size_t e = k + 1;
+        while (e < end && current[e].cell == current[k].cell) {
+          ++e;
+        }
+        for (auto p = prev; p != mPrevious.end() && p->cell == current[k].cell; ++p) {
+          for (size_t q = k; q < e; ++q) {
+            pairs.push_back((static_cast<uint64_t>(p->cluster) << 32) | static_cast<uint32_t>(current[q].cluster));
+          }
+        }
+        k = e;
+      }
+    }
+  }, 1);
+
+  std::vector<uint64_t> pairs;
+  for (const auto& chunk : chunkPairs) {
+    pairs.insert(pairs.end(), chunk.begin(), chunk.end());
+  }
+  parallelSort(pairs.begin(), pairs.end(), [](uint64_t a, uint64_t b) { return a < b; });
+  std::vector<Link> links;
+  for (size_t b = 0; b < pairs.size();) {
+    size_t e = b + 1;
+    while (e < pairs.size() && pairs[e] == pairs[b]) {
+      ++e;
+    }
+    if (e - b >= static_cast<size_t>(std::max(1, mParams.minOverlap))) {
+      links.push_back({static_cast<int32_t>(pairs[b] >> 32), static_cast<int32_t>(pairs[b] & 0xFFFFFFFFU), static_cast<int32_t>(e - b)});
+    }
+    b = e;
+  }
+  return links; // sorted by (previous, current)
+}
+
+void DBSCANTracker::match(size_t nCurrent, const std::vector<Link>& links, std::vector<int32_t>& ids, std::vector<TrackEvent>& events)
+{
+  const size_t nPrevious = mPreviousIds.size();
+  // Heir of every previous cluster: the current one sharing the most cells
+  // (ties: the lower index, links come sorted)
+  std::vector<int32_t> heir(nPrevious, -1), heirShared(nPrevious, 0);
+  for (const auto& link : links) {
+    const auto p = static_cast<size_t>(link.previous);
+    if (link.shared > heirShared[p]) {
+      heir[p] = link.current;
+      heirShared[p] = link.shared;
+    }
+  }
+  // Per current cluster: strongest predecessor that chose it, strongest overall
+  std::vector<int32_t> from(nCurrent, -1), fromShared(nCurrent, 0), best(nCurrent, -1), bestShared(nCurrent, 0);
+  for (const auto& link : links) {
+    const auto c = static_cast<size_t>(link.current);
+    if (heir[static_cast<size_t>(link.previous)] == link.current && link.shared > fromShared[c]) {
+      from[c] = link.previous;
+      fromShared[c] = link.shared;
+    }
+    if (link.shared > bestShared[c]) {
+      best[c] = link.previous;
+      bestShared[c] = link.shared;
+    }
+  }
+
+  ids.resize(nCurrent);
+  for (size_t c = 0; c < nCurrent; ++c) {
+    if (from[c] >= 0) {
+      ids[c] = mPreviousIds[static_cast<size_t>(from[c])];
+    } else if (best[c] >= 0) {
+      ids[c] = mNextId++;
+      events.push_back({TrackEventType::Split, ids[c], mPreviousIds[static_cast<size_t>(best[c])]});
+    } else {
+      ids[c] = mNextId++;
+      events.push_back({TrackEventType::Birth, ids[c]});
+    }
+  }
+  for (size_t p = 0; p < nPrevious; ++p) {
+    if (heir[p] < 0) {
+      events.push_back({TrackEventType::Death, mPreviousIds[p]});
+    } else if (from[static_cast<size_t>(heir[p])] != static_cast<int32_t>(p)) {
+      events.push_back({TrackEventType::Merge, ids[static_cast<size_t>(heir[p])], mPreviousIds[p]});
+    }
+  }
+}
+
+#define DBSCAN_INSTANTIATE(T) template TrackedFrame DBSCANTracker::update<T>(const T*, size_t, const DBSCANResult&);
+DBSCAN_FOR_EACH_COORD_TYPE(DBSCAN_INSTANTIATE)
+#undef DBSCAN_INSTANTIATE
+
+} // namespace dbscan
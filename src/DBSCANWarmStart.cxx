@@ -0,0 +1,712 @@
+#include "DBSCAN/DBSCANWarmStart.h"
+#include "DBSCAN/DBSCANCoord.h"
+#include "DBSCAN/DBSCANUnionFind.h"
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+namespace dbscan
+{
+
+namespace
+{
+// mMark bits
+constexpr uint8_t kMoved = 1;      // point moved in this update
+constexpr uint8_t kDirty = 2;      // (by root) cluster is re-linked from scratch
+constexpr uint8_t kRelabel = 4;    // non-core point whose label is recomputed
+constexpr uint8_t kLost = 8;       // point lost its core status in this update
+constexpr uint8_t kReroot = 16;    // (by root) cluster lost only its root
+constexpr uint8_t kGained = 32;    // point became core in this update
+
+// Core points a connectivity check expands first, doubled while needed
+constexpr size_t kSearchBudget = 1024;
+
+// Concatenate per-chunk lists, sort and drop duplicates
+std::vector<size_t> gather(std::vector<std::vector<size_t>>& chunks)
+{
+  std::vector<size_t> out;
+  for (auto& chunk : chunks) {
+    out.insert(out.end(), chunk.begin(), chunk.end());
+    chunk.clear();
+  }
+  std::sort(out.begin(), out.end());
+  out.erase(std::unique(out.begin(), out.end()), out.end());
+  return out;
+}
+
+// Apply body(k, out) to every k of [0, n), each chunk collecting into its own list
+template <typename Body>
+std::vector<size_t> parallelCollect(size_t n, const Body& body)
+{
+  const size_t nChunks = std::max<size_t>(1, std::min(detail::hardwareThreads() * 4, n));
+  std::vector<std::vector<size_t>> chunks(nChunks);
+  parallelFor(0, nChunks, [&](size_t cb, size_t ce) {
+    for (size_t c = cb; c < ce; ++c) {
+      for (size_t k = c * n / nChunks; k < (c + 1) * n / nChunks; ++k) {
+        body(k, chunks[c]);
+      }
+    } }, 1);
+  return gather(chunks);
+}
+
+void setMark(std::vector<uint8_t>& marks, size_t i, uint8_t bit)
+{
+  std::atomic_ref<uint8_t>(marks[i]).fetch_or(bit, std::memory_order_relaxed);
+}
+} // namespace
+
+template <typename T>
+DBSCANWarmStart<T>::DBSCANWarmStart(const DBSCANParams& p) : mParams(p), mDistance(p.eps)
+{
+  mTaskArena.initialize(mParams.nThreads);
+}
+
+template <typename T>
+template <typename Visit>
+void DBSCANWarmStart<T>::forEachNeighbor(size_t i, std::vector<const GridCell*>& cells, const Visit& visit) const
+{
+  const T* query = &mPositions[i * NDim];
+  mGrid->getNeighborCells(mGrid->getGridCoords(i), cells);
+  for (const GridCell* cell : cells) {
+    for (const size_t idx : *cell) {
+      if (idx != i && mDistance.areNeighbors(query, &mPositions[idx * NDim]) && !visit(idx)) {
+        return;
+      }
+    }
+  }
+}
+
+template <typename T>
+const DBSCANResult& DBSCANWarmStart<T>::cluster(const T* points, size_t n)
+{
+  mNPoints = n;
+  mPositions.assign(points, points + (n * NDim));
+  mCellOf.resize(n);
+  mCounts.assign(n, 0);
+  mIsCore.assign(n, 0);
+  mMark.assign(n, 0);
+  mParent = std::make_unique<std::atomic<size_t>[]>(n);
+  mResult.labels.assign(n, DB_NOISE);
+  auto* parent = mParent.get();
+  auto& labels = mResult.labels;
+
+  mTaskArena.execute([&] {
+    {
+      SCOPED_TIMER("\tinit grid");
+      mGrid.emplace(mPositions.data(), n, mParams.eps);
+      mGrid->initGrid();
+    }
+    // Step 1: Neighbor counts (complete, later updates adjust them)
+    {
+      SCOPED_TIMER("\tneighbor counts");
+      parallelFor(0, n, [&](size_t begin, size_t end) {
+        std::vector<const GridCell*> cells;
+        for (size_t i = begin; i < end; ++i) {
+          int32_t count = 0;
+          forEachNeighbor(i, cells, [&](size_t) {
+            ++count;
+            return true;
+          });
+          mCellOf[i] = mGrid->getCellIndex(mGrid->getGridCoords(i));
+          mCounts[i] = count;
+          mIsCore[i] = count >= mParams.minPts;
+          parent[i].store(i, std::memory_order_relaxed);
+        }
+      });
+    }
+    // Step 2: Union of core-core pairs
+    {
+      SCOPED_TIMER("\tunion");
+      parallelFor(0, n, [&](size_t begin, size_t end) {
+        std::vector<const GridCell*> cells;
+        for (size_t i = begin; i < end; ++i) {
+          if (mIsCore[i]) {
+            forEachNeighbor(i, cells, [&](size_t j) {
+              if (j > i && mIsCore[j]) {
+                unite(parent, i, j);
+              }
+              return true;
+            });
+          }
+        }
+      });
+    }
+    // Step 3: Labels; core points keep pointing at their root, which later
+    // updates rely on. Border points take the first core neighbor's root.
+    {
+      SCOPED_TIMER("\tlabels");
+      parallelFor(0, n, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          if (mIsCore[i]) {
+            const size_t root = find(parent, i);
+            parent[i].store(root, std::memory_order_relaxed);
+            labels[i] = static_cast<int32_t>(root);
+          }
+        }
+      });
+      parallelFor(0, n, [&](size_t begin, size_t end) {
+        std::vector<const GridCell*> cells;
+        for (size_t i = begin; i < end; ++i) {
+          if (!mIsCore[i]) {
+            forEachNeighbor(i, cells, [&](size_t j) {
+              if (mIsCore[j]) {
+                labels[i] = static_cast<int32_t>(parent[j].load(std::memory_order_relaxed));
+                return false;
+              }
+              return true;
+            });
+          }
+        }
+      });
+    }
+  });
+  countClusters();
+  return mResult;
+}
+
+template <typename T>
+const DBSCANResult& DBSCANWarmStart<T>::update(const T* points)
+{
+  std::vector<size_t> moved;
+  mTaskArena.execute([&] {
+    SCOPED_TIMER("\tfind moved");
+    moved = parallelCollect(mNPoints, [&](size_t i, std::vector<size_t>& out) {
+      if (std::memcmp(&points[i * NDim], &mPositions[i * NDim], NDim * sizeof(T)) != 0) {
+        out.push_back(i);
+      }
+    });
+  });
+  return update(points, moved);
+}
+
+template <typename T>
+const DBSCANResult& DBSCANWarmStart<T>::update(const T* points, std::span<const size_t> moved)
+{
+  const size_t n = mNPoints;
+  const size_t nMoved = moved.size();
+  if (nMoved == 0) {
+    return mResult;
+  }
+  if (nMoved * 4 > n) {
+    return cluster(points, n);
+  }
+  auto* parent = mParent.get();
+  auto& labels = mResult.labels;
+  auto& counts = mCounts;
+  auto& isCore = mIsCore;
+
+  mTaskArena.execute([&] {
+    // Step 1: Neighborhoods of the moved points before the move, on the old
+    // grid and positions
+    std::vector<std::vector<size_t>> before(nMoved), after(nMoved);
+    {
+      SCOPED_TIMER("\told neighborhoods");
+      parallelFor(0, nMoved, [&](size_t begin, size_t end) {
+        std::vector<const GridCell*> cells;
+        for (size_t k = begin; k < end; ++k) {
+          forEachNeighbor(moved[k], cells, [&](size_t j) {
+            before[k].push_back(j);
+            return true;
+          });
+          std::sort(before[k].begin(), before[k].end());
+          mMark[moved[k]] = kMoved;
+        }
+      });
+    }
+
+    // Step 2: Move, re-bin the points that crossed into another cell
+    {
+      SCOPED_TIMER("\tre-bin");
+      std::vector<size_t> cellOf(nMoved);
+      parallelFor(0, nMoved, [&](size_t begin, size_t end) {
+        for (size_t k = begin; k < end; ++k) {
+          std::copy_n(&points[moved[k] * NDim], NDim, &mPositions[moved[k] * NDim]);
+          cellOf[k] = mGrid->getCellIndex(mGrid->getGridCoords(moved[k]));
+        }
+      });
+      for (size_t k = 0; k < nMoved; ++k) {
+        if (cellOf[k] != mCellOf[moved[k]]) {
+          mGrid->moveCell(moved[k], mCellOf[moved[k]], cellOf[k]);
+          mCellOf[moved[k]] = cellOf[k];
+        }
+      }
+    }
+
+    // Step 3: New neighborhoods; a pair with one moved end is only seen from
+    // that end, so the counts of the points that stayed are adjusted here
+    std::vector<std::vector<size_t>> removed(nMoved), added(nMoved);
+    std::vector<size_t> candidates; // points whose count may have changed
+    {
+      SCOPED_TIMER("\tnew neighborhoods");
+      candidates = parallelCollect(nMoved, [&](size_t k, std::vector<size_t>& touched) {
+        std::vector<const GridCell*> cells;
+        const size_t i = moved[k];
+        forEachNeighbor(i, cells, [&](size_t j) {
+          after[k].push_back(j);
+          return true;
+        });
+        std::sort(after[k].begin(), after[k].end());
+        std::set_difference(before[k].begin(), before[k].end(), after[k].begin(), after[k].end(), std::back_inserter(removed[k]));
+        std::set_difference(after[k].begin(), after[k].end(), before[k].begin(), before[k].end(), std::back_inserter(added[k]));
+        counts[i] = static_cast<int32_t>(after[k].size());
+        touched.push_back(i);
+        for (const size_t j : removed[k]) {
+          if (!(mMark[j] & kMoved)) {
+            std::atomic_ref<int32_t>(counts[j]).fetch_sub(1, std::memory_order_relaxed);
+            touched.push_back(j);
+          }
+        }
+        for (const size_t j : added[k]) {
+          if (!(mMark[j] & kMoved)) {
+            std::atomic_ref<int32_t>(counts[j]).fetch_add(1, std::memory_order_relaxed);
+            touched.push_back(j);
+          }
+        }
+      });
+    }
+
+    // Step 4: Core flag changes
+    std::vector<uint8_t> wasCore(candidates.size());
+    std::vector<size_t> gained, lost;
+    for (size_t c = 0; c < candidates.size(); ++c) {
+      const size_t i = candidates[c];
+      wasCore[c] = isCore[i];
+      isCore[i] = counts[i] >= mParams.minPts;
+      if (isCore[i] && !wasCore[c]) {
+        gained.push_back(i);
+      } else if (!isCore[i] && wasCore[c]) {
+        lost.push_back(i);
+      }
+    }
+    auto coreBefore = [&](size_t i) {
+      const auto it = std::lower_bound(candidates.begin(), candidates.end(), i);
+      return it != candidates.end() && *it == i ? wasCore[static_cast<size_t>(it - candidates.begin())] != 0 : isCore[i] != 0;
+    };
+
+    // Bounded searches over the current core graph from the sorted targets,
+    // core points of one former cluster. They need not stay connected: a
+    // component closed off within the budget is a cluster of its own (a
+    // piece), one component may stay open. Two open components are retried
+    // with doubled budgets until one closes off (the cost follows the
+    // smaller one) or the search grows too large.
+    enum class Split { Connected, Pieces, TwoOpen };
+    auto searchPieces = [&](const std::vector<size_t>& targets, size_t budget, std::vector<std::vector<size_t>>& closed, size_t& openFrom, std::vector<const GridCell*>& cells) {
+      std::unordered_map<size_t, size_t> owner; // visited point -> search
+      size_t reached = 0;
+      for (size_t s = 0; s < targets.size(); ++s) {
+        if (!owner.emplace(targets[s], s).second) {
+          continue;
+        }
+        const bool first = s == 0;
+        std::vector<size_t> queue{targets[s]};
+        bool joined = false; // ran into an earlier search, which was cut off
+        reached += 1;
+        size_t q = 0;
+        for (; q < queue.size() && q < budget && !joined && !(first && reached == targets.size()); ++q) {
+          forEachNeighbor(queue[q], cells, [&](size_t j) {
+            if (!isCore[j]) {
+              return true;
+            }
+            const auto [it, fresh] = owner.emplace(j, s);
+            if (fresh) {
+              queue.push_back(j);
+              reached += std::binary_search(targets.begin(), targets.end(), j) ? 1U : 0U;
+            } else if (it->second != s) {
+              joined = true;
+            }
+            return !joined && !(first && reached == targets.size());
+          });
+        }
+        if (first && reached == targets.size()) {
+          return Split::Connected;
+        }
+        if (joined) {
+          continue;
+        }
+        if (q == queue.size()) {
+          closed.push_back(std::move(queue));
+        } else if (openFrom == n) {
+          openFrom = targets[s];
+        } else {
+          return Split::TwoOpen;
+        }
+      }
+      return Split::Pieces;
+    };
+    std::vector<std::vector<size_t>> pieces;
+    std::vector<std::pair<size_t, size_t>> opens; // (former root, point of the open component)
+    std::mutex piecesMutex;
+    auto splitLocally = [&](const std::vector<size_t>& targets, std::vector<const GridCell*>& cells) {
+      for (size_t budget = kSearchBudget;; budget *= 2) {
+        std::vector<std::vector<size_t>> closed;
+        size_t openFrom = n;
+        const auto split = searchPieces(targets, budget, closed, openFrom, cells);
+        if (split == Split::Connected) {
+          return true;
+        }
+        if (split == Split::Pieces) {
+          std::lock_guard lock(piecesMutex);
+          pieces.insert(pieces.end(), std::make_move_iterator(closed.begin()), std::make_move_iterator(closed.end()));
+          if (openFrom < n) {
+            opens.emplace_back(static_cast<size_t>(labels[targets.front()]), openFrom);
+          }
+          return true;
+        }
+        if (budget * 4 > n) {
+          return false;
+        }
+      }
+    };
+
+    // Step 5: Clusters to re-link. A cluster survives a removed core-core
+    // edge if both ends stay core and are still connected nearby (usually
+    // through a shared core neighbor), and a lost core point if its former
+    // core neighbors stay core and connected nearby, up to pieces split off.
+    // Otherwise it is re-linked.
+    std::vector<size_t> dirty;
+    {
+      SCOPED_TIMER("\trepair");
+      dirty = parallelCollect(nMoved, [&](size_t k, std::vector<size_t>& out) {
+        std::vector<const GridCell*> cells;
+        const size_t i = moved[k];
+        for (const size_t j : removed[k]) {
+          if (!coreBefore(i) || !coreBefore(j) || !isCore[i] || !isCore[j]) {
+            continue; // not a core-core edge before, or covered by the lost core point
+          }
+          const T* other = &mPositions[j * NDim];
+          const bool witnessed = std::any_of(after[k].begin(), after[k].end(), [&](size_t m) {
+            return m != j && isCore[m] && mDistance.areNeighbors(&mPositions[m * NDim], other);
+          });
+          if (!witnessed && !splitLocally({std::min(i, j), std::max(i, j)}, cells)) {
+            out.push_back(static_cast<size_t>(labels[i]));
+          }
+        }
+      });
+      // Edges of the lost points that stayed, changed by a moved neighbor
+      std::vector<std::pair<size_t, size_t>> edgeGone, edgeNew;
+      for (const size_t l : lost) {
+        mMark[l] |= kLost;
+      }
+      for (size_t k = 0; k < nMoved; ++k) {
+        for (const size_t j : removed[k]) {
+          if ((mMark[j] & (kLost | kMoved)) == kLost) {
+            edgeGone.emplace_back(j, moved[k]);
+          }
+        }
+        for (const size_t j : added[k]) {
+          if ((mMark[j] & (kLost | kMoved)) == kLost) {
+            edgeNew.emplace_back(j, moved[k]);
+          }
+        }
+      }
+      std::sort(edgeGone.begin(), edgeGone.end());
+      std::sort(edgeNew.begin(), edgeNew.end());
+      // Former core neighbors of every lost point
+      std::vector<std::vector<size_t>> formerCores(lost.size());
+      parallelFor(0, lost.size(), [&](size_t begin, size_t end) {
+        std::vector<const GridCell*> cells;
+        for (size_t c = begin; c < end; ++c) {
+          const size_t l = lost[c];
+          std::vector<size_t> current, former;
+          forEachNeighbor(l, cells, [&](size_t j) {
+            current.push_back(j);
+            return true;
+          });
+          std::sort(current.begin(), current.end());
+          if (mMark[l] & kMoved) {
+            former = before[static_cast<size_t>(std::lower_bound(moved.begin(), moved.end(), l) - moved.begin())];
+          } else {
+            auto edges = [&](const std::vector<std::pair<size_t, size_t>>& list) {
+              std::vector<size_t> out;
+              for (auto e = std::lower_bound(list.begin(), list.end(), std::pair<size_t, size_t>{l, 0}); e != list.end() && e->first == l; ++e) {
+                out.push_back(e->second);
+              }
+              return out;
+            };
+            const auto gone = edges(edgeGone), fresh = edges(edgeNew);
+            std::set_difference(current.begin(), current.end(), fresh.begin(), fresh.end(), std::back_inserter(former));
+            former.insert(former.end(), gone.begin(), gone.end());
+          }
+          std::copy_if(former.begin(), former.end(), std::back_inserter(formerCores[c]), coreBefore);
+        }
+      });
+
+      // Lost points that were linked are checked as one group: the former
+      // core neighbors of the group that are still core must stay connected
+      std::vector<size_t> group(lost.size());
+      for (size_t c = 0; c < lost.size(); ++c) {
+        group[c] = c;
+      }
+      auto groupOf = [&](size_t c) {
+        while (group[c] != c) {
+          c = group[c] = group[group[c]];
+        }
+        return c;
+      };
+      for (size_t c = 0; c < lost.size(); ++c) {
+        for (const size_t j : formerCores[c]) {
+          if (mMark[j] & kLost) {
+            const size_t a = groupOf(c), b = groupOf(static_cast<size_t>(std::lower_bound(lost.begin(), lost.end(), j) - lost.begin()));
+            group[std::max(a, b)] = std::min(a, b);
+          }
+        }
+      }
+      std::vector<std::vector<size_t>> targets(lost.size());
+      for (size_t c = 0; c < lost.size(); ++c) {
+        const size_t g = group[c] = groupOf(c);
+        std::copy_if(formerCores[c].begin(), formerCores[c].end(), std::back_inserter(targets[g]), [&](size_t j) { return isCore[j] != 0; });
+      }
+      const auto lostDirty = parallelCollect(lost.size(), [&](size_t c, std::vector<size_t>& out) {
+        if (group[c] != c) {
+          return;
+        }
+        auto& t = targets[c];
+        std::sort(t.begin(), t.end());
+        t.erase(std::unique(t.begin(), t.end()), t.end());
+        std::vector<const GridCell*> cells;
+        if (!t.empty() && !splitLocally(t, cells)) {
+          out.push_back(static_cast<size_t>(labels[lost[c]]));
+        }
+      });
+      dirty.insert(dirty.end(), lostDirty.begin(), lostDirty.end());
+
+      // The open components left by the checks of one former cluster must be
+      // the same, or the part not holding the root would keep its label
+      std::sort(opens.begin(), opens.end());
+      opens.erase(std::unique(opens.begin(), opens.end()), opens.end());
+      for (size_t b = 0; b < opens.size();) {
+        size_t e = b + 1;
+        while (e < opens.size() && opens[e].first == opens[b].first) {
+          ++e;
+        }
+        if (e - b > 1) {
+          std::vector<size_t> reps;
+          for (size_t o = b; o < e; ++o) {
+            reps.push_back(opens[o].second);
+          }
+          std::vector<const GridCell*> cells;
+          const size_t nOpens = opens.size();
+          if (!splitLocally(reps, cells)) {
+            dirty.push_back(opens[b].first);
+          }
+          opens.resize(nOpens); // a single open component by now
+        }
+        b = e;
+      }
+
+      // Pieces found from several points are the same component. A piece
+      // holding a former root takes it away from the rest of its cluster,
+      // which is then re-linked.
+      for (auto& piece : pieces) {
+        std::sort(piece.begin(), piece.end());
+      }
+      std::sort(pieces.begin(), pieces.end(), [](const auto& a, const auto& b) { return a.front() < b.front(); });
+      pieces.erase(std::unique(pieces.begin(), pieces.end(), [](const auto& a, const auto& b) { return a.front() == b.front(); }), pieces.end());
+      for (const auto& piece : pieces) {
+        for (const size_t x : piece) {
+          if (labels[x] == static_cast<int32_t>(x)) {
+            dirty.push_back(x);
+          }
+        }
+      }
+      std::sort(dirty.begin(), dirty.end());
+      dirty.erase(std::unique(dirty.begin(), dirty.end()), dirty.end());
+      parallelFor(0, pieces.size(), [&](size_t begin, size_t end) {
+        std::vector<const GridCell*> cells;
+        for (size_t p = begin; p < end; ++p) {
+          const size_t root = pieces[p].front();
+          for (const size_t x : pieces[p]) {
+            parent[x].store(root, std::memory_order_relaxed);
+            labels[x] = static_cast<int32_t>(root);
+            forEachNeighbor(x, cells, [&](size_t j) {
+              if (!isCore[j]) {
+                setMark(mMark, j, kRelabel);
+              }
+              return true;
+            });
+          }
+        }
+      });
+
+      // Reset the members of dirty clusters; their border points are relabeled
+      std::vector<size_t> relink;
+      if (!dirty.empty()) {
+        for (const size_t root : dirty) {
+          mMark[root] |= kDirty;
+        }
+        relink = parallelCollect(n, [&](size_t i, std::vector<size_t>& out) {
+          if (labels[i] < 0 || !(mMark[static_cast<size_t>(labels[i])] & kDirty)) {
+            return;
+          }
+          if (isCore[i]) {
+            out.push_back(i);
+          } else {
+            setMark(mMark, i, kRelabel);
+          }
+          parent[i].store(i, std::memory_order_relaxed);
+        });
+        for (const size_t root : dirty) {
+          setMark(mMark, root, kRelabel); // the root may have lost its core status
+          mMark[root] &= static_cast<uint8_t>(~kDirty);
+        }
+      }
+      for (const size_t l : lost) {
+        parent[l].store(l, std::memory_order_relaxed);
+      }
+
+      // A cluster that lost its root but nothing else is handed to its
+      // smallest remaining core point (gained ones join through the unions)
+      std::vector<size_t> reroot;
+      for (const size_t l : lost) {
+        if (labels[l] == static_cast<int32_t>(l) && !std::binary_search(dirty.begin(), dirty.end(), l)) {
+          reroot.push_back(l);
+          mMark[l] |= kReroot;
+        }
+      }
+      if (!reroot.empty()) {
+        for (const size_t g : gained) {
+          mMark[g] |= kGained;
+        }
+        std::vector<size_t> newRoot(reroot.size(), n);
+        parallelFor(0, n, [&](size_t begin, size_t end) {
+          std::vector<uint8_t> seen(reroot.size(), 0);
+          for (size_t i = begin; i < end; ++i) {
+            if (!isCore[i] || labels[i] < 0 || !(mMark[static_cast<size_t>(labels[i])] & kReroot) || (mMark[i] & kGained)) {
+              continue;
+            }
+            const auto r = static_cast<size_t>(std::lower_bound(reroot.begin(), reroot.end(), static_cast<size_t>(labels[i])) - reroot.begin());
+            if (!seen[r]) { // ascending: the first member of the range is its smallest
+              seen[r] = 1;
+              std::atomic_ref<size_t> best(newRoot[r]);
+              size_t current = best.load(std::memory_order_relaxed);
+              while (i < current && !best.compare_exchange_weak(current, i, std::memory_order_relaxed)) {
+              }
+            }
+          }
+        });
+        for (size_t r = 0; r < reroot.size(); ++r) {
+          if (newRoot[r] < n) {
+            parent[newRoot[r]].store(newRoot[r], std::memory_order_relaxed);
+            parent[reroot[r]].store(newRoot[r], std::memory_order_relaxed);
+          }
+        }
+      }
+      relink.insert(relink.end(), gained.begin(), gained.end());
+
+      // Unite: re-linked and new core points with all their core neighbors,
+      // moved core points with their new core neighbors
+      parallelFor(0, relink.size(), [&](size_t begin, size_t end) {
+        std::vector<const GridCell*> cells;
+        for (size_t r = begin; r < end; ++r) {
+          forEachNeighbor(relink[r], cells, [&](size_t j) {
+            if (isCore[j]) {
+              unite(parent, relink[r], j);
+            }
+            return true;
+          });
+        }
+      });
+      parallelFor(0, nMoved, [&](size_t begin, size_t end) {
+        for (size_t k = begin; k < end; ++k) {
+          if (isCore[moved[k]]) {
+            for (const size_t j : added[k]) {
+              if (isCore[j]) {
+                unite(parent, moved[k], j);
+              }
+            }
+          }
+        }
+      });
+    }
+
+    // Step 6: Non-core points whose core neighbors may have changed: moved
+    // or touched ones, and the neighbors of points that changed status
+    std::vector<size_t> changed = lost;
+    changed.insert(changed.end(), gained.begin(), gained.end());
+    parallelFor(0, changed.size(), [&](size_t begin, size_t end) {
+      std::vector<const GridCell*> cells;
+      for (size_t c = begin; c < end; ++c) {
+        setMark(mMark, changed[c], kRelabel);
+        forEachNeighbor(changed[c], cells, [&](size_t j) {
+          setMark(mMark, j, kRelabel);
+          return true;
+        });
+      }
+    });
+    for (const size_t i : candidates) {
+      mMark[i] |= kRelabel;
+    }
+
+    // Step 7: Labels. Core points point at their root again; border points
+    // either follow their old cluster or look for a core neighbor afresh.
+    {
+      SCOPED_TIMER("\tlabels");
+      const auto relabel = parallelCollect(n, [&](size_t i, std::vector<size_t>& out) {
+        if (isCore[i]) {
+          const size_t root = find(parent, i);
+          parent[i].store(root, std::memory_order_relaxed);
+          labels[i] = static_cast<int32_t>(root);
+        } else if (mMark[i] & kRelabel) {
+          out.push_back(i);
+        } else if (labels[i] >= 0) {
+          labels[i] = static_cast<int32_t>(find(parent, static_cast<size_t>(labels[i])));
+        }
+      });
+      parallelFor(0, relabel.size(), [&](size_t begin, size_t end) {
+        std::vector<const GridCell*> cells;
+        for (size_t r = begin; r < end; ++r) {
+          const size_t i = relabel[r];
+          labels[i] = DB_NOISE;
+          parent[i].store(i, std::memory_order_relaxed);
+          forEachNeighbor(i, cells, [&](size_t j) {
+            if (isCore[j]) {
+              labels[i] = static_cast<int32_t>(find(parent, j));
+              return false;
+            }
+            return true;
+          });
+          mMark[i] = 0;
+        }
+      });
+      for (const size_t i : candidates) {
+        mMark[i] = 0;
+      }
+      for (const size_t i : changed) {
+        mMark[i] = 0;
+      }
+    }
+  });
+  countClusters();
+  return mResult;
+}
+
+template <typename T>
+void DBSCANWarmStart<T>::countClusters()
+{
+  using Counts = std::pair<int32_t, int32_t>; // (max label, noise)
+  const auto& labels = mResult.labels;
+  Counts counts{DB_UNVISITED, 0};
+  mTaskArena.execute([&] {
+    counts = parallelReduce(
+      0, labels.size(), Counts{DB_UNVISITED, 0},
+      [&](size_t begin, size_t end, Counts acc) {
+        for (size_t i = begin; i < end; ++i) {
+          acc.first = std::max(acc.first, labels[i]);
+          acc.second += labels[i] == DB_NOISE ? 1 : 0;
+        }
+        return acc;
+      },
+      [](const Counts& a, const Counts& b) { return Counts{std::max(a.first, b.first), a.second + b.second}; });
+  });
+  mResult.nClusters = counts.first + 1;
+  mResult.nNoise = counts.second;
+}
+
+#define DBSCAN_INSTANTIATE(T) template class DBSCANWarmStart<T>;
+DBSCAN_FOR_EACH_COORD_TYPE(DBSCAN_INSTANTIATE)
+#undef DBSCAN_INSTANTIATE
+
+} // namespace dbscan
@@ -0,0 +1,91 @@
+#include "dbscan_test_util.h"
+#include <algorithm>
+
+using namespace dbscan;
+using namespace dbscan::test;
+
+// clusterAnytime() for every engine: the coarse labels resolve only core
+// points the exact clustering puts in a cluster (grid engines) or nothing
+// (no grid), the refined future gives what cluster() gives, and the
+// refinement stops through its token, before it starts and from inside it
+int main()
+{
+  constexpr size_t kPoints = 20000;
+  const std::vector<float> points = makeBlobs(kPoints, 10, 1.5f, 40.0f, 23);
+
+  struct Config {
+    const char* name;
+    Engine engine;
+    int32_t numaPartitions;
+    bool coarsePass;
+  };
+  const Config configs[] = {
+    {"point graph", Engine::PointGraph, 0, NDim > 1},
+    {"cell graph", Engine::CellGraph, 0, NDim > 1},
+    {"sweep", Engine::Sweep, 0, false},
+    {"numa slabs", Engine::PointGraph, 3, false},
+  };
+  for (const Config& config : configs) {
+    DBSCANParams params = makeParams(0.5f, 5, 2);
+    params.engine = config.engine;
+    params.numaPartitions = config.numaPartitions;
+    const DBSCAN dbscan(params);
+    const DBSCANResult reference = dbscan.cluster(points.data(), kPoints);
+    const std::vector<uint8_t> core = bruteForceCore(points.data(), kPoints, params);
+    const int failures = gFailures;
+
+    CancellationToken token;
+    DBSCANAnytimeResult anytime = dbscan.clusterAnytime(points.data(), kPoints, token);
+    const DBSCANResult& coarse = anytime.coarse;
+    CHECK(coarse.status == DBSCANStatus::Coarse);
+    CHECK(coarse.labels.size() == kPoints);
+    size_t resolved = 0;
+    for (size_t i = 0; i < kPoints; ++i) {
+      if (coarse.labels[i] != DB_UNVISITED) {
+        ++resolved;
+        CHECK(coarse.labels[i] >= 0 && core[i] && reference.labels[i] >= 0);
+      }
+    }
+    CHECK(config.coarsePass ? resolved > 0 && coarse.nClusters > 0 : resolved == 0 && coarse.nClusters == 0);
+    CHECK(coarse.nNoise == 0);
+    const DBSCANResult refined = anytime.refined.get();
+    CHECK(refined.status == DBSCANStatus::Complete);
+    CHECK(sameClusters(refined, reference));
+
+    // Cancelled before the refinement starts
+    token.cancel();
+    anytime = dbscan.clusterAnytime(points.data(), kPoints, token);
+    DBSCANResult result = anytime.refined.get();
+    CHECK(result.status == DBSCANStatus::Cancelled);
+    CHECK(std::all_of(result.labels.begin(), result.labels.end(), [](int32_t label) { return label == DB_UNVISITED; }));
+
+    // Cancelled from inside the refinement, by its first progress report
+    token.reset();
+    DBSCANCallOptions options;
+    options.progress = [&](std::string_view, double fraction) {
+      if (fraction > 0.0) {
+        token.cancel();
+      }
+    };
+    anytime = dbscan.clusterAnytime(points.data(), kPoints, token, options);
+    result = anytime.refined.get();
+    CHECK(result.status == DBSCANStatus::Cancelled);
+    CHECK(std::all_of(result.labels.begin(), result.labels.end(), [](int32_t label) { return label == DB_UNVISITED; }));
+
+    // The next refinement is unaffected
+    token.reset();
+    CHECK(sameClusters(dbscan.clusterAnytime(points.data(), kPoints, token).refined.get(), reference));
+
+    if (gFailures != failures) {
+      std::cerr << "  engine: " << config.name << '\n';
+    }
+  }
+
+  // No points: nothing coarse, an empty refinement
+  CancellationToken token;
+  DBSCANAnytimeResult empty = DBSCAN(makeParams(0.5f, 5)).clusterAnytime(static_cast<const float*>(nullptr), 0, token);
+  CHECK(empty.coarse.labels.empty());
+  CHECK(empty.refined.get().labels.empty());
+
+  return finish("anytime_test");
+}
@@ -0,0 +1,76 @@
+#include "dbscan_test_util.h"
+
+using namespace dbscan;
+using namespace dbscan::test;
+
+// Regression fixture for the core-only union phase: a border point between
+// two clusters must not merge them, and a border point with a smaller index
+// than every core point of its cluster must not become its root (the whole
+// cluster then came out as noise). Points lie on dimension 0, eps 0.9,
+// minPts 4:
+//
+//   index 0      border, 0.85 from the last point of A and the first of B
+//   index 1      border of C, 0.85 before its first point
+//   2..10   A    x = 0.0, 0.2, ..., 1.6
+//   11..19  B    x = 3.3, 3.5, ..., 4.9
+//   20..28  C    x = 100.0, 100.2, ..., 101.6
+//   29           noise at x = 50
+int main()
+{
+  constexpr size_t kPoints = 30;
+  std::vector<float> points(kPoints * NDim, 0.0f);
+  auto at = [&](size_t i, float x) { points[i * NDim] = x; };
+  at(0, 2.45f);
+  at(1, 99.15f);
+  for (size_t k = 0; k < 9; ++k) {
+    at(2 + k, 0.2f * float(k));
+    at(11 + k, 3.3f + 0.2f * float(k));
+    at(20 + k, 100.0f + 0.2f * float(k));
+  }
+  at(29, 50.0f);
+
+  // Labels are the smallest core index of the cluster
+  std::vector<int32_t> expected(kPoints);
+  for (size_t k = 0; k < 9; ++k) {
+    expected[2 + k] = 2;
+    expected[11 + k] = 11;
+    expected[20 + k] = 20;
+  }
+  expected[1] = 20;
+  expected[29] = DB_NOISE;
+
+  struct Config {
+    const char* name;
+    Engine engine;
+    NeighborStorage storage;
+    Connectivity connectivity;
+  };
+  const Config configs[] = {
+    {"point graph", Engine::PointGraph, NeighborStorage::Explicit, Connectivity::UnionFind},
+    {"afforest", Engine::PointGraph, NeighborStorage::Explicit, Connectivity::Afforest},
+    {"compressed", Engine::PointGraph, NeighborStorage::Compressed, Connectivity::UnionFind},
+    {"hybrid", Engine::PointGraph, NeighborStorage::Hybrid, Connectivity::UnionFind},
+    {"cell graph", Engine::CellGraph, NeighborStorage::Explicit, Connectivity::UnionFind},
+    {"sweep", Engine::Sweep, NeighborStorage::Explicit, Connectivity::UnionFind},
+  };
+  for (const Config& config : configs) {
+    DBSCANParams params = makeParams(0.9f, 4);
+    params.engine = config.engine;
+    params.neighborStorage = config.storage;
+    params.connectivity = config.connectivity;
+    const DBSCANResult result = DBSCAN(params).cluster(points.data(), kPoints);
+
+    const int failures = gFailures;
+    // The bridging border point belongs to either side (DBSCAN leaves it open)
+    CHECK(result.labels[0] == 2 || result.labels[0] == 11);
+    for (size_t i = 1; i < kPoints; ++i) {
+      CHECK(result.labels[i] == expected[i]);
+    }
+    CHECK(result.nNoise == 1);
+    if (gFailures != failures) {
+      std::cerr << "  engine: " << config.name << '\n';
+    }
+  }
+
+  return finish("border_test");
+}
@@ -0,0 +1,67 @@
+#include "dbscan_test_util.h"
+#include <atomic>
+#include <thread>
+
+using namespace dbscan;
+using namespace dbscan::test;
+
+// cluster() from several threads at once on one instance, each thread
+// cycling through inputs of different sizes so pooled workspaces are reused
+// across sizes, against the results of serial calls. Races in the
+// workspace pool or the shared arena also show up here under -fsanitize=thread.
+int main()
+{
+  constexpr size_t kThreads = 6;
+  constexpr size_t kCallsPerThread = 8;
+  std::vector<std::vector<float>> inputs;
+  for (unsigned k = 0; k < 4; ++k) {
+    inputs.push_back(makeBlobs(3000 + (2000 * k), 8, 1.0f, 30.0f, 41 + k));
+  }
+
+  struct Config {
+    const char* name;
+    Engine engine;
+    NeighborStorage storage;
+  };
+  const Config configs[] = {
+    {"explicit", Engine::PointGraph, NeighborStorage::Explicit},
+    {"compressed", Engine::PointGraph, NeighborStorage::Compressed},
+    {"hybrid", Engine::PointGraph, NeighborStorage::Hybrid},
+    {"cell graph", Engine::CellGraph, NeighborStorage::Explicit},
+    {"sweep", Engine::Sweep, NeighborStorage::Explicit},
+  };
+  for (const Config& config : configs) {
+    DBSCANParams params = makeParams(0.4f, 5, 2);
+    params.engine = config.engine;
+    params.neighborStorage = config.storage;
+    const DBSCAN dbscan(params);
+    std::vector<DBSCANResult> expected;
+    for (const auto& input : inputs) {
+      expected.push_back(dbscan.cluster(input.data(), input.size() / NDim));
+    }
+
+    std::atomic<size_t> mismatches{0};
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < kThreads; ++t) {
+      threads.emplace_back([&, t] {
+        for (size_t call = 0; call < kCallsPerThread; ++call) {
+          const size_t k = (t + call) % inputs.size();
+          const DBSCANResult result = dbscan.cluster(inputs[k].data(), inputs[k].size() / NDim);
+          if (!sameClusters(result, expected[k])) {
+            mismatches.fetch_add(1, std::memory_order_relaxed);
+          }
+        }
+      });
+    }
+    for (auto& thread : threads) {
+      thread.join();
+    }
+
+    CHECK(mismatches.load() == 0);
+    if (mismatches.load() != 0) {
+      std::cerr << "  config: " << config.name << ", " << mismatches.load() << " call(s) differ\n";
+    }
+  }
+
+  return finish("concurrency_test");
+}
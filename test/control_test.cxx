@@ -0,0 +1,116 @@
+#include "dbscan_test_util.h"
+#include <algorithm>
+#include <map>
+#include <string>
+#include <thread>
+
+using namespace dbscan;
+using namespace dbscan::test;
+
+namespace
+{
+bool allUnvisited(const DBSCANResult& result)
+{
+  return std::all_of(result.labels.begin(), result.labels.end(), [](int32_t label) { return label == DB_UNVISITED; }) && result.nClusters == 0 &&
+         result.nNoise == 0;
+}
+} // namespace
+
+// Cancellation, deadlines and progress of cluster(), for every engine: a
+// stopped call leaves every label DB_UNVISITED, progress only moves forward
+// within a phase, and a stopped call has no effect on the next one
+int main()
+{
+  constexpr size_t kPoints = 20000;
+  const std::vector<float> points = makeBlobs(kPoints, 10, 1.5f, 40.0f, 13);
+  const auto now = [] { return std::chrono::steady_clock::now(); };
+
+  struct Config {
+    const char* name;
+    Engine engine;
+    int32_t numaPartitions;
+  };
+  const Config configs[] = {
+    {"point graph", Engine::PointGraph, 0},
+    {"cell graph", Engine::CellGraph, 0},
+    {"sweep", Engine::Sweep, 0},
+    {"numa slabs", Engine::PointGraph, 3},
+  };
+  for (const Config& config : configs) {
+    DBSCANParams params = makeParams(0.5f, 5, 2);
+    params.engine = config.engine;
+    params.numaPartitions = config.numaPartitions;
+    const DBSCAN dbscan(params);
+    const DBSCANResult reference = dbscan.cluster(points.data(), kPoints);
+    const int failures = gFailures;
+
+    // Progress: fractions in [0, 1], never falling within one entry of a
+    // phase (an entry reports 0 first)
+    {
+      std::map<std::string, double, std::less<>> last;
+      size_t reports = 0;
+      bool ordered = true;
+      DBSCANCallOptions options;
+      options.progress = [&](std::string_view phase, double fraction) {
+        ++reports;
+        auto& previous = last[std::string(phase)];
+        ordered &= fraction >= 0.0 && fraction <= 1.0 && (fraction == 0.0 || fraction >= previous);
+        previous = fraction;
+      };
+      const DBSCANResult result = dbscan.cluster(points.data(), kPoints, options);
+      CHECK(result.status == DBSCANStatus::Complete);
+      CHECK(sameClusters(result, reference));
+      CHECK(reports > 0);
+      CHECK(ordered);
+    }
+
+    // Cancelled before the call, and from inside it
+    CancellationToken token;
+    DBSCANCallOptions cancellable;
+    cancellable.cancel = &token;
+    token.cancel();
+    DBSCANResult result = dbscan.cluster(points.data(), kPoints, cancellable);
+    CHECK(result.status == DBSCANStatus::Cancelled);
+    CHECK(allUnvisited(result));
+    token.reset();
+    cancellable.progress = [&](std::string_view, double fraction) {
+      if (fraction > 0.0) {
+        token.cancel();
+      }
+    };
+    result = dbscan.cluster(points.data(), kPoints, cancellable);
+    CHECK(result.status == DBSCANStatus::Cancelled);
+    CHECK(allUnvisited(result));
+
+    // The next calls are unaffected
+    token.reset();
+    cancellable.progress = {};
+    CHECK(sameClusters(dbscan.cluster(points.data(), kPoints, cancellable), reference));
+    CHECK(sameClusters(dbscan.cluster(points.data(), kPoints), reference));
+
+    // Deadline passed before the call, and during it (the first report
+    // outlasts it)
+    DBSCANCallOptions timed;
+    timed.deadline = now() - std::chrono::seconds(1);
+    result = dbscan.cluster(points.data(), kPoints, timed);
+    CHECK(result.status == DBSCANStatus::DeadlineExceeded);
+    CHECK(allUnvisited(result));
+    timed.deadline = now() + std::chrono::milliseconds(20);
+    timed.progress = [&, slept = false](std::string_view, double) mutable {
+      if (!slept) {
+        slept = true;
+        std::this_thread::sleep_until(timed.deadline + std::chrono::milliseconds(5));
+      }
+    };
+    result = dbscan.cluster(points.data(), kPoints, timed);
+    CHECK(result.status == DBSCANStatus::DeadlineExceeded);
+    CHECK(allUnvisited(result));
+    CHECK(sameClusters(dbscan.cluster(points.data(), kPoints), reference));
+
+    if (gFailures != failures) {
+      std::cerr << "  engine: " << config.name << '\n';
+    }
+  }
+
+  return finish("control_test");
+}
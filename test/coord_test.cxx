@@ -0,0 +1,83 @@
+#include "dbscan_test_util.h"
+#include <type_traits>
+
+using namespace dbscan;
+using namespace dbscan::test;
+
+namespace
+{
+template <typename T>
+T fromFloat(float v)
+{
+  if constexpr (std::is_same_v<T, Float16> || std::is_same_v<T, BFloat16>) {
+    return T::fromFloat(v);
+  } else if constexpr (std::is_integral_v<T>) {
+    return static_cast<T>(std::lround(v));
+  } else {
+    return static_cast<T>(v);
+  }
+}
+
+struct Config {
+  const char* name;
+  Engine engine;
+  NeighborStorage storage;
+  Connectivity connectivity;
+  bool compactCoords;
+};
+const Config kConfigs[] = {
+  {"point graph", Engine::PointGraph, NeighborStorage::Explicit, Connectivity::UnionFind, false},
+  {"afforest", Engine::PointGraph, NeighborStorage::Explicit, Connectivity::Afforest, false},
+  {"compressed", Engine::PointGraph, NeighborStorage::Compressed, Connectivity::UnionFind, false},
+  {"hybrid", Engine::PointGraph, NeighborStorage::Hybrid, Connectivity::UnionFind, false},
+  {"compact coords", Engine::PointGraph, NeighborStorage::Explicit, Connectivity::UnionFind, true},
+  {"cell graph", Engine::CellGraph, NeighborStorage::Explicit, Connectivity::UnionFind, false},
+  {"sweep", Engine::Sweep, NeighborStorage::Explicit, Connectivity::UnionFind, false},
+};
+
+// Clusters the blobs stored as T with every configuration and compares with
+// brute force on the values T holds (widened to float, which is exact for
+// all of them here). Integer types get a fractional eps: only floor(eps)
+// may count.
+template <typename T>
+void checkType(const char* type)
+{
+  constexpr size_t kPoints = 4000;
+  const float eps = std::is_integral_v<T> ? 2.5f : 1.25f;
+  const std::vector<float> blobs = makeBlobs(kPoints, 12, 3.0f, 200.0f, 29);
+  std::vector<T> points(blobs.size());
+  std::vector<float> stored(blobs.size());
+  for (size_t k = 0; k < blobs.size(); ++k) {
+    points[k] = fromFloat<T>(blobs[k]);
+    stored[k] = static_cast<float>(CoordTraits<T>::load(points[k]));
+  }
+  const DBSCANParams reference = makeParams(eps, 5);
+  const std::vector<int32_t> expected = bruteForceLabels(stored.data(), kPoints, reference);
+
+  for (const Config& config : kConfigs) {
+    DBSCANParams params = reference;
+    params.engine = config.engine;
+    params.neighborStorage = config.storage;
+    params.connectivity = config.connectivity;
+    params.compactCoords = config.compactCoords;
+    const DBSCANResult result = DBSCAN(params).cluster(points.data(), kPoints);
+
+    const int failures = gFailures;
+    CHECK(sameClustering(stored.data(), kPoints, reference, expected, result.labels));
+    if (gFailures != failures) {
+      std::cerr << "  type: " << type << ", engine: " << config.name << '\n';
+    }
+  }
+}
+} // namespace
+
+// Every coordinate type cluster() is instantiated for, with every engine,
+// neighbor storage and compact coordinates
+int main()
+{
+#define DBSCAN_CHECK_TYPE(T) checkType<T>(#T);
+  DBSCAN_FOR_EACH_COORD_TYPE(DBSCAN_CHECK_TYPE)
+#undef DBSCAN_CHECK_TYPE
+
+  return finish("coord_test");
+}
@@ -0,0 +1,96 @@
+#include "DBSCAN/DBSCANDaemon.h"
+#include "dbscan_test_util.h"
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <cstring>
+#include <thread>
+
+using namespace dbscan;
+using namespace dbscan::test;
+
+namespace
+{
+// Connect to path without saying hello; -1 on failure
+int connectSilently(const std::string& path)
+{
+  sockaddr_un address{};
+  address.sun_family = AF_UNIX;
+  std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+  const int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+  if (fd >= 0 && connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0) {
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+std::unique_ptr<DBSCANDaemonClient> connectClient(const std::string& path, uint32_t capacity)
+{
+  // The daemon may still be binding its socket
+  std::unique_ptr<DBSCANDaemonClient> client;
+  for (int attempt = 0; attempt < 200 && (client == nullptr || !client->connected()); ++attempt) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    client = std::make_unique<DBSCANDaemonClient>(path, 2, capacity);
+  }
+  return client;
+}
+} // namespace
+
+// The daemon against cluster(), with a client that never says hello
+// connected meanwhile, a second daemon refused on a live socket path and a
+// stale socket file taken over
+int main()
+{
+  constexpr uint32_t kPoints = 5000;
+  const DBSCANParams params = makeParams(0.5f, 5, 1);
+  const std::vector<float> points = makeBlobs(kPoints, 8, 1.5f, 30.0f, 21);
+  const DBSCANResult reference = DBSCAN(params).cluster(points.data(), kPoints);
+  const std::string path = "/tmp/dbscan_daemon_test_" + std::to_string(getpid()) + ".sock";
+
+  // A stale socket file (bound, never listened on) is taken over
+  {
+    const int stale = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    CHECK(bind(stale, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == 0);
+    close(stale);
+  }
+
+  DBSCANDaemon daemon(params, path, 1);
+  bool served = false;
+  std::thread server([&] { served = daemon.run(); });
+
+  const auto client = connectClient(path, kPoints);
+  CHECK(client->connected());
+  if (client->connected()) {
+    // A silent client must not hold up the others
+    const int silent = connectSilently(path);
+    CHECK(silent >= 0);
+
+    std::copy(points.begin(), points.end(), client->points(0));
+    CHECK(client->submit(0, kPoints, 0, 7));
+    DaemonReply reply{};
+    CHECK(client->wait(reply));
+    CHECK(reply.status == 0 && reply.tag == 7 && reply.nNoise == reference.nNoise && reply.nClusters == reference.nClusters);
+    CHECK(std::equal(reference.labels.begin(), reference.labels.end(), client->labels(0)));
+
+    // ... and is dropped once its hello is overdue
+    if (silent >= 0) {
+      char byte = 0;
+      CHECK(recv(silent, &byte, 1, 0) == 0);
+      close(silent);
+    }
+
+    // A second daemon leaves a live socket alone
+    DBSCANDaemon second(params, path, 1);
+    CHECK(!second.run());
+    CHECK(DBSCANDaemonClient(path, 1, 16).connected());
+  }
+
+  daemon.stop();
+  server.join();
+  CHECK(served);
+  return finish("daemon_test");
+}
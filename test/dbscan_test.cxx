@@ -123,7 +123,7 @@ int main()
   auto points = generate_test_data(n_points);
 
   // Configure DBSCAN with separate epsilons
-  DBSCANParams params({eps_space, eps_time}, min_pts);
+  DBSCANParams params{{eps_space, eps_time}, min_pts, 0};
 
   // Run clustering
   std::cout << "Running DBSCAN clustering..." << std::endl;
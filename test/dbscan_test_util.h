@@ -0,0 +1,166 @@
+#pragma once
+
+#include "DBSCAN/DBSCAN.h"
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <random>
+#include <vector>
+
+// Minimal checks for the ctest programs: a failed check is reported and
+// counted, the program carries on and exits non-zero at the end.
+namespace dbscan::test
+{
+
+inline int gFailures = 0;
+
+#define CHECK(cond)                                                                   \
+  do {                                                                                \
+    if (!(cond)) {                                                                    \
+      std::cerr << __FILE__ << ':' << __LINE__ << ": check failed: " #cond << '\n';   \
+      ++dbscan::test::gFailures;                                                      \
+    }                                                                                 \
+  } while (false)
+
+inline int finish(const char* name)
+{
+  if (gFailures > 0) {
+    std::cerr << name << ": " << gFailures << " check(s) failed\n";
+    return EXIT_FAILURE;
+  }
+  std::cout << name << ": passed\n";
+  return EXIT_SUCCESS;
+}
+
+// nBlobs Gaussian blobs of the given spread in [0, extent]^NDim, plus a
+// quarter as many uniform noise points
+inline std::vector<float> makeBlobs(size_t n, size_t nBlobs, float spread, float extent, unsigned seed)
+{
+  std::mt19937 gen(seed);
+  std::uniform_real_distribution<float> uniform(0.0f, extent);
+  std::normal_distribution<float> offset(0.0f, spread);
+
+  std::vector<float> centers(nBlobs * NDim);
+  for (auto& c : centers) {
+    c = uniform(gen);
+  }
+  std::vector<float> points(n * NDim);
+  const size_t nNoise = n / 4;
+  for (size_t i = 0; i < n; ++i) {
+    const size_t blob = i % nBlobs;
+    for (size_t d = 0; d < NDim; ++d) {
+      points[i * NDim + d] = i < nNoise ? uniform(gen) : centers[blob * NDim + d] + offset(gen);
+    }
+  }
+  return points;
+}
+
+// Parameters with the same eps in every dimension
+inline DBSCANParams makeParams(float eps, int32_t minPts, int32_t nThreads = 0)
+{
+  DBSCANParams params{{}, minPts, nThreads};
+  params.eps.fill(eps);
+  return params;
+}
+
+// Identical labels and counts
+inline bool sameClusters(const DBSCANResult& a, const DBSCANResult& b)
+{
+  return a.labels == b.labels && a.nClusters == b.nClusters && a.nNoise == b.nNoise;
+}
+
+inline bool areNeighbors(const float* p, const float* q, const DBSCANParams& params)
+{
+  for (size_t d = 0; d < NDim; ++d) {
+    if (std::abs(p[d] - q[d]) > params.eps[d]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Core flags by brute force: minPts neighbors, the point itself not counted
+inline std::vector<uint8_t> bruteForceCore(const float* points, size_t n, const DBSCANParams& params)
+{
+  std::vector<uint8_t> core(n);
+  for (size_t i = 0; i < n; ++i) {
+    int32_t count = 0;
+    for (size_t j = 0; j < n && count < params.minPts; ++j) {
+      count += j != i && areNeighbors(&points[i * NDim], &points[j * NDim], params) ? 1 : 0;
+    }
+    core[i] = count >= params.minPts;
+  }
+  return core;
+}
+
+// Labels by brute force: core points linked within eps share the smallest
+// core index of their cluster, border points take that of a core neighbor
+inline std::vector<int32_t> bruteForceLabels(const float* points, size_t n, const DBSCANParams& params)
+{
+  const std::vector<uint8_t> core = bruteForceCore(points, n, params);
+  std::vector<size_t> parent(n);
+  for (size_t i = 0; i < n; ++i) {
+    parent[i] = i;
+  }
+  auto root = [&](size_t i) {
+    while (parent[i] != i) {
+      i = parent[i] = parent[parent[i]];
+    }
+    return i;
+  };
+  for (size_t i = 0; i < n; ++i) {
+    for (size_t j = i + 1; j < n && core[i]; ++j) {
+      if (core[j] && areNeighbors(&points[i * NDim], &points[j * NDim], params)) {
+        const size_t a = root(i), b = root(j);
+        parent[std::max(a, b)] = std::min(a, b);
+      }
+    }
+  }
+  std::vector<int32_t> labels(n, DB_NOISE);
+  for (size_t i = 0; i < n; ++i) {
+    for (size_t j = 0; j < n && labels[i] == DB_NOISE; ++j) {
+      if (core[j] && (j == i || areNeighbors(&points[i * NDim], &points[j * NDim], params))) {
+        labels[i] = static_cast<int32_t>(root(j));
+      }
+    }
+  }
+  return labels;
+}
+
+// Whether labels b describe the clustering of labels a, whatever the ids:
+// the same noise, the same clusters of core points, and every border point
+// in the cluster of one of its core neighbors (DBSCAN leaves open which)
+template <typename LabelsA, typename LabelsB>
+bool sameClustering(const float* points, size_t n, const DBSCANParams& params, const LabelsA& a, const LabelsB& b)
+{
+  const std::vector<uint8_t> core = bruteForceCore(points, n, params);
+  std::map<int64_t, int64_t> aToB, bToA;
+  for (size_t i = 0; i < n; ++i) {
+    if ((a[i] < 0) != (b[i] < 0) || (core[i] && a[i] < 0)) {
+      return false;
+    }
+    if (a[i] >= 0 && core[i]) {
+      const int64_t la = a[i], lb = b[i];
+      if (aToB.emplace(la, lb).first->second != lb || bToA.emplace(lb, la).first->second != la) {
+        return false;
+      }
+    }
+  }
+  auto attached = [&](size_t i, const auto& labels) {
+    for (size_t j = 0; j < n; ++j) {
+      if (core[j] && labels[j] == labels[i] && areNeighbors(&points[i * NDim], &points[j * NDim], params)) {
+        return true;
+      }
+    }
+    return false;
+  };
+  for (size_t i = 0; i < n; ++i) {
+    if (a[i] >= 0 && !core[i] && (!attached(i, a) || !attached(i, b))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace dbscan::test
@@ -0,0 +1,66 @@
+#include "DBSCAN/DBSCANMPI.h"
+#include "dbscan_test_util.h"
+
+using namespace dbscan;
+using namespace dbscan::test;
+
+// DBSCANMPI over the ranks of MPI_COMM_WORLD (run under mpirun with any
+// number of ranks) against a serial cluster() of the same points, once with
+// the points dealt round-robin and once with all of them on rank 0
+int main(int argc, char** argv)
+{
+  MPI_Init(&argc, &argv);
+  int rank = 0, nRanks = 1;
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  MPI_Comm_size(MPI_COMM_WORLD, &nRanks);
+
+  constexpr size_t kPoints = 6000;
+  const DBSCANParams params = makeParams(0.5f, 5, 1);
+  const std::vector<float> points = makeBlobs(kPoints, 10, 1.5f, 40.0f, 5);
+  const DBSCANResult serial = DBSCAN(params).cluster(points.data(), kPoints);
+  const DBSCANMPI dbscan(params, MPI_COMM_WORLD);
+
+  for (const bool roundRobin : {true, false}) {
+    std::vector<int32_t> mine;
+    std::vector<float> myPoints;
+    for (size_t i = 0; i < kPoints; ++i) {
+      if (roundRobin ? i % static_cast<size_t>(nRanks) == static_cast<size_t>(rank) : rank == 0) {
+        mine.push_back(static_cast<int32_t>(i));
+        myPoints.insert(myPoints.end(), &points[i * NDim], &points[i * NDim] + NDim);
+      }
+    }
+    const DBSCANMPIResult result = dbscan.cluster(myPoints.data(), mine.size());
+
+    // Everything to rank 0
+    const int count = static_cast<int>(mine.size());
+    std::vector<int> counts(static_cast<size_t>(nRanks)), displ(static_cast<size_t>(nRanks));
+    MPI_Gather(&count, 1, MPI_INT, counts.data(), 1, MPI_INT, 0, MPI_COMM_WORLD);
+    for (size_t r = 1; r < counts.size(); ++r) {
+      displ[r] = displ[r - 1] + counts[r - 1];
+    }
+    std::vector<int32_t> index(rank == 0 ? kPoints : 0);
+    std::vector<int64_t> gathered(rank == 0 ? kPoints : 0);
+    MPI_Gatherv(mine.data(), count, MPI_INT32_T, index.data(), counts.data(), displ.data(), MPI_INT32_T, 0, MPI_COMM_WORLD);
+    MPI_Gatherv(result.labels.data(), count, MPI_INT64_T, gathered.data(), counts.data(), displ.data(), MPI_INT64_T, 0, MPI_COMM_WORLD);
+
+    if (rank == 0) {
+      std::vector<int64_t> labels(kPoints);
+      for (size_t k = 0; k < kPoints; ++k) {
+        labels[static_cast<size_t>(index[k])] = gathered[k];
+      }
+      const bool same = sameClustering(points.data(), kPoints, params, serial.labels, labels);
+      CHECK(same);
+      CHECK(result.nNoise == serial.nNoise);
+      if (!same) {
+        std::cerr << "  " << nRanks << " ranks, " << (roundRobin ? "round-robin" : "all on rank 0") << " differ\n";
+      }
+    }
+  }
+
+  int failures = gFailures;
+  MPI_Bcast(&failures, 1, MPI_INT, 0, MPI_COMM_WORLD);
+  gFailures = failures;
+  const int status = rank == 0 ? finish("mpi_test") : (failures > 0 ? EXIT_FAILURE : EXIT_SUCCESS);
+  MPI_Finalize();
+  return status;
+}
@@ -0,0 +1,35 @@
+#include "dbscan_test_util.h"
+
+using namespace dbscan;
+using namespace dbscan::test;
+
+// NUMA-partitioned execution with a forced slab count (all slabs land on
+// the nodes there are, one node is enough) against the default engine
+int main()
+{
+  constexpr size_t kPoints = 40000; // several bucketing blocks
+  const DBSCANParams params = makeParams(0.5f, 5, 2);
+  const std::vector<float> points = makeBlobs(kPoints, 16, 2.0f, 60.0f, 9);
+  const DBSCANResult reference = DBSCAN(params).cluster(points.data(), kPoints);
+
+  for (const int32_t slabs : {2, 3, 5, 8}) {
+    DBSCANParams partitioned = params;
+    partitioned.numaPartitions = slabs;
+    const DBSCANResult result = DBSCAN(partitioned).cluster(points.data(), kPoints);
+    const bool same = sameClustering(points.data(), kPoints, params, reference.labels, result.labels);
+    CHECK(same);
+    CHECK(result.nNoise == reference.nNoise);
+    if (!same) {
+      std::cerr << "  " << slabs << " slabs differ\n";
+    }
+  }
+
+  // No cut wider than eps: falls back to a single run
+  constexpr size_t kFlat = 500;
+  const std::vector<float> flat(kFlat * NDim, 1.0f);
+  DBSCANParams partitioned = params;
+  partitioned.numaPartitions = 4;
+  CHECK(sameClusters(DBSCAN(partitioned).cluster(flat.data(), kFlat), DBSCAN(params).cluster(flat.data(), kFlat)));
+
+  return finish("numa_test");
+}
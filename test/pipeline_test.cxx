@@ -0,0 +1,71 @@
+#include "DBSCAN/DBSCANPipeline.h"
+#include "dbscan_test_util.h"
+
+using namespace dbscan;
+using namespace dbscan::test;
+
+// DBSCANPipeline against cluster() on the same frames, submitted back to
+// back so several are in flight at once: the staged PointGraph path with
+// its storages, connectivities and the tuner, and the parameters it hands
+// to cluster() whole (other engines, NUMA slabs)
+int main()
+{
+  constexpr size_t kFrames = 12;
+  std::vector<std::vector<float>> frames;
+  for (size_t f = 0; f < kFrames; ++f) {
+    frames.push_back(f == 5 ? std::vector<float>{} : makeBlobs(2000 + (500 * f), 8, 1.0f, 30.0f, static_cast<unsigned>(f + 1)));
+  }
+
+  struct Config {
+    const char* name;
+    Engine engine;
+    NeighborStorage storage;
+    Connectivity connectivity;
+    bool compactCoords;
+    int32_t numaPartitions;
+    bool calibrate;
+  };
+  const Config configs[] = {
+    {"point graph", Engine::PointGraph, NeighborStorage::Explicit, Connectivity::UnionFind, false, 0, false},
+    {"compressed afforest", Engine::PointGraph, NeighborStorage::Compressed, Connectivity::Afforest, false, 0, false},
+    {"hybrid", Engine::PointGraph, NeighborStorage::Hybrid, Connectivity::UnionFind, false, 0, false},
+    {"compact coords, calibrated", Engine::PointGraph, NeighborStorage::Explicit, Connectivity::UnionFind, true, 0, true},
+    {"cell graph", Engine::CellGraph, NeighborStorage::Explicit, Connectivity::UnionFind, false, 0, false},
+    {"sweep", Engine::Sweep, NeighborStorage::Explicit, Connectivity::UnionFind, false, 0, false},
+    {"numa slabs", Engine::PointGraph, NeighborStorage::Explicit, Connectivity::UnionFind, false, 3, false},
+  };
+  for (const Config& config : configs) {
+    DBSCANParams params = makeParams(0.4f, 5, 2);
+    params.engine = config.engine;
+    params.neighborStorage = config.storage;
+    params.connectivity = config.connectivity;
+    params.compactCoords = config.compactCoords;
+    params.numaPartitions = config.numaPartitions;
+    params.pointsPerThread = config.calibrate ? 1000 : 0;
+    params.calibrateParallelism = config.calibrate;
+    const DBSCAN reference(params);
+
+    std::vector<std::future<DBSCANResult>> futures;
+    {
+      DBSCANPipeline pipeline(params, 3);
+      for (const auto& frame : frames) {
+        futures.push_back(pipeline.submit(frame));
+      }
+    } // the destructor drains the pipeline
+
+    const int failures = gFailures;
+    for (size_t f = 0; f < kFrames; ++f) {
+      const size_t n = frames[f].size() / NDim;
+      const DBSCANResult result = futures[f].get();
+      const DBSCANResult expected = reference.cluster(frames[f].data(), n);
+      CHECK(result.labels.size() == n);
+      CHECK(result.nClusters == expected.nClusters && result.nNoise == expected.nNoise);
+      CHECK(sameClustering(frames[f].data(), n, params, expected.labels, result.labels));
+    }
+    if (gFailures != failures) {
+      std::cerr << "  config: " << config.name << '\n';
+    }
+  }
+
+  return finish("pipeline_test");
+}
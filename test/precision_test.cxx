@@ -0,0 +1,63 @@
+#include "dbscan_test_util.h"
+
+using namespace dbscan;
+using namespace dbscan::test;
+
+// Float input far from the origin, where the coordinate spacing (1/16 at
+// 1e6, 1/128 at 1e5) is a sizable fraction of eps or more: every engine must still
+// agree with brute force, so nothing derived from absolute coordinates may
+// lose the precision the neighbor test has
+int main()
+{
+  constexpr size_t kPoints = 2500;
+
+  struct Case {
+    float offset;
+    float eps;
+    float spread;
+  };
+  const Case cases[] = {
+    {5e5f, 0.05f, 0.1f},
+    {1e5f, 0.01f, 0.02f},
+    {1e6f, 0.05f, 0.1f},
+    {1e5f, 0.004f, 0.01f},
+  };
+  struct Config {
+    const char* name;
+    Engine engine;
+    NeighborStorage storage;
+    Connectivity connectivity;
+  };
+  const Config configs[] = {
+    {"point graph", Engine::PointGraph, NeighborStorage::Explicit, Connectivity::UnionFind},
+    {"afforest", Engine::PointGraph, NeighborStorage::Explicit, Connectivity::Afforest},
+    {"compressed", Engine::PointGraph, NeighborStorage::Compressed, Connectivity::UnionFind},
+    {"hybrid", Engine::PointGraph, NeighborStorage::Hybrid, Connectivity::UnionFind},
+    {"cell graph", Engine::CellGraph, NeighborStorage::Explicit, Connectivity::UnionFind},
+    {"sweep", Engine::Sweep, NeighborStorage::Explicit, Connectivity::UnionFind},
+  };
+  for (const Case& c : cases) {
+    for (unsigned seed = 1; seed <= 6; ++seed) {
+      std::vector<float> points = makeBlobs(kPoints, 8, c.spread, 40.0f * c.eps, seed);
+      for (auto& x : points) {
+        x += c.offset;
+      }
+      const std::vector<int32_t> expected = bruteForceLabels(points.data(), kPoints, makeParams(c.eps, 3));
+      for (const Config& config : configs) {
+        DBSCANParams params = makeParams(c.eps, 3);
+        params.engine = config.engine;
+        params.neighborStorage = config.storage;
+        params.connectivity = config.connectivity;
+        const DBSCANResult result = DBSCAN(params).cluster(points.data(), kPoints);
+
+        const int failures = gFailures;
+        CHECK(sameClustering(points.data(), kPoints, params, expected, result.labels));
+        if (gFailures != failures) {
+          std::cerr << "  engine: " << config.name << ", offset " << c.offset << ", seed " << seed << '\n';
+        }
+      }
+    }
+  }
+
+  return finish("precision_test");
+}
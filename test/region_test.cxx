@@ -0,0 +1,92 @@
+#include "dbscan_test_util.h"
+#include <algorithm>
+#include <set>
+
+using namespace dbscan;
+using namespace dbscan::test;
+
+// clusterRegion() against cluster() for several boxes: every cluster
+// touching the box (a core point in it, or a core neighbor of a point in
+// it) comes out with the ids of the full run, a border point may take any
+// cluster it borders, the box's other points are noise and all remaining
+// points stay DB_UNVISITED
+int main()
+{
+  constexpr size_t kPoints = 10000;
+  constexpr float kExtent = 40.0f;
+  const DBSCANParams params = makeParams(0.5f, 5, 2);
+  const std::vector<float> points = makeBlobs(kPoints, 10, 1.5f, kExtent, 17);
+  const DBSCAN dbscan(params);
+  const DBSCANResult full = dbscan.cluster(points.data(), kPoints);
+
+  // Full-run clusters each point may belong to: its own if core, those of
+  // its core neighbors otherwise
+  const std::vector<uint8_t> core = bruteForceCore(points.data(), kPoints, params);
+  std::vector<std::set<int32_t>> clustersOf(kPoints);
+  for (size_t i = 0; i < kPoints; ++i) {
+    if (core[i]) {
+      clustersOf[i].insert(full.labels[i]);
+      continue;
+    }
+    for (size_t j = 0; j < kPoints; ++j) {
+      if (core[j] && areNeighbors(&points[i * NDim], &points[j * NDim], params)) {
+        clustersOf[i].insert(full.labels[j]);
+      }
+    }
+  }
+
+  struct Box {
+    const char* name;
+    float lower, upper; // the same in every dimension
+  };
+  const Box boxes[] = {
+    {"small", 10.0f, 11.0f},
+    {"middle", 15.0f, 25.0f},
+    {"everything", -1.0f, kExtent + 10.0f},
+    {"corner", -5.0f, 0.5f},
+    {"outside", kExtent + 5.0f, kExtent + 6.0f},
+  };
+  for (const Box& box : boxes) {
+    std::array<float, NDim> lower, upper;
+    lower.fill(box.lower);
+    upper.fill(box.upper);
+    const DBSCANResult region = dbscan.clusterRegion(points.data(), kPoints, lower, upper);
+    auto inBox = [&](size_t i) {
+      return std::all_of(&points[i * NDim], &points[i * NDim] + NDim, [&](float x) { return x >= box.lower && x <= box.upper; });
+    };
+
+    std::set<int32_t> touched;
+    for (size_t i = 0; i < kPoints; ++i) {
+      if (inBox(i)) {
+        touched.insert(clustersOf[i].begin(), clustersOf[i].end());
+      }
+    }
+    const int failures = gFailures;
+    int32_t nNoise = 0;
+    for (size_t i = 0; i < kPoints; ++i) {
+      const int32_t label = region.labels[i];
+      const bool resolved = std::any_of(clustersOf[i].begin(), clustersOf[i].end(), [&](int32_t c) { return touched.count(c) > 0; });
+      if (inBox(i)) {
+        CHECK((label == DB_NOISE) == (full.labels[i] == DB_NOISE));
+        nNoise += label == DB_NOISE ? 1 : 0;
+      } else if (resolved) {
+        CHECK(label >= 0);
+      } else {
+        CHECK(label == DB_UNVISITED);
+      }
+      if (label >= 0) {
+        CHECK(touched.count(label) > 0 && clustersOf[i].count(label) > 0);
+      }
+      if (core[i] && resolved) {
+        CHECK(label == full.labels[i]);
+      }
+    }
+    CHECK(region.status == DBSCANStatus::Complete);
+    CHECK(region.nNoise == nNoise);
+    if (gFailures != failures) {
+      std::cerr << "  box: " << box.name << '\n';
+    }
+  }
+
+  return finish("region_test");
+}
@@ -0,0 +1,71 @@
+#include "DBSCAN/DBSCANStitch.h"
+#include "dbscan_test_util.h"
+
+using namespace dbscan;
+using namespace dbscan::test;
+
+// Cluster random data in chunks cut along the last dimension, stitch the
+// chunks and compare with one cluster() over all of it, for several sets of
+// cut positions (cuts through blobs included)
+int main()
+{
+  constexpr size_t kPoints = 5000;
+  constexpr float kExtent = 40.0f;
+  constexpr int32_t kDim = NDim - 1;
+  const DBSCANParams params = makeParams(0.5f, 5);
+  const std::vector<float> points = makeBlobs(kPoints, 10, 1.5f, kExtent, 3);
+  const DBSCAN dbscan(params);
+  const DBSCANResult whole = dbscan.cluster(points.data(), kPoints);
+
+  const std::vector<std::vector<double>> cutSets = {
+    {20.0},
+    {10.3, 25.7},
+    {5.0, 12.0, 19.0, 26.0, 33.0},
+    {1.0, 2.1, 3.2, 38.9}, // chunks barely wider than eps
+  };
+  for (const auto& cuts : cutSets) {
+    const size_t nChunks = cuts.size() + 1;
+    std::vector<std::vector<float>> chunkPoints(nChunks);
+    std::vector<std::vector<size_t>> globalIndex(nChunks);
+    for (size_t i = 0; i < kPoints; ++i) {
+      size_t c = 0;
+      while (c < cuts.size() && double(points[i * NDim + kDim]) >= cuts[c]) {
+        ++c;
+      }
+      chunkPoints[c].insert(chunkPoints[c].end(), &points[i * NDim], &points[i * NDim] + NDim);
+      globalIndex[c].push_back(i);
+    }
+
+    std::vector<DBSCANResult> results(nChunks);
+    std::vector<BoundaryDescriptor<float>> descriptors;
+    for (size_t c = 0; c < nChunks; ++c) {
+      const size_t n = globalIndex[c].size();
+      const auto chunk = static_cast<int32_t>(c);
+      results[c] = dbscan.cluster(chunkPoints[c].data(), n);
+      if (c > 0) {
+        descriptors.push_back(dbscan.exportBoundary(chunkPoints[c].data(), n, results[c], chunk, StitchCut{kDim, cuts[c - 1]}));
+      }
+      if (c < cuts.size()) {
+        descriptors.push_back(dbscan.exportBoundary(chunkPoints[c].data(), n, results[c], chunk, StitchCut{kDim, cuts[c]}));
+      }
+    }
+    const StitchResult stitched = stitch<float>(descriptors, params);
+
+    std::vector<int64_t> labels(kPoints);
+    for (size_t c = 0; c < nChunks; ++c) {
+      const auto chunk = static_cast<int32_t>(c);
+      const auto remap = std::find_if(stitched.chunks.begin(), stitched.chunks.end(), [&](const StitchRemap& r) { return r.chunk == chunk; });
+      for (size_t k = 0; k < globalIndex[c].size(); ++k) {
+        const int32_t label = results[c].labels[k];
+        labels[globalIndex[c][k]] = remap != stitched.chunks.end() ? remap->globalId(k, label) : label < 0 ? label : globalClusterId(chunk, label);
+      }
+    }
+    const bool same = sameClustering(points.data(), kPoints, params, whole.labels, labels);
+    CHECK(same);
+    if (!same) {
+      std::cerr << "  " << nChunks << " chunks differ\n";
+    }
+  }
+
+  return finish("stitch_test");
+}
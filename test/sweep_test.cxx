@@ -0,0 +1,59 @@
+#include "dbscan_test_util.h"
+#include <algorithm>
+#include <numeric>
+
+using namespace dbscan;
+using namespace dbscan::test;
+
+// The sweep engines (the rolling grid, and sort and sweep in 1-D builds)
+// against the PointGraph engine, on more points than one sweep chunk holds
+// (16384) so the halo between chunks is crossed: with a sortedDim hint that
+// holds, with one that does not (the input must then be sorted, not trusted)
+// and with none
+int main()
+{
+  constexpr size_t kPoints = 24000;
+  const DBSCANParams params = makeParams(0.5f, 5, 2);
+  const std::vector<float> unsorted = makeBlobs(kPoints, 10, 1.5f, 40.0f, 17);
+
+  // The same points in ascending order along dimension 0
+  std::vector<size_t> order(kPoints);
+  std::iota(order.begin(), order.end(), size_t{0});
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return unsorted[a * NDim] < unsorted[b * NDim]; });
+  std::vector<float> sorted(unsorted.size());
+  for (size_t k = 0; k < kPoints; ++k) {
+    std::copy_n(&unsorted[order[k] * NDim], NDim, &sorted[k * NDim]);
+  }
+
+  struct Case {
+    const char* name;
+    const std::vector<float>* points;
+    int32_t sortedDim;
+  };
+  const Case cases[] = {
+    {"sorted, hint holds", &sorted, 0},
+    {"sorted, no hint", &sorted, -1},
+    {"unsorted, wrong hint", &unsorted, 0},
+    {"unsorted, no hint", &unsorted, -1},
+    {"sorted, hint out of range", &sorted, NDim},
+    {"sorted, wrong dimension", &sorted, NDim - 1}, // the same as the first case in 1-D builds
+  };
+  for (const Case& c : cases) {
+    const float* points = c.points->data();
+    const DBSCANResult reference = DBSCAN(params).cluster(points, kPoints);
+
+    DBSCANParams sweep = params;
+    sweep.engine = Engine::Sweep;
+    sweep.sortedDim = c.sortedDim;
+    const DBSCANResult result = DBSCAN(sweep).cluster(points, kPoints);
+
+    const int failures = gFailures;
+    CHECK(result.nClusters == reference.nClusters && result.nNoise == reference.nNoise);
+    CHECK(sameClustering(points, kPoints, params, reference.labels, result.labels));
+    if (gFailures != failures) {
+      std::cerr << "  case: " << c.name << '\n';
+    }
+  }
+
+  return finish("sweep_test");
+}
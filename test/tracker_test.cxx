@@ -0,0 +1,124 @@
+#include "DBSCAN/DBSCANTracker.h"
+#include "dbscan_test_util.h"
+#include <algorithm>
+
+using namespace dbscan;
+using namespace dbscan::test;
+
+namespace
+{
+// Points every 0.1 along dimension 0 over [x0, x1], the other coordinates 0;
+// returns the index of the first
+size_t addBar(std::vector<float>& points, float x0, float x1, float jitter = 0.0f)
+{
+  const size_t first = points.size() / NDim;
+  for (size_t k = 0; x0 + (0.1f * float(k)) <= x1 + 1e-4f; ++k) {
+    points.resize(points.size() + NDim, 0.0f);
+    points[points.size() - NDim] = x0 + (0.1f * float(k)) + (k % 2 == 0 ? jitter : -jitter);
+  }
+  return first;
+}
+
+size_t countEvents(const TrackedFrame& frame, TrackEventType type, int32_t track, int32_t other = -1)
+{
+  return static_cast<size_t>(std::count_if(frame.events.begin(), frame.events.end(), [&](const TrackEvent& event) {
+    return event.type == type && event.track == track && event.other == other;
+  }));
+}
+
+// Whether the points [first, end) all carry one id
+bool sameId(const TrackedFrame& frame, size_t first, size_t end)
+{
+  return std::all_of(frame.ids.begin() + static_cast<std::ptrdiff_t>(first), frame.ids.begin() + static_cast<std::ptrdiff_t>(end),
+                     [&](int32_t id) { return id >= 0 && id == frame.ids[first]; });
+}
+} // namespace
+
+// Stable ids and events of DBSCANTracker over constructed frames of bars
+// along dimension 0 (eps 0.3, cells of eps):
+//   1  bars A, B, C                      three births
+//   2  the same, jittered by 0.05        the same ids, no events
+//   3  A cut in two, new bar D           the larger part keeps A's id, the
+//                                        smaller splits off A; D is born
+//   4  B and C bridged, D gone           the bridge keeps B's id (more
+//                                        cells) and absorbs C; D dies
+int main()
+{
+  const DBSCANParams params = makeParams(0.3f, 3);
+  const DBSCAN dbscan(params);
+  DBSCANTrackerParams trackerParams{};
+  trackerParams.cellSizes.fill(0.3f);
+  DBSCANTracker tracker(trackerParams);
+  auto track = [&](const std::vector<float>& points) {
+    const size_t n = points.size() / NDim;
+    return tracker.update(points.data(), n, dbscan.cluster(points.data(), n));
+  };
+
+  // Frame 1
+  std::vector<float> points;
+  size_t a = addBar(points, 0.0f, 2.0f), b = addBar(points, 10.0f, 13.0f), c = addBar(points, 20.0f, 22.0f);
+  size_t end = points.size() / NDim;
+  TrackedFrame frame = track(points);
+  CHECK(frame.nClusters == 3);
+  CHECK(sameId(frame, a, b) && sameId(frame, b, c) && sameId(frame, c, end));
+  const int32_t idA = frame.ids[a], idB = frame.ids[b], idC = frame.ids[c];
+  CHECK(idA != idB && idB != idC && idA != idC);
+  CHECK(frame.events.size() == 3);
+  CHECK(countEvents(frame, TrackEventType::Birth, idA) == 1);
+  CHECK(countEvents(frame, TrackEventType::Birth, idB) == 1);
+  CHECK(countEvents(frame, TrackEventType::Birth, idC) == 1);
+
+  // Frame 2: jitter
+  points.clear();
+  a = addBar(points, 0.0f, 2.0f, 0.05f);
+  b = addBar(points, 10.0f, 13.0f, 0.05f);
+  c = addBar(points, 20.0f, 22.0f, 0.05f);
+  end = points.size() / NDim;
+  frame = track(points);
+  CHECK(frame.nClusters == 3);
+  CHECK(frame.ids[a] == idA && frame.ids[b] == idB && frame.ids[c] == idC);
+  CHECK(sameId(frame, a, b) && sameId(frame, b, c) && sameId(frame, c, end));
+  CHECK(frame.events.empty());
+
+  // Frame 3: split and birth
+  points.clear();
+  a = addBar(points, 0.0f, 1.1f);
+  const size_t a2 = addBar(points, 1.5f, 2.0f);
+  b = addBar(points, 10.0f, 13.0f);
+  c = addBar(points, 20.0f, 22.0f);
+  const size_t d = addBar(points, 30.0f, 31.0f);
+  end = points.size() / NDim;
+  frame = track(points);
+  CHECK(frame.nClusters == 5);
+  CHECK(sameId(frame, a, a2) && sameId(frame, a2, b) && sameId(frame, d, end));
+  CHECK(frame.ids[a] == idA && frame.ids[b] == idB && frame.ids[c] == idC);
+  const int32_t idA2 = frame.ids[a2], idD = frame.ids[d];
+  CHECK(idA2 != idA && idD != idA2 && idD != idA && idD != idB && idD != idC);
+  CHECK(frame.events.size() == 2);
+  CHECK(countEvents(frame, TrackEventType::Split, idA2, idA) == 1);
+  CHECK(countEvents(frame, TrackEventType::Birth, idD) == 1);
+
+  // Frame 4: merge and death
+  points.clear();
+  a = addBar(points, 0.0f, 1.1f);
+  addBar(points, 1.5f, 2.0f);
+  b = addBar(points, 10.0f, 22.0f);
+  end = points.size() / NDim;
+  frame = track(points);
+  CHECK(frame.nClusters == 3);
+  CHECK(sameId(frame, b, end));
+  CHECK(frame.ids[a] == idA && frame.ids[a2] == idA2 && frame.ids[b] == idB);
+  CHECK(frame.events.size() == 2);
+  CHECK(countEvents(frame, TrackEventType::Merge, idB, idC) == 1);
+  CHECK(countEvents(frame, TrackEventType::Death, idD) == 1);
+
+  // After reset() every cluster is a birth with a fresh id
+  tracker.reset();
+  frame = track(points);
+  CHECK(frame.events.size() == 3);
+  CHECK(std::all_of(frame.events.begin(), frame.events.end(), [&](const TrackEvent& event) {
+    return event.type == TrackEventType::Birth && event.track > idD;
+  }));
+
+  return finish("tracker_test");
+}
@@ -0,0 +1,105 @@
+#include "dbscan_test_util.h"
+#include <thread>
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+using namespace dbscan;
+using namespace dbscan::test;
+
+namespace
+{
+// CPUs this process may run on, and one it may not (-1 if unknown)
+std::pair<std::vector<int32_t>, int32_t> allowedCpus()
+{
+  std::vector<int32_t> allowed;
+  int32_t outside = -1;
+#if defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+    for (int32_t cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+      if (CPU_ISSET(static_cast<size_t>(cpu), &set)) {
+        allowed.push_back(cpu);
+      } else if (outside < 0) {
+        outside = cpu;
+      }
+    }
+  }
+#endif
+  if (allowed.empty()) {
+    allowed.push_back(0);
+  }
+  return {allowed, outside};
+}
+} // namespace
+
+// Pinned workers, spinning workers and the adaptive thread count change how
+// a call runs, never its result: each against the default engine over
+// inputs of several sizes (so the tuner sees several size classes, and
+// every call of a class while it climbs). A CPU outside the process's mask
+// is reported by pinningFailed() once a worker tried it (TBB on Linux, with
+// a second hardware thread for the worker).
+int main()
+{
+  std::vector<std::vector<float>> inputs;
+  for (unsigned k = 0; k < 4; ++k) {
+    inputs.push_back(makeBlobs(1000 * (1 + (3 * k)), 8, 1.0f, 30.0f, 61 + k));
+  }
+  const DBSCANParams base = makeParams(0.4f, 5, 2);
+  const DBSCAN reference(base);
+  std::vector<DBSCANResult> expected;
+  for (const auto& input : inputs) {
+    expected.push_back(reference.cluster(input.data(), input.size() / NDim));
+  }
+  auto matchesDefault = [&](const DBSCAN& dbscan, size_t rounds) {
+    bool same = true;
+    for (size_t round = 0; round < rounds; ++round) {
+      for (size_t k = 0; k < inputs.size(); ++k) {
+        same &= sameClusters(dbscan.cluster(inputs[k].data(), inputs[k].size() / NDim), expected[k]);
+      }
+    }
+    return same;
+  };
+
+  const auto [allowed, outside] = allowedCpus();
+
+  // Pinned to allowed CPUs, with and without spinning after each call
+  for (const int32_t spinMicros : {0, 200}) {
+    DBSCANParams params = base;
+    params.cpus.assign(allowed.begin(), allowed.begin() + static_cast<std::ptrdiff_t>(std::min<size_t>(2, allowed.size())));
+    params.spinMicros = spinMicros;
+    const DBSCAN dbscan(params);
+    CHECK(matchesDefault(dbscan, 2));
+    CHECK(!dbscan.pinningFailed());
+  }
+
+  // Adaptive degree: the model alone, and calibrated (a few rounds, so each
+  // size class probes more than one thread count)
+  for (const bool calibrate : {false, true}) {
+    DBSCANParams params = base;
+    params.nThreads = 0;
+    params.pointsPerThread = 2000;
+    params.calibrateParallelism = calibrate;
+    CHECK(matchesDefault(DBSCAN(params), calibrate ? 8 : 1));
+  }
+
+  // A CPU outside the mask for the worker: the result stands, the failure
+  // is reported
+  if (outside >= 0) {
+    DBSCANParams params = base;
+    params.cpus = {allowed.front(), outside};
+    const DBSCAN dbscan(params);
+    CHECK(matchesDefault(dbscan, 1));
+#if defined(DBSCAN_BACKEND_TBB) && defined(__linux__)
+    if (std::thread::hardware_concurrency() > 1) {
+      for (size_t call = 0; call < 100 && !dbscan.pinningFailed(); ++call) {
+        dbscan.cluster(inputs.back().data(), inputs.back().size() / NDim);
+      }
+      CHECK(dbscan.pinningFailed());
+    }
+#endif
+  }
+
+  return finish("tuning_test");
+}
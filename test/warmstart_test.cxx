@@ -0,0 +1,114 @@
+#include "DBSCAN/DBSCANWarmStart.h"
+#include "dbscan_test_util.h"
+#include <algorithm>
+
+using namespace dbscan;
+using namespace dbscan::test;
+
+// DBSCANWarmStart over many frames of jitter, insertions and removals must
+// give the clustering of a fresh cluster() after every update(): the same
+// clusters and counts, a border point between clusters in either. The point set
+// of a warm start is fixed, so a removed point is parked on a line outside
+// the data (spaced wider than eps, so noise) and an inserted one is taken
+// from there back next to a point of the data.
+int main()
+{
+  constexpr size_t kPoints = 4000;
+  constexpr size_t kSpots = 400;
+  constexpr float kExtent = 20.0f;
+  constexpr size_t kFrames = 60;
+  const DBSCANParams params = makeParams(0.3f, 5);
+
+  std::vector<float> points = makeBlobs(kPoints, 12, 0.4f, kExtent, 7);
+  constexpr size_t kInData = kSpots;
+  std::vector<size_t> spotOf(kPoints, kInData);
+  std::vector<size_t> parked, freeSpots;
+  auto park = [&](size_t i, size_t spot) {
+    spotOf[i] = spot;
+    parked.push_back(i);
+    points[i * NDim] = kExtent + 2.0f + float(spot);
+    for (size_t d = 1; d < NDim; ++d) {
+      points[i * NDim + d] = -2.0f;
+    }
+  };
+  // Half the spots taken from the start, so the grid covers the parking line
+  for (size_t spot = 0; spot < kSpots; ++spot) {
+    if (spot < kSpots / 2) {
+      park(spot * 7, spot);
+    } else {
+      freeSpots.push_back(spot);
+    }
+  }
+
+  DBSCANWarmStart<float> warm(params);
+  const DBSCAN reference(params);
+  auto matchesFresh = [&](const DBSCANResult& result) {
+    const DBSCANResult fresh = reference.cluster(points.data(), kPoints);
+    return result.nClusters == fresh.nClusters && result.nNoise == fresh.nNoise &&
+           sameClustering(points.data(), kPoints, params, result.labels, fresh.labels);
+  };
+  CHECK(matchesFresh(warm.cluster(points.data(), kPoints)));
+
+  std::mt19937 gen(11);
+  std::normal_distribution<float> jitter(0.0f, 0.05f);
+  std::uniform_int_distribution<size_t> anyPoint(0, kPoints - 1);
+  auto moveTo = [&](size_t i, const float* target) {
+    for (size_t d = 0; d < NDim; ++d) {
+      points[i * NDim + d] = std::clamp(target[d] + jitter(gen), 0.0f, kExtent);
+    }
+  };
+  for (size_t frame = 0; frame < kFrames; ++frame) {
+    std::vector<size_t> moved;
+    // Insert a few next to random points of the data
+    for (size_t k = 0; k < 8; ++k) {
+      const size_t near = anyPoint(gen);
+      if (parked.empty() || spotOf[near] != kInData) {
+        continue;
+      }
+      const size_t pick = std::uniform_int_distribution<size_t>(0, parked.size() - 1)(gen);
+      const size_t i = parked[pick];
+      parked[pick] = parked.back();
+      parked.pop_back();
+      freeSpots.push_back(spotOf[i]);
+      spotOf[i] = kInData;
+      moveTo(i, &points[near * NDim]);
+      moved.push_back(i);
+    }
+    // Remove a few
+    for (size_t k = 0; k < 8 && !freeSpots.empty(); ++k) {
+      const size_t i = anyPoint(gen);
+      if (spotOf[i] == kInData) {
+        park(i, freeSpots.back());
+        freeSpots.pop_back();
+        moved.push_back(i);
+      }
+    }
+    // Jitter about 2% of the points in the data
+    for (size_t k = 0; k < kPoints / 50; ++k) {
+      const size_t i = anyPoint(gen);
+      if (spotOf[i] == kInData) {
+        const std::vector<float> at(&points[i * NDim], &points[i * NDim] + NDim);
+        moveTo(i, at.data());
+        moved.push_back(i);
+      }
+    }
+
+    std::sort(moved.begin(), moved.end());
+    moved.erase(std::unique(moved.begin(), moved.end()), moved.end());
+    // Alternate between detecting the moved points and passing them
+    const DBSCANResult& result = frame % 2 == 0 ? warm.update(points.data()) : warm.update(points.data(), moved);
+    const bool same = matchesFresh(result);
+    CHECK(same);
+    if (!same) {
+      std::cerr << "  frame " << frame << " differs\n";
+    }
+  }
+
+  // More than a quarter moved: reclustered from scratch
+  for (size_t i = 0; i < kPoints; i += 2) {
+    points[i * NDim + NDim - 1] += 0.01f;
+  }
+  CHECK(matchesFresh(warm.update(points.data())));
+
+  return finish("warmstart_test");
+}